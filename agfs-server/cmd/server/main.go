@@ -276,6 +276,14 @@ func main() {
 	if cfg.ExternalPlugins.Enabled {
 		log.Info("Loading external plugins...")
 
+		if cfg.ExternalPlugins.WASMCacheDir != "" {
+			if err := mfs.GetPluginLoader().SetWASMCacheDir(cfg.ExternalPlugins.WASMCacheDir); err != nil {
+				log.Warnf("WASM module cache disabled: %v", err)
+			} else {
+				log.Infof("Caching compiled WASM modules in: %s", cfg.ExternalPlugins.WASMCacheDir)
+			}
+		}
+
 		// Auto-load from plugin directory
 		if cfg.ExternalPlugins.AutoLoad && cfg.ExternalPlugins.PluginDir != "" {
 			log.Infof("Auto-loading plugins from: %s", cfg.ExternalPlugins.PluginDir)
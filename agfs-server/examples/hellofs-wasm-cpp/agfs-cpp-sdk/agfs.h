@@ -11,6 +11,16 @@
 // - Easy-to-use FileSystem base class
 // - Host filesystem access via HostFS
 // - Automatic FFI handling
+// - Per-call arena allocator for scratch data
+// - ThreadPool for parallel work in threaded builds
+// - Binary FileInfo wire format negotiated with the host
+// - Per-operation counters and latency histograms with -DAGFS_METRICS
+// - Typed, validated config through ConfigSchema
+// - Checksum, hash and search kernels, vectorized with -msimd128
+// - CompressedFS for frame-compressed storage with range reads
+// - ChunkStore for content-defined, deduplicated storage
+// - MemTreeFS for indexed in-memory trees with pre-encoded metadata
+// - Background warm-up for state too slow to build in initialize()
 // - Simple export macro
 //
 // Example usage:
@@ -51,9 +61,20 @@
 //
 
 #include "agfs_types.h"
+#include "agfs_arena.h"
+#include "agfs_thread.h"
+#include "agfs_json.h"
+#include "agfs_simd.h"
 #include "agfs_ffi.h"
+#include "agfs_config.h"
+#include "agfs_metrics.h"
 #include "agfs_hostfs.h"
+#include "agfs_cache.h"
+#include "agfs_router.h"
 #include "agfs_filesystem.h"
+#include "agfs_compress.h"
+#include "agfs_chunks.h"
+#include "agfs_memtree.h"
 #include "agfs_export.h"
 
 #endif // AGFS_H
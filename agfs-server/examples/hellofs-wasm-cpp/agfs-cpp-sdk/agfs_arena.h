@@ -0,0 +1,314 @@
+#ifndef AGFS_ARENA_H
+#define AGFS_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace agfs {
+
+// Arena is a bump/region allocator for short-lived allocations.
+//
+// Memory is carved out of large blocks and never freed individually; reset()
+// releases everything at once, and rewind() everything allocated since a
+// mark(). The SDK keeps one arena per exported call (see call_arena()), which
+// is reset when the next export is entered, so anything allocated from it is
+// valid until the current call has returned to the host.
+class Arena {
+public:
+    static constexpr size_t kDefaultBlockSize = 16 * 1024;
+
+    explicit Arena(size_t block_size = kDefaultBlockSize)
+        : head_(nullptr), block_size_(block_size), used_(0), high_water_(0), blocks_(0) {}
+
+    ~Arena() {
+        release_blocks(nullptr);
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Allocate size bytes aligned to align (a power of two).
+    // Returns nullptr if the underlying allocation fails.
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        if (size == 0) {
+            size = 1; // Hand out distinct, non-null pointers
+        }
+
+        // Large requests get a dedicated block behind the head block, so the
+        // head keeps serving small allocations
+        if (size > block_size_ / 4) {
+            Block* block = new_block(size + align);
+            if (block == nullptr) {
+                return nullptr;
+            }
+            if (head_ != nullptr) {
+                block->next = head_->next;
+                head_->next = block;
+            } else {
+                head_ = block;
+            }
+            return bump(block, size, align);
+        }
+
+        if (head_ != nullptr) {
+            if (void* ptr = bump(head_, size, align)) {
+                return ptr;
+            }
+        }
+
+        Block* block = new_block(block_size_);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        block->next = head_;
+        head_ = block;
+        return bump(block, size, align);
+    }
+
+    // Copy a string into the arena as a NUL-terminated buffer
+    char* copy_string(const char* data, size_t len) {
+        char* buf = static_cast<char*>(allocate(len + 1, 1));
+        if (buf == nullptr) {
+            return nullptr;
+        }
+        if (len > 0) {
+            std::memcpy(buf, data, len);
+        }
+        buf[len] = '\0';
+        return buf;
+    }
+
+    // Copy a string into the arena behind a u32 length prefix (see
+    // ffi::read_view()). Returns a pointer to the NUL-terminated bytes.
+    char* copy_string_with_length(const char* data, size_t len) {
+        char* buf = static_cast<char*>(allocate(len + 5, 4));
+        if (buf == nullptr) {
+            return nullptr;
+        }
+        uint32_t prefix = (uint32_t)len;
+        std::memcpy(buf, &prefix, 4);
+        if (len > 0) {
+            std::memcpy(buf + 4, data, len);
+        }
+        buf[4 + len] = '\0';
+        return buf + 4;
+    }
+
+    // Copy a byte buffer into the arena
+    uint8_t* copy_bytes(const uint8_t* data, size_t len) {
+        uint8_t* buf = static_cast<uint8_t*>(allocate(len, 1));
+        if (buf != nullptr && len > 0) {
+            std::memcpy(buf, data, len);
+        }
+        return buf;
+    }
+
+    // Release every allocation. One default-sized block is kept for reuse so
+    // a steady stream of small calls never touches malloc.
+    void reset() {
+        Block* keep = nullptr;
+        for (Block* b = head_; b != nullptr; b = b->next) {
+            if (b->size == block_size_) {
+                keep = b;
+                break;
+            }
+        }
+        release_blocks(keep);
+        head_ = keep;
+        if (keep != nullptr) {
+            keep->next = nullptr;
+            keep->used = 0;
+        }
+        used_ = 0;
+    }
+
+    // Where the arena stood at a point in time, for rewind()
+    struct Mark {
+        uint64_t blocks;
+        size_t head_used;
+        size_t used;
+    };
+
+    Mark mark() const {
+        return Mark{blocks_, head_ != nullptr ? head_->used : 0, used_};
+    }
+
+    // Release everything allocated since m was taken; allocations made before
+    // it stay valid. Marks are rewound innermost first, and never across a
+    // reset().
+    void rewind(const Mark& m) {
+        // Blocks made since the mark sit ahead of the head block it saw, or
+        // right behind it, so unlinking them leaves that block at the head
+        Block** link = &head_;
+        while (*link != nullptr) {
+            Block* b = *link;
+            if (b->serial > m.blocks) {
+                *link = b->next;
+                std::free(b);
+            } else {
+                link = &b->next;
+            }
+        }
+        if (head_ != nullptr) {
+            head_->used = m.head_used;
+        }
+        used_ = m.used;
+    }
+
+    // Check whether ptr points into memory owned by this arena
+    bool owns(const void* ptr) const {
+        uintptr_t p = reinterpret_cast<uintptr_t>(ptr);
+        for (const Block* b = head_; b != nullptr; b = b->next) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(b->data());
+            if (p >= start && p < start + b->size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Bytes handed out since the last reset()
+    size_t used() const { return used_; }
+
+    // Largest used() observed over the arena's lifetime
+    size_t high_water() const { return high_water_; }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+        size_t used;
+        uint64_t serial; // Order of creation, for rewind()
+
+        uint8_t* data() { return reinterpret_cast<uint8_t*>(this + 1); }
+        const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+    };
+
+    Block* new_block(size_t size) {
+        Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + size));
+        if (block == nullptr) {
+            return nullptr;
+        }
+        block->next = nullptr;
+        block->size = size;
+        block->used = 0;
+        block->serial = ++blocks_;
+        return block;
+    }
+
+    void* bump(Block* block, size_t size, size_t align) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(block->data());
+        uintptr_t cur = base + block->used;
+        uintptr_t aligned = (cur + align - 1) & ~(uintptr_t)(align - 1);
+        if (aligned + size > base + block->size) {
+            return nullptr;
+        }
+        block->used = aligned + size - base;
+        used_ += size;
+        if (used_ > high_water_) {
+            high_water_ = used_;
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Free every block except keep
+    void release_blocks(Block* keep) {
+        Block* b = head_;
+        while (b != nullptr) {
+            Block* next = b->next;
+            if (b != keep) {
+                std::free(b);
+            }
+            b = next;
+        }
+        head_ = nullptr;
+    }
+
+    Block* head_;
+    size_t block_size_;
+    size_t used_;
+    size_t high_water_;
+    uint64_t blocks_; // Blocks made so far
+};
+
+// STL allocator backed by an Arena. deallocate() is a no-op; memory comes back
+// when the arena is reset, so containers using it must not outlive the call.
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena& arena) noexcept : arena_(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        (void)ptr; (void)n; // released by Arena::reset()
+    }
+
+    Arena* arena() const noexcept { return arena_; }
+
+private:
+    Arena* arena_;
+};
+
+template<typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+    return a.arena() == b.arena();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+    return a.arena() != b.arena();
+}
+
+// Per-call containers for scratch data that dies when the export returns
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+// The arena reset on entry to every exported call. Threaded builds
+// (AGFS_THREADS) give every thread its own, so ThreadPool workers never share
+// the arena of the call they run for.
+inline Arena& call_arena() {
+#if defined(AGFS_THREADS)
+    static thread_local Arena arena;
+#else
+    static Arena arena;
+#endif
+    return arena;
+}
+
+// Gives back everything allocated from an arena while the scope was open,
+// for code that copies its scratch data out before returning:
+//
+//   {
+//       ArenaScope scratch;
+//       char* tmp = static_cast<char*>(call_arena().allocate(len));
+//       ... // copy what is needed out of tmp
+//   } // tmp is released here
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena = call_arena()) : arena_(arena), mark_(arena.mark()) {}
+    ~ArenaScope() { arena_.rewind(mark_); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena& arena_;
+    Arena::Mark mark_;
+};
+
+} // namespace agfs
+
+#endif // AGFS_ARENA_H
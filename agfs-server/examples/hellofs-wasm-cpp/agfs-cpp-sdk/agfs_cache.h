@@ -0,0 +1,829 @@
+#ifndef AGFS_CACHE_H
+#define AGFS_CACHE_H
+
+#include "agfs_types.h"
+#include "agfs_config.h"
+#include "agfs_hostfs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <list>
+#include <map>
+#include <unordered_map>
+
+namespace agfs {
+
+// Bounded least-recently-used map. get() refreshes an entry; inserting past
+// capacity evicts the oldest one.
+template<typename K, typename V>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+    // Pointer to the cached value, or nullptr
+    V* get(const K& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &it->second->second;
+    }
+
+    void put(const K& key, V value) {
+        if (capacity_ == 0) {
+            return;
+        }
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            it->second->second = std::move(value);
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return;
+        }
+        entries_.emplace_front(key, std::move(value));
+        index_[key] = entries_.begin();
+        while (index_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+    void erase(const K& key) {
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            entries_.erase(it->second);
+            index_.erase(it);
+        }
+    }
+
+    // Erase every entry whose key satisfies pred
+    template<typename Pred>
+    void erase_if(Pred&& pred) {
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            if (pred(it->first)) {
+                index_.erase(it->first);
+                it = entries_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void clear() {
+        entries_.clear();
+        index_.clear();
+    }
+
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return capacity_; }
+
+    void set_capacity(size_t capacity) {
+        capacity_ = capacity;
+        while (index_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+private:
+    using Entry = std::pair<K, V>;
+
+    size_t capacity_;
+    std::list<Entry> entries_;
+    std::unordered_map<K, typename std::list<Entry>::iterator> index_;
+};
+
+// CachedHostFS is an optional caching layer over HostFS.
+//
+// stat() and readdir() results are kept in LRU caches for a short TTL, so
+// repeated metadata lookups (shells running `ls -l`, a stat per request) are
+// answered without crossing into the host. A readdir() also primes the stat
+// cache with its entries. Changes made through this object invalidate the
+// affected entries; changes made on the host by anyone else become visible
+// once the TTL expires.
+//
+// read() and read_into() go through a page cache of fixed-size blocks with
+// adaptive read-ahead: a reader that keeps continuing where its last read
+// ended gets a read-ahead window that doubles up to a limit, and runs of
+// missing blocks are fetched with a single host read. Small sequential reads
+// are then mostly served from the cache. Cached blocks follow the same TTL
+// and invalidation as metadata, and their total size is capped.
+//
+// Writes can optionally be buffered (write-behind): write() and append() then
+// collect data per path and send it in one host write once enough bytes or
+// time have accumulated, on flush(), or before anything else touches the
+// path. Buffered data lives only in this instance, so enable it only in
+// plugins that report Concurrency::Exclusive, and call flush() from
+// shutdown().
+//
+// Unlike HostFS, CachedHostFS holds state, so keep one per plugin (for
+// example as a member) and call configure() from initialize().
+class CachedHostFS {
+public:
+    struct Options {
+        size_t stat_entries = 1024; // Cached stat results
+        size_t dir_entries = 64;    // Cached directory listings
+        int64_t ttl_ms = 1000;      // Lifetime of a cached entry; 0 disables caching
+        size_t block_size = 64 * 1024;        // Page cache block size
+        size_t max_bytes = 4 * 1024 * 1024;   // Page cache budget; 0 disables it
+        size_t readahead_max = 1024 * 1024;   // Largest read-ahead window
+        size_t writeback_bytes = 0;           // Buffer writes up to this many bytes per path; 0 writes through
+        int64_t writeback_ms = 1000;          // Longest a buffered write waits
+    };
+
+    CachedHostFS() : CachedHostFS(Options()) {}
+
+    explicit CachedHostFS(const Options& options)
+        : options_(options), stats_(options.stat_entries), dirs_(options.dir_entries),
+          blocks_(block_capacity(options)), streams_(kMaxStreams) {}
+
+    // The cache settings in plugin config; keys missing from it keep the
+    // current options
+    static const ConfigSchema<Options>& options_schema() {
+        static const auto schema = ConfigSchema<Options>()
+            .field("host_cache_stat_entries", &Options::stat_entries)
+            .field("host_cache_dir_entries", &Options::dir_entries)
+            .field("host_cache_ttl_ms", &Options::ttl_ms, 0)
+            .field("host_cache_block_size", &Options::block_size, 1)
+            .field("host_cache_max_bytes", &Options::max_bytes)
+            .field("host_cache_readahead_max", &Options::readahead_max)
+            .field("host_cache_writeback_bytes", &Options::writeback_bytes)
+            .field("host_cache_writeback_ms", &Options::writeback_ms, 0);
+        return schema;
+    }
+
+    // Read cache settings from plugin config (see options_schema()). Invalid
+    // values fail the whole call and leave the options unchanged.
+    Result<void> configure(const Config& config) {
+        auto parsed = options_schema().parse(config, options_);
+        if (parsed.is_err()) {
+            return parsed.unwrap_err();
+        }
+        options_ = parsed.unwrap();
+        stats_.set_capacity(options_.stat_entries);
+        dirs_.set_capacity(options_.dir_entries);
+        blocks_.clear(); // Cached blocks depend on the block size
+        blocks_.set_capacity(block_capacity(options_));
+        streams_.clear();
+        return Result<void>();
+    }
+
+    const Options& options() const { return options_; }
+
+    Result<FileInfo> stat(const std::string& path) {
+        auto settled = settle(path);
+        if (settled.is_err()) {
+            return settled.unwrap_err();
+        }
+        if (auto* cached = stats_.get(path)) {
+            if (fresh(cached->expires)) {
+                return cached->value;
+            }
+            stats_.erase(path);
+        }
+
+        auto result = HostFS::stat(path);
+        if (result.is_ok() && caching()) {
+            stats_.put(path, {result.unwrap(), expiry()});
+        }
+        return result;
+    }
+
+    // Stat many paths, sending only the ones not cached to the host in a
+    // single batch
+    std::vector<Result<FileInfo>> stat_many(const std::vector<std::string>& paths) {
+        // Each path keeps either its cached value or its slot in misses, so
+        // evictions and expiries while the batch runs cannot shift results
+        constexpr size_t kCached = (size_t)-1;
+        std::vector<FileInfo> hits(paths.size());
+        std::vector<size_t> slots(paths.size(), kCached);
+        std::vector<std::string> misses;
+        std::unordered_map<std::string, size_t> missed; // Path -> slot in misses
+        for (size_t i = 0; i < paths.size(); i++) {
+            const auto& path = paths[i];
+            defer(settle(path)); // A failed flush surfaces through flush()
+            auto* cached = stats_.get(path);
+            if (cached != nullptr && fresh(cached->expires)) {
+                hits[i] = cached->value;
+                continue;
+            }
+            auto inserted = missed.emplace(path, misses.size());
+            if (inserted.second) {
+                misses.push_back(path);
+            }
+            slots[i] = inserted.first->second;
+        }
+
+        auto fetched = HostFS::stat_many(misses);
+        for (size_t i = 0; i < misses.size() && i < fetched.size(); i++) {
+            if (fetched[i].is_ok() && caching()) {
+                stats_.put(misses[i], {fetched[i].unwrap(), expiry()});
+            }
+        }
+
+        std::vector<Result<FileInfo>> results;
+        results.reserve(paths.size());
+        for (size_t i = 0; i < paths.size(); i++) {
+            if (slots[i] == kCached) {
+                results.push_back(std::move(hits[i]));
+            } else if (slots[i] < fetched.size()) {
+                results.push_back(fetched[slots[i]]);
+            } else {
+                results.push_back(Error::io("missing batch result"));
+            }
+        }
+        return results;
+    }
+
+    Result<std::vector<FileInfo>> readdir(const std::string& path) {
+        auto settled = settle_children(path);
+        if (settled.is_err()) {
+            return settled.unwrap_err();
+        }
+        if (auto* cached = dirs_.get(path)) {
+            if (fresh(cached->expires)) {
+                return cached->value;
+            }
+            dirs_.erase(path);
+        }
+
+        auto result = HostFS::readdir(path);
+        if (result.is_ok() && caching()) {
+            auto expires = expiry();
+            for (const auto& entry : result.unwrap()) {
+                stats_.put(join_path(path, entry.name), {entry, expires});
+            }
+            dirs_.put(path, {result.unwrap(), expires});
+        }
+        return result;
+    }
+
+    // One page of a host listing (see HostFS::readdir_page), after sending
+    // buffered writes to the directory's entries. Pages are not cached.
+    Result<DirPage> readdir_page(const std::string& path, std::string_view cursor,
+                                 size_t max_entries = kDirPageSize) {
+        auto settled = settle_children(path);
+        if (settled.is_err()) {
+            return settled.unwrap_err();
+        }
+        return HostFS::readdir_page(path, cursor, max_entries);
+    }
+
+    // Open a host file for streaming (see HostFS::open) once buffered writes
+    // to it are sent. Chunks written through the handle bypass this object,
+    // so opening for writing also drops what is cached of the file.
+    Result<FileHandle> open(const std::string& path, uint32_t flags) {
+        auto settled = settle(path);
+        if (settled.is_err()) {
+            return settled.unwrap_err();
+        }
+        if (flags & OpenWrite) {
+            invalidate(path);
+        }
+        return HostFS::open(path, flags);
+    }
+
+    Result<std::vector<uint8_t>> read(const std::string& path, int64_t offset, int64_t size) {
+        auto settled = settle(path);
+        if (settled.is_err()) {
+            return settled.unwrap_err();
+        }
+        if (!cacheable(offset, size)) {
+            return HostFS::read(path, offset, size);
+        }
+        std::vector<uint8_t> data;
+        data.reserve((size_t)size);
+        auto result = read_blocks(path, offset, (size_t)size, [&data](const uint8_t* p, size_t n) {
+            data.insert(data.end(), p, p + n);
+        });
+        if (result.is_err()) {
+            return result.unwrap_err();
+        }
+        return data;
+    }
+
+    Result<size_t> read_into(const std::string& path, int64_t offset, Span<uint8_t> out) {
+        auto settled = settle(path);
+        if (settled.is_err()) {
+            return settled.unwrap_err();
+        }
+        if (!cacheable(offset, (int64_t)out.size())) {
+            return HostFS::read_into(path, offset, out);
+        }
+        size_t copied = 0;
+        auto result = read_blocks(path, offset, out.size(), [&out, &copied](const uint8_t* p, size_t n) {
+            memcpy(out.data() + copied, p, n);
+            copied += n;
+        });
+        if (result.is_err()) {
+            return result.unwrap_err();
+        }
+        return copied;
+    }
+
+    // Replace the file's contents. With write-behind the data is buffered and
+    // the response is empty; a later write to the same path replaces it.
+    Result<std::vector<uint8_t>> write(const std::string& path, Span<const uint8_t> data) {
+        invalidate_entry(path);
+        if (!buffering()) {
+            return HostFS::write(path, data);
+        }
+
+        flush_expired();
+        Pending& pending = buffer(path);
+        pending.data.assign(data.begin(), data.end());
+        pending.dirty += data.size();
+        auto flushed = flush_if_full(path);
+        if (flushed.is_err()) {
+            return flushed.unwrap_err();
+        }
+        return std::vector<uint8_t>();
+    }
+
+    // Add data to the end of the file. The host only replaces whole files,
+    // so the current contents are read once and later appends are collected
+    // on top of them until the buffer is flushed.
+    Result<void> append(const std::string& path, Span<const uint8_t> data) {
+        invalidate_entry(path);
+        if (buffering()) {
+            flush_expired();
+        }
+
+        auto it = pending_.find(path);
+        if (it == pending_.end()) {
+            auto current = load(path);
+            if (current.is_err()) {
+                return current.unwrap_err();
+            }
+            if (!buffering()) {
+                auto& contents = current.unwrap();
+                contents.insert(contents.end(), data.begin(), data.end());
+                auto written = HostFS::write(path, contents);
+                if (written.is_err()) {
+                    return written.unwrap_err();
+                }
+                return Result<void>();
+            }
+            buffer(path).data = std::move(current.unwrap());
+            it = pending_.find(path);
+        }
+        it->second.data.insert(it->second.data.end(), data.begin(), data.end());
+        it->second.dirty += data.size();
+        return flush_if_full(path);
+    }
+
+    // Send buffered writes for path to the host
+    Result<void> flush(const std::string& path) {
+        auto it = pending_.find(path);
+        if (it == pending_.end()) {
+            return Result<void>();
+        }
+        return flush_entry(it);
+    }
+
+    // Send every buffered write to the host. Also reports a failure from a
+    // flush that happened along the way since the last call, like fsync.
+    Result<void> flush() {
+        Result<void> result = take_deferred();
+        while (!pending_.empty()) {
+            auto flushed = flush_entry(pending_.begin());
+            if (flushed.is_err() && result.is_ok()) {
+                result = flushed;
+            }
+        }
+        return result;
+    }
+
+    Result<void> create(const std::string& path) {
+        auto settled = settle(path);
+        if (settled.is_err()) {
+            return settled;
+        }
+        invalidate_entry(path);
+        return HostFS::create(path);
+    }
+
+    Result<void> mkdir(const std::string& path, uint32_t perm) {
+        auto settled = settle(path);
+        if (settled.is_err()) {
+            return settled;
+        }
+        invalidate_entry(path);
+        return HostFS::mkdir(path, perm);
+    }
+
+    Result<void> remove(const std::string& path) {
+        auto settled = settle_tree(path);
+        if (settled.is_err()) {
+            return settled;
+        }
+        invalidate_tree(path);
+        return HostFS::remove(path);
+    }
+
+    Result<void> remove_all(const std::string& path) {
+        auto settled = settle_tree(path);
+        if (settled.is_err()) {
+            return settled;
+        }
+        invalidate_tree(path);
+        return HostFS::remove_all(path);
+    }
+
+    Result<void> rename(const std::string& old_path, const std::string& new_path) {
+        auto settled = settle_tree(old_path);
+        if (settled.is_ok()) {
+            settled = settle_tree(new_path);
+        }
+        if (settled.is_err()) {
+            return settled;
+        }
+        invalidate_tree(old_path);
+        invalidate_tree(new_path);
+        return HostFS::rename(old_path, new_path);
+    }
+
+    Result<void> chmod(const std::string& path, uint32_t mode) {
+        auto settled = settle(path);
+        if (settled.is_err()) {
+            return settled;
+        }
+        invalidate_entry(path);
+        return HostFS::chmod(path, mode);
+    }
+
+    // Copy on the host; src's buffered writes are flushed first so the host
+    // copies what this object has written
+    Result<uint64_t> copy(const std::string& src, const std::string& dst,
+                          int64_t offset = 0, int64_t size = -1) {
+        auto settled = settle(src);
+        if (settled.is_ok()) {
+            settled = settle(dst);
+        }
+        if (settled.is_err()) {
+            return settled.unwrap_err();
+        }
+        invalidate_entry(dst);
+        return HostFS::copy(src, dst, offset, size);
+    }
+
+    // Drop what is cached for path, its listing and its parent's listing
+    void invalidate(const std::string& path) {
+        invalidate_entry(path);
+        dirs_.erase(path);
+    }
+
+    // Drop everything cached; buffered writes are kept
+    void clear() {
+        stats_.clear();
+        dirs_.clear();
+        blocks_.clear();
+        streams_.clear();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Sequential read tracking is kept for this many recently read files
+    static constexpr size_t kMaxStreams = 64;
+
+    // At most this many paths hold buffered writes; the oldest is flushed first
+    static constexpr size_t kMaxPending = 64;
+
+    struct Pending {
+        std::vector<uint8_t> data;  // Full contents to write
+        size_t dirty = 0;           // Bytes written or appended since buffering began
+        Clock::time_point since;
+    };
+
+    struct ReadStream {
+        int64_t next = 0;   // Offset a sequential reader asks for next
+        size_t window = 0;  // Current read-ahead in bytes
+    };
+
+    static size_t block_capacity(const Options& options) {
+        return options.block_size == 0 ? 0 : options.max_bytes / options.block_size;
+    }
+
+    template<typename V>
+    struct Cached {
+        V value;
+        Clock::time_point expires;
+    };
+
+    bool caching() const { return options_.ttl_ms > 0; }
+
+    bool buffering() const { return options_.writeback_bytes > 0; }
+
+    // Whether key is path itself or lies below it
+    static bool within(const std::string& path, const std::string& key) {
+        return key == path ||
+               (key.size() > path.size() && key.compare(0, path.size(), path) == 0 &&
+                key[path.size()] == '/');
+    }
+
+    // Current contents of a file, or nothing if it does not exist. Any other
+    // failure is passed on, as appending to a file that could not be read
+    // would replace it. Hosts before kAbiErrorCodes send no kinds, so every
+    // stat failure is taken as missing there.
+    static Result<std::vector<uint8_t>> load(const std::string& path) {
+        auto info = HostFS::stat(path);
+        if (info.is_err()) {
+            const Error& err = info.unwrap_err();
+            if (err.kind == ErrorKind::NotFound || !ffi::error_codes()) {
+                return std::vector<uint8_t>();
+            }
+            return err;
+        }
+        return HostFS::read(path, 0, -1);
+    }
+
+    // The write-behind entry for path, created on first use
+    Pending& buffer(const std::string& path) {
+        auto it = pending_.find(path);
+        if (it != pending_.end()) {
+            return it->second;
+        }
+        if (pending_.size() >= kMaxPending) {
+            auto oldest = pending_.begin();
+            for (auto p = pending_.begin(); p != pending_.end(); ++p) {
+                if (p->second.since < oldest->second.since) {
+                    oldest = p;
+                }
+            }
+            defer(flush_entry(oldest));
+        }
+        Pending& pending = pending_[path];
+        pending.since = Clock::now();
+        return pending;
+    }
+
+    Result<void> flush_entry(std::map<std::string, Pending>::iterator it) {
+        std::string path = it->first;
+        std::vector<uint8_t> data = std::move(it->second.data);
+        pending_.erase(it);
+        invalidate_entry(path);
+        auto written = HostFS::write(path, data);
+        if (written.is_err()) {
+            return written.unwrap_err();
+        }
+        return Result<void>();
+    }
+
+    Result<void> flush_if_full(const std::string& path) {
+        auto it = pending_.find(path);
+        if (it == pending_.end() || it->second.dirty < options_.writeback_bytes) {
+            return Result<void>();
+        }
+        return flush_entry(it);
+    }
+
+    // Flush buffers that have waited longer than writeback_ms. Failures are
+    // reported by the next flush().
+    void flush_expired() {
+        auto deadline = Clock::now() - std::chrono::milliseconds(options_.writeback_ms);
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            auto next = std::next(it);
+            if (it->second.since <= deadline) {
+                defer(flush_entry(it));
+            }
+            it = next;
+        }
+    }
+
+    // Flush buffered writes matching pred before another operation uses them
+    template<typename Pred>
+    Result<void> settle_if(Pred&& pred) {
+        if (pending_.empty()) {
+            return Result<void>();
+        }
+        flush_expired();
+        Result<void> result;
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            auto next = std::next(it);
+            if (pred(it->first)) {
+                auto flushed = flush_entry(it);
+                if (flushed.is_err() && result.is_ok()) {
+                    result = flushed;
+                }
+            }
+            it = next;
+        }
+        return result;
+    }
+
+    Result<void> settle(const std::string& path) {
+        return settle_if([&path](const std::string& key) { return key == path; });
+    }
+
+    Result<void> settle_tree(const std::string& path) {
+        return settle_if([&path](const std::string& key) { return within(path, key); });
+    }
+
+    Result<void> settle_children(const std::string& dir) {
+        return settle_if([&dir](const std::string& key) { return parent(key) == dir; });
+    }
+
+    void defer(const Result<void>& result) {
+        if (result.is_err() && deferred_.is_ok()) {
+            deferred_ = result;
+        }
+    }
+
+    Result<void> take_deferred() {
+        Result<void> result = deferred_;
+        deferred_ = Result<void>();
+        return result;
+    }
+
+    Clock::time_point expiry() const {
+        return Clock::now() + std::chrono::milliseconds(options_.ttl_ms);
+    }
+
+    static bool fresh(Clock::time_point expires) {
+        return Clock::now() < expires;
+    }
+
+    static std::string parent(const std::string& path) {
+        size_t slash = path.find_last_of('/');
+        if (slash == std::string::npos || slash == 0) {
+            return "/";
+        }
+        return path.substr(0, slash);
+    }
+
+    // Page cache keys: the path, a NUL, then the block index
+    static std::string block_key(const std::string& path, int64_t index) {
+        std::string key = path;
+        key.push_back('\0');
+        key += std::to_string(index);
+        return key;
+    }
+
+    static std::string block_path(const std::string& key) {
+        return key.substr(0, key.find('\0'));
+    }
+
+    // Offsets and sizes the page cache can serve; anything else goes to the host
+    bool cacheable(int64_t offset, int64_t size) const {
+        if (!caching() || blocks_.capacity() == 0 || offset < 0 || size <= 0) {
+            return false;
+        }
+        // Every block a read touches must fit in the cache at once
+        size_t spanned = ((size_t)size + 2 * options_.block_size - 2) / options_.block_size;
+        return spanned <= blocks_.capacity();
+    }
+
+    // Read-ahead in bytes for a read at offset, growing while reads stay sequential
+    size_t readahead(const std::string& path, int64_t offset, size_t size) {
+        ReadStream* stream = streams_.get(path);
+        if (stream == nullptr) {
+            streams_.put(path, ReadStream());
+            stream = streams_.get(path);
+        }
+        if (offset == stream->next) {
+            size_t grown = stream->window == 0 ? options_.block_size : stream->window * 2;
+            stream->window = std::min(grown, options_.readahead_max);
+        } else {
+            stream->window = 0;
+        }
+        stream->next = offset + (int64_t)size;
+
+        // Keep the whole read plus read-ahead within the cache
+        size_t room = blocks_.capacity() * options_.block_size;
+        size_t needed = size + 2 * options_.block_size;
+        return needed >= room ? 0 : std::min(stream->window, room - needed);
+    }
+
+    const std::vector<uint8_t>* cached_block(const std::string& path, int64_t index) {
+        auto* cached = blocks_.get(block_key(path, index));
+        if (cached == nullptr) {
+            return nullptr;
+        }
+        if (!fresh(cached->expires)) {
+            blocks_.erase(block_key(path, index));
+            return nullptr;
+        }
+        return &cached->value;
+    }
+
+    // Fetch blocks [first, last] with one host read. Returns false once the
+    // end of the file was reached.
+    Result<bool> fetch_blocks(const std::string& path, int64_t first, int64_t last) {
+        int64_t bs = (int64_t)options_.block_size;
+        auto result = HostFS::read(path, first * bs, (last - first + 1) * bs);
+        if (result.is_err()) {
+            return result.unwrap_err();
+        }
+
+        const auto& data = result.unwrap();
+        auto expires = expiry();
+        for (int64_t index = first; index <= last; index++) {
+            size_t start = (size_t)((index - first) * bs);
+            if (start >= data.size()) {
+                return false;
+            }
+            size_t n = std::min((size_t)bs, data.size() - start);
+            blocks_.put(block_key(path, index),
+                        {std::vector<uint8_t>(data.begin() + start, data.begin() + start + n), expires});
+            if (n < (size_t)bs) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Serve [offset, offset + size) from the page cache, fetching runs of
+    // missing blocks (plus read-ahead) first. sink gets the data in order.
+    template<typename Sink>
+    Result<void> read_blocks(const std::string& path, int64_t offset, size_t size, Sink&& sink) {
+        int64_t bs = (int64_t)options_.block_size;
+        int64_t end = offset + (int64_t)size;
+        int64_t first = offset / bs;
+        int64_t needed_last = (end - 1) / bs;
+        int64_t last = (end + (int64_t)readahead(path, offset, size) - 1) / bs;
+
+        // While the block after this read is still cached (or the file ends
+        // first), the previous read-ahead has not been used up; refill it
+        // once it is
+        bool hit = true;
+        for (int64_t index = first; index <= needed_last + 1 && hit; index++) {
+            const std::vector<uint8_t>* block = cached_block(path, index);
+            hit = index > last || block != nullptr;
+            if (block != nullptr && block->size() < (size_t)bs) {
+                break; // End of file
+            }
+        }
+
+        for (int64_t index = first; index <= last && !hit;) {
+            if (cached_block(path, index) != nullptr) {
+                index++;
+                continue;
+            }
+            int64_t run = index;
+            while (index <= last && cached_block(path, index) == nullptr) {
+                index++;
+            }
+            auto fetched = fetch_blocks(path, run, index - 1);
+            if (fetched.is_err()) {
+                if (run <= needed_last) {
+                    return fetched.unwrap_err();
+                }
+                break; // Only read-ahead failed
+            }
+            if (!fetched.unwrap()) {
+                break; // End of file
+            }
+        }
+
+        int64_t pos = offset;
+        for (int64_t index = first; index <= needed_last; index++) {
+            const std::vector<uint8_t>* block = cached_block(path, index);
+            size_t within = (size_t)(pos - index * bs);
+            if (block == nullptr || within >= block->size()) {
+                break; // End of file
+            }
+            size_t n = std::min(block->size() - within, (size_t)(end - pos));
+            sink(block->data() + within, n);
+            pos += (int64_t)n;
+            if (block->size() < (size_t)bs) {
+                break;
+            }
+        }
+        return Result<void>();
+    }
+
+    // A single file or directory changed: its stat, data and parent's listing
+    void invalidate_entry(const std::string& path) {
+        stats_.erase(path);
+        dirs_.erase(parent(path));
+        std::string prefix = block_key(path, 0);
+        prefix.pop_back(); // Keep the NUL separator, drop the index
+        blocks_.erase_if([&prefix](const std::string& key) {
+            return key.compare(0, prefix.size(), prefix) == 0;
+        });
+        streams_.erase(path);
+    }
+
+    // A path and everything below it changed
+    void invalidate_tree(const std::string& path) {
+        invalidate_entry(path);
+        auto under = [&path](const std::string& key) { return within(path, key); };
+        stats_.erase_if(under);
+        dirs_.erase_if(under);
+        blocks_.erase_if([&under](const std::string& key) { return under(block_path(key)); });
+        streams_.erase_if(under);
+    }
+
+    Options options_;
+    LruCache<std::string, Cached<FileInfo>> stats_;
+    LruCache<std::string, Cached<std::vector<FileInfo>>> dirs_;
+    LruCache<std::string, Cached<std::vector<uint8_t>>> blocks_;
+    LruCache<std::string, ReadStream> streams_;
+    std::map<std::string, Pending> pending_;
+    Result<void> deferred_; // First failed background flush, see flush()
+};
+
+} // namespace agfs
+
+#endif // AGFS_CACHE_H
@@ -0,0 +1,564 @@
+#ifndef AGFS_CHUNKS_H
+#define AGFS_CHUNKS_H
+
+#include "agfs_types.h"
+#include "agfs_config.h"
+#include "agfs_wire.h"
+#include "agfs_simd.h"
+#include "agfs_hostfs.h"
+#include "agfs_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_set>
+
+namespace agfs {
+namespace cdc {
+
+// Content-defined chunking with FastCDC: a gear rolling hash picks cut
+// points from the data itself, so an edit only changes the chunks around it
+// and the rest of a file splits exactly as before. Normalized chunking uses a
+// stricter mask before the average size and a looser one after it, which
+// keeps chunk sizes close to the average.
+
+namespace internal {
+
+// Gear hash table, 256 pseudo-random words from splitmix64
+struct GearTable {
+    uint64_t t[256];
+
+    constexpr GearTable() : t() {
+        uint64_t state = 0;
+        for (int i = 0; i < 256; i++) {
+            state += 0x9E3779B97F4A7C15ull;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            t[i] = z ^ (z >> 31);
+        }
+    }
+};
+
+inline constexpr GearTable kGear{};
+
+// A mask of the top bits of the gear hash, which depend on the last 64 bytes
+inline uint64_t top_bits(int bits) {
+    return bits <= 0 ? 0 : ~0ull << (64 - std::min(bits, 63));
+}
+
+inline int log2_floor(size_t v) {
+    int bits = 0;
+    while (v > 1) {
+        v >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+} // namespace internal
+
+// Length of the first chunk of data, between min_size and max_size (or all
+// of data if shorter), aiming at avg_size
+inline size_t cut(Span<const uint8_t> data, size_t min_size, size_t avg_size, size_t max_size) {
+    size_t n = data.size();
+    if (n <= min_size) {
+        return n;
+    }
+    if (n > max_size) {
+        n = max_size;
+    }
+    size_t normal = std::min(avg_size, n);
+    int bits = internal::log2_floor(avg_size);
+    uint64_t strict = internal::top_bits(bits + 2);
+    uint64_t loose = internal::top_bits(bits - 2);
+
+    const uint8_t* p = data.data();
+    uint64_t hash = 0;
+    size_t i = min_size;
+    for (; i < normal; i++) {
+        hash = (hash << 1) + internal::kGear.t[p[i]];
+        if ((hash & strict) == 0) {
+            return i + 1;
+        }
+    }
+    for (; i < n; i++) {
+        hash = (hash << 1) + internal::kGear.t[p[i]];
+        if ((hash & loose) == 0) {
+            return i + 1;
+        }
+    }
+    return n;
+}
+
+// Lengths of the chunks data splits into, in order
+inline std::vector<size_t> split(Span<const uint8_t> data, size_t min_size, size_t avg_size, size_t max_size) {
+    std::vector<size_t> lengths;
+    size_t at = 0;
+    while (at < data.size()) {
+        size_t len = cut(data.subspan(at, data.size() - at), min_size, avg_size, max_size);
+        lengths.push_back(len);
+        at += len;
+    }
+    return lengths;
+}
+
+} // namespace cdc
+
+// ChunkStore deduplicates files by content through HostFS.
+//
+// write() splits a file into content-defined chunks (see agfs::cdc), stores
+// each chunk once under the chunk directory, named by its 128-bit hash, and
+// writes a manifest listing the file's chunks at the file's own path. Files
+// that share content share chunks, so a new version of a file that differs
+// by a few lines writes only the chunks around the change. Before writing a
+// chunk, the store checks which chunks exist with a single stat_many() call.
+//
+// read() fetches only the chunks overlapping [offset, offset + size), in one
+// read_many() call, and keeps recently read chunks in an LRU cache; chunks
+// never change, so cached ones are always valid. Manifests are cached for a
+// short TTL like CachedHostFS entries. Paths without a manifest are passed
+// through to HostFS unchanged, and stat() reports the file size a manifest
+// describes.
+//
+// Chunks are not reference counted: remove() deletes the manifest and leaves
+// its chunks for other files that may share them. Chunk names use xxh64,
+// which is fast but not collision resistant, so do not share a chunk
+// directory with writers that could craft colliding content.
+//
+// Manifest layout (little endian):
+//
+//   magic       4 bytes "AGC1"
+//   reserved    u32     0
+//   size        u64     File size
+//   chunk_count u32
+//   reserved    u32     0
+//   chunks      chunk_count x (u32 length, u64 hash low, u64 hash high)
+//
+// Like CachedHostFS, keep one per plugin.
+class ChunkStore {
+public:
+    struct Options {
+        std::string dir;                // Host directory holding the chunks; its parent must exist
+        size_t min_size = 2 * 1024;     // Smallest chunk, except a file's last
+        size_t avg_size = 8 * 1024;     // Chunk size aimed at
+        size_t max_size = 64 * 1024;    // Largest chunk
+        size_t manifest_entries = 256;  // Cached manifests
+        size_t cache_chunks = 128;      // Cached chunks
+        int64_t ttl_ms = 1000;          // Lifetime of a cached manifest; 0 disables caching
+    };
+
+    // What a write() stored
+    struct WriteStats {
+        size_t chunks = 0;      // Chunks the file was split into
+        size_t new_chunks = 0;  // Chunks that were not stored yet and were written
+        uint64_t new_bytes = 0; // Bytes of those chunks
+    };
+
+    // Magic at the start of every manifest
+    static constexpr char kMagic[4] = {'A', 'G', 'C', '1'};
+
+    static constexpr size_t kHeaderSize = 24;
+    static constexpr size_t kEntrySize = 20;
+
+    ChunkStore() : ChunkStore(Options()) {}
+
+    explicit ChunkStore(const Options& options)
+        : options_(options), manifests_(options.manifest_entries),
+          chunks_(options.cache_chunks), known_(kMaxKnown) {}
+
+    // The chunk store settings in plugin config
+    static const ConfigSchema<Options>& options_schema() {
+        static const auto schema = ConfigSchema<Options>()
+            .field("chunk_store_dir", &Options::dir)
+            .field("chunk_min_size", &Options::min_size, 64, 1 << 24)
+            .field("chunk_avg_size", &Options::avg_size, 64, 1 << 24)
+            .field("chunk_max_size", &Options::max_size, 64, 1 << 24)
+            .field("chunk_manifest_entries", &Options::manifest_entries)
+            .field("chunk_cache_chunks", &Options::cache_chunks)
+            .field("chunk_ttl_ms", &Options::ttl_ms, 0);
+        return schema;
+    }
+
+    // As CachedHostFS::configure(); the chunk sizes must also be ordered.
+    Result<void> configure(const Config& config) {
+        auto parsed = options_schema().parse(config, options_);
+        if (parsed.is_err()) {
+            return parsed.unwrap_err();
+        }
+        const Options& options = parsed.unwrap();
+        if (options.min_size > options.avg_size || options.avg_size > options.max_size) {
+            return Error::invalid_input("chunk sizes must satisfy chunk_min_size <= chunk_avg_size <= chunk_max_size");
+        }
+        options_ = options;
+        manifests_.clear();
+        manifests_.set_capacity(options_.manifest_entries);
+        chunks_.clear(); // Chunks known and cached belong to the old directory
+        chunks_.set_capacity(options_.cache_chunks);
+        known_.clear();
+        dir_ready_ = false;
+        return Result<void>();
+    }
+
+    const Options& options() const { return options_; }
+
+    // Store data as path, writing only the chunks not stored yet
+    Result<WriteStats> write(const std::string& path, Span<const uint8_t> data) {
+        auto ready = ensure_dir();
+        if (ready.is_err()) {
+            return ready.unwrap_err();
+        }
+
+        Manifest manifest;
+        manifest.size = data.size();
+        auto lengths = cdc::split(data, options_.min_size, options_.avg_size, options_.max_size);
+        manifest.chunks.reserve(lengths.size());
+        manifest.starts.reserve(lengths.size() + 1);
+        uint64_t at = 0;
+        for (size_t len : lengths) {
+            auto bytes = data.subspan((size_t)at, len);
+            manifest.chunks.push_back({simd::xxh64(bytes, 0), simd::xxh64(bytes, kSecondSeed), (uint32_t)len});
+            manifest.starts.push_back(at);
+            at += len;
+        }
+        manifest.starts.push_back(at);
+
+        // Chunks this instance has not seen stored, each once
+        std::vector<size_t> unknown;
+        std::vector<std::string> paths;
+        std::unordered_set<std::string> listed;
+        for (size_t i = 0; i < manifest.chunks.size(); i++) {
+            std::string name = chunk_name(manifest.chunks[i]);
+            if (known_.get(name) == nullptr && listed.insert(name).second) {
+                unknown.push_back(i);
+                paths.push_back(join_path(options_.dir, name));
+            }
+        }
+
+        WriteStats stats;
+        stats.chunks = manifest.chunks.size();
+        if (!paths.empty()) {
+            auto existing = HostFS::stat_many(paths);
+            for (size_t i = 0; i < unknown.size(); i++) {
+                const Chunk& chunk = manifest.chunks[unknown[i]];
+                if (existing[i].is_err() || existing[i].unwrap().size != (int64_t)chunk.length) {
+                    auto bytes = data.subspan((size_t)manifest.starts[unknown[i]], chunk.length);
+                    auto written = HostFS::write(paths[i], bytes);
+                    if (written.is_err()) {
+                        return written.unwrap_err();
+                    }
+                    stats.new_chunks++;
+                    stats.new_bytes += chunk.length;
+                }
+                known_.put(chunk_name(chunk), true);
+            }
+        }
+
+        manifests_.erase(path);
+        auto written = HostFS::write(path, encode(manifest));
+        if (written.is_err()) {
+            return written.unwrap_err();
+        }
+        if (caching()) {
+            manifest.expires = expiry();
+            manifests_.put(path, std::move(manifest));
+        }
+        return stats;
+    }
+
+    // Read size bytes (-1 for the rest) of path at offset
+    Result<std::vector<uint8_t>> read(const std::string& path, int64_t offset, int64_t size) {
+        auto loaded = load_manifest(path);
+        if (loaded.is_err()) {
+            return loaded.unwrap_err();
+        }
+        const Manifest& manifest = *loaded.unwrap();
+        if (manifest.plain) {
+            return HostFS::read(path, offset, size);
+        }
+        if (offset < 0) {
+            return Error::invalid_input("negative offset");
+        }
+
+        uint64_t left = (uint64_t)offset < manifest.size ? manifest.size - (uint64_t)offset : 0;
+        size_t count = (size_t)(size < 0 || (uint64_t)size > left ? left : (uint64_t)size);
+        std::vector<uint8_t> data(count);
+        auto assembled = assemble(manifest, (uint64_t)offset, Span<uint8_t>(data));
+        if (assembled.is_err()) {
+            return assembled.unwrap_err();
+        }
+        return data;
+    }
+
+    // Read path at offset straight into out, returning the bytes written
+    Result<size_t> read_into(const std::string& path, int64_t offset, Span<uint8_t> out) {
+        auto loaded = load_manifest(path);
+        if (loaded.is_err()) {
+            return loaded.unwrap_err();
+        }
+        const Manifest& manifest = *loaded.unwrap();
+        if (manifest.plain) {
+            return HostFS::read_into(path, offset, out);
+        }
+        if (offset < 0) {
+            return Error::invalid_input("negative offset");
+        }
+
+        uint64_t left = (uint64_t)offset < manifest.size ? manifest.size - (uint64_t)offset : 0;
+        size_t count = (size_t)std::min<uint64_t>(out.size(), left);
+        auto assembled = assemble(manifest, (uint64_t)offset, out.subspan(0, count));
+        if (assembled.is_err()) {
+            return assembled.unwrap_err();
+        }
+        return count;
+    }
+
+    // Stat path, reporting the size its manifest describes
+    Result<FileInfo> stat(const std::string& path) {
+        auto result = HostFS::stat(path);
+        if (result.is_err() || result.unwrap().is_dir) {
+            return result;
+        }
+        auto loaded = load_manifest(path);
+        if (loaded.is_err()) {
+            return loaded.unwrap_err();
+        }
+        FileInfo info = result.unwrap();
+        if (!loaded.unwrap()->plain) {
+            info.size = (int64_t)loaded.unwrap()->size;
+        }
+        return info;
+    }
+
+    // Remove path's manifest; its chunks stay
+    Result<void> remove(const std::string& path) {
+        manifests_.erase(path);
+        return HostFS::remove(path);
+    }
+
+    Result<void> rename(const std::string& old_path, const std::string& new_path) {
+        manifests_.erase(old_path);
+        manifests_.erase(new_path);
+        return HostFS::rename(old_path, new_path);
+    }
+
+    // Drop the cached manifest of path
+    void invalidate(const std::string& path) {
+        manifests_.erase(path);
+    }
+
+    // Drop every cached manifest and chunk
+    void clear() {
+        manifests_.clear();
+        chunks_.clear();
+        known_.clear();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Chunks this instance knows to be stored are remembered up to this many
+    static constexpr size_t kMaxKnown = 4096;
+
+    // Seed of the second half of a chunk's 128-bit name
+    static constexpr uint64_t kSecondSeed = 0x9E3779B97F4A7C15ull;
+
+    struct Chunk {
+        uint64_t hash_lo;
+        uint64_t hash_hi;
+        uint32_t length;
+    };
+
+    struct Manifest {
+        bool plain = false;           // Not written by ChunkStore; passed through
+        uint64_t size = 0;
+        std::vector<Chunk> chunks;
+        std::vector<uint64_t> starts; // File offset of each chunk, then the end
+        Clock::time_point expires;
+    };
+
+    bool caching() const {
+        return options_.ttl_ms > 0;
+    }
+
+    Clock::time_point expiry() const {
+        return Clock::now() + std::chrono::milliseconds(options_.ttl_ms);
+    }
+
+    Result<void> ensure_dir() {
+        if (dir_ready_) {
+            return Result<void>();
+        }
+        if (options_.dir.empty()) {
+            return Error::invalid_input("chunk_store_dir is not set");
+        }
+        auto info = HostFS::stat(options_.dir);
+        if (info.is_ok() && !info.unwrap().is_dir) {
+            return Error::not_directory();
+        }
+        if (info.is_err()) {
+            auto made = HostFS::mkdir(options_.dir, 0755);
+            if (made.is_err()) {
+                return made;
+            }
+        }
+        dir_ready_ = true;
+        return Result<void>();
+    }
+
+    static std::string chunk_name(const Chunk& chunk) {
+        static const char kHex[] = "0123456789abcdef";
+        std::string name(32, '0');
+        for (int i = 0; i < 16; i++) {
+            name[15 - i] = kHex[(chunk.hash_hi >> (i * 4)) & 0xF];
+            name[31 - i] = kHex[(chunk.hash_lo >> (i * 4)) & 0xF];
+        }
+        return name;
+    }
+
+    static std::vector<uint8_t> encode(const Manifest& manifest) {
+        std::vector<uint8_t> out(kHeaderSize + manifest.chunks.size() * kEntrySize);
+        uint8_t* p = wire::put_bytes(out.data(), kMagic, 4);
+        p = wire::put_u32(p, 0);
+        p = wire::put_u64(p, manifest.size);
+        p = wire::put_u32(p, (uint32_t)manifest.chunks.size());
+        p = wire::put_u32(p, 0);
+        for (const auto& chunk : manifest.chunks) {
+            p = wire::put_u32(p, chunk.length);
+            p = wire::put_u64(p, chunk.hash_lo);
+            p = wire::put_u64(p, chunk.hash_hi);
+        }
+        return out;
+    }
+
+    // Parse a manifest; files that are not one come back plain
+    static Result<Manifest> decode(const std::vector<uint8_t>& data, const std::string& path) {
+        Manifest manifest;
+        if (data.size() < kHeaderSize || std::memcmp(data.data(), kMagic, 4) != 0) {
+            manifest.plain = true;
+            return manifest;
+        }
+        manifest.size = wire::get_u64(data.data() + 8);
+        uint32_t count = wire::get_u32(data.data() + 16);
+        // Bound count by the bytes there are before sizing anything by it;
+        // count * kEntrySize can wrap a 32-bit size_t
+        if (count > (data.size() - kHeaderSize) / kEntrySize ||
+            (uint64_t)data.size() != kHeaderSize + (uint64_t)count * kEntrySize) {
+            return Error::io("corrupt chunk manifest " + path);
+        }
+
+        manifest.chunks.resize(count);
+        manifest.starts.resize(count + 1);
+        uint64_t at = 0;
+        const uint8_t* p = data.data() + kHeaderSize;
+        for (uint32_t i = 0; i < count; i++, p += kEntrySize) {
+            manifest.chunks[i] = {wire::get_u64(p + 4), wire::get_u64(p + 12), wire::get_u32(p)};
+            manifest.starts[i] = at;
+            at += manifest.chunks[i].length;
+        }
+        manifest.starts[count] = at;
+        if (at != manifest.size) {
+            return Error::io("corrupt chunk manifest " + path);
+        }
+        return manifest;
+    }
+
+    // The manifest of path, from the cache or read from the host. The pointer
+    // stays valid until the next call that touches the manifest cache.
+    Result<const Manifest*> load_manifest(const std::string& path) {
+        if (Manifest* cached = manifests_.get(path)) {
+            if (Clock::now() < cached->expires) {
+                return cached;
+            }
+            manifests_.erase(path);
+        }
+
+        // Read the header first, so files that are not manifests cost a
+        // header's worth of bytes, and the entries only after it. One byte
+        // past the entries catches a file longer than its manifest.
+        auto data = HostFS::read(path, 0, (int64_t)kHeaderSize);
+        if (data.is_err()) {
+            return data.unwrap_err();
+        }
+        std::vector<uint8_t>& bytes = data.unwrap();
+        if (bytes.size() == kHeaderSize && std::memcmp(bytes.data(), kMagic, 4) == 0) {
+            uint64_t entries = (uint64_t)wire::get_u32(bytes.data() + 16) * kEntrySize;
+            auto rest = HostFS::read(path, (int64_t)kHeaderSize, (int64_t)entries + 1);
+            if (rest.is_err()) {
+                return rest.unwrap_err();
+            }
+            bytes.insert(bytes.end(), rest.unwrap().begin(), rest.unwrap().end());
+        }
+        auto decoded = decode(bytes, path);
+        if (decoded.is_err()) {
+            return decoded.unwrap_err();
+        }
+        if (!caching() || options_.manifest_entries == 0) {
+            uncached_ = std::move(decoded.unwrap());
+            return &uncached_;
+        }
+        decoded.unwrap().expires = expiry();
+        manifests_.put(path, std::move(decoded.unwrap()));
+        return manifests_.get(path);
+    }
+
+    // Fill out with bytes [offset, offset + out.size()) of the file manifest
+    // describes, which must lie within it, fetching the chunks not cached in
+    // one host call
+    Result<void> assemble(const Manifest& manifest, uint64_t offset, Span<uint8_t> out) {
+        if (out.empty()) {
+            return Result<void>();
+        }
+        uint64_t end = offset + out.size();
+        size_t first = (size_t)(std::upper_bound(manifest.starts.begin(), manifest.starts.end(), offset) -
+                                manifest.starts.begin()) - 1;
+
+        // Copy the part of chunk i within the range into out
+        auto place = [&](size_t i, const uint8_t* bytes) {
+            uint64_t start = manifest.starts[i];
+            uint64_t from = std::max(start, offset);
+            uint64_t to = std::min(manifest.starts[i + 1], end);
+            std::memcpy(out.data() + (from - offset), bytes + (from - start), (size_t)(to - from));
+        };
+
+        std::vector<size_t> misses;
+        std::vector<ReadRequest> requests;
+        for (size_t i = first; i < manifest.chunks.size() && manifest.starts[i] < end; i++) {
+            std::string name = chunk_name(manifest.chunks[i]);
+            if (const std::vector<uint8_t>* cached = chunks_.get(name)) {
+                place(i, cached->data());
+                continue;
+            }
+            misses.push_back(i);
+            requests.emplace_back(join_path(options_.dir, name));
+        }
+        if (requests.empty()) {
+            return Result<void>();
+        }
+
+        auto fetched = HostFS::read_many(requests);
+        for (size_t k = 0; k < misses.size(); k++) {
+            if (fetched[k].is_err()) {
+                return fetched[k].unwrap_err();
+            }
+            std::vector<uint8_t>& bytes = fetched[k].unwrap();
+            const Chunk& chunk = manifest.chunks[misses[k]];
+            if (bytes.size() != chunk.length) {
+                return Error::io("chunk " + requests[k].path + " has the wrong size");
+            }
+            place(misses[k], bytes.data());
+            chunks_.put(chunk_name(chunk), std::move(bytes));
+        }
+        return Result<void>();
+    }
+
+    Options options_;
+    LruCache<std::string, Manifest> manifests_;
+    LruCache<std::string, std::vector<uint8_t>> chunks_;
+    LruCache<std::string, bool> known_; // Chunks known to be stored
+    Manifest uncached_;                 // Last manifest loaded while the cache holds none
+    bool dir_ready_ = false;
+};
+
+} // namespace agfs
+
+#endif // AGFS_CHUNKS_H
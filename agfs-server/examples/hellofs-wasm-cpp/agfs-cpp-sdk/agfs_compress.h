@@ -0,0 +1,739 @@
+#ifndef AGFS_COMPRESS_H
+#define AGFS_COMPRESS_H
+
+#include "agfs_types.h"
+#include "agfs_config.h"
+#include "agfs_wire.h"
+#include "agfs_hostfs.h"
+#include "agfs_cache.h"
+#include "agfs_filesystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace agfs {
+namespace lz4 {
+
+// LZ4 block format codec. Blocks are the standard LZ4 sequence format (no
+// frame header or checksum), so they decode with any LZ4 implementation's
+// block decompressor. The compressor is the single-pass greedy matcher of
+// LZ4's fast mode: it needs no allocation beyond a caller-owned hash table
+// and runs at memory speed on text such as logs.
+
+constexpr size_t kHashLog = 12;
+constexpr size_t kHashEntries = size_t(1) << kHashLog;
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5;   // A block always ends with this many literals
+constexpr size_t kMatchStartLimit = 12; // No match starts this close to the end
+constexpr size_t kMaxOffset = 65535;
+
+// Largest compressed size of n input bytes
+inline size_t compress_bound(size_t n) {
+    return n + n / 255 + 16;
+}
+
+namespace internal {
+
+inline uint32_t load_u32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint32_t hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - kHashLog);
+}
+
+inline uint8_t* put_length(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+inline bool get_length(const uint8_t*& ip, const uint8_t* end, size_t& len) {
+    uint8_t b;
+    do {
+        if (ip >= end) {
+            return false;
+        }
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+// Emit literals followed by a match of match_len bytes at offset back; a
+// match_len of 0 ends the block with the literals alone
+inline uint8_t* put_sequence(uint8_t* op, const uint8_t* literals, size_t literal_len,
+                             size_t offset, size_t match_len) {
+    uint8_t* token = op++;
+    if (literal_len >= 15) {
+        *token = 15 << 4;
+        op = put_length(op, literal_len - 15);
+    } else {
+        *token = (uint8_t)(literal_len << 4);
+    }
+    if (literal_len > 0) {
+        std::memcpy(op, literals, literal_len);
+        op += literal_len;
+    }
+    if (match_len == 0) {
+        return op;
+    }
+
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    size_t extra = match_len - kMinMatch;
+    if (extra >= 15) {
+        *token |= 15;
+        op = put_length(op, extra - 15);
+    } else {
+        *token |= (uint8_t)extra;
+    }
+    return op;
+}
+
+} // namespace internal
+
+// Compress in into out, which must hold compress_bound(in.size()) bytes, and
+// return the compressed size. table must hold kHashEntries entries; its
+// contents on entry do not matter.
+inline size_t compress(Span<const uint8_t> in, uint8_t* out, uint32_t* table) {
+    const uint8_t* base = in.data();
+    size_t n = in.size();
+    uint8_t* op = out;
+    size_t anchor = 0;
+
+    if (n > kMatchStartLimit) {
+        std::memset(table, 0, kHashEntries * sizeof(uint32_t));
+        size_t start_limit = n - kMatchStartLimit;
+        size_t end_limit = n - kLastLiterals;
+        size_t ip = 0;
+        size_t misses = 0;
+
+        while (ip < start_limit) {
+            uint32_t sequence = internal::load_u32(base + ip);
+            uint32_t h = internal::hash(sequence);
+            size_t ref = table[h];
+            table[h] = (uint32_t)ip;
+
+            if (ref >= ip || ip - ref > kMaxOffset || internal::load_u32(base + ref) != sequence) {
+                // Step faster through data that keeps failing to match
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+
+            while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1]) {
+                ip--;
+                ref--;
+            }
+            size_t len = kMinMatch;
+            while (ip + len < end_limit && base[ref + len] == base[ip + len]) {
+                len++;
+            }
+
+            op = internal::put_sequence(op, base + anchor, ip - anchor, ip - ref, len);
+            ip += len;
+            anchor = ip;
+            misses = 0;
+        }
+    }
+
+    op = internal::put_sequence(op, base + anchor, n - anchor, 0, 0);
+    return (size_t)(op - out);
+}
+
+// Decompress a block that must expand to exactly out.size() bytes. Returns
+// false for malformed input instead of reading or writing out of bounds.
+inline bool decompress(Span<const uint8_t> in, Span<uint8_t> out) {
+    const uint8_t* ip = in.data();
+    const uint8_t* in_end = ip + in.size();
+    uint8_t* op = out.data();
+    uint8_t* out_end = op + out.size();
+
+    while (ip < in_end) {
+        uint8_t token = *ip++;
+
+        size_t literal_len = token >> 4;
+        if (literal_len == 15 && !internal::get_length(ip, in_end, literal_len)) {
+            return false;
+        }
+        if ((size_t)(in_end - ip) < literal_len || (size_t)(out_end - op) < literal_len) {
+            return false;
+        }
+        if (literal_len > 0) {
+            std::memcpy(op, ip, literal_len);
+            ip += literal_len;
+            op += literal_len;
+        }
+        if (ip == in_end) {
+            break; // The last sequence has no match
+        }
+
+        if (in_end - ip < 2) {
+            return false;
+        }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - out.data())) {
+            return false;
+        }
+
+        size_t match_len = token & 15;
+        if (match_len == 15 && !internal::get_length(ip, in_end, match_len)) {
+            return false;
+        }
+        match_len += kMinMatch;
+        if ((size_t)(out_end - op) < match_len) {
+            return false;
+        }
+
+        const uint8_t* match = op - offset;
+        if (offset >= match_len) {
+            std::memcpy(op, match, match_len);
+        } else {
+            for (size_t i = 0; i < match_len; i++) {
+                op[i] = match[i]; // Overlapping copy repeats the last offset bytes
+            }
+        }
+        op += match_len;
+    }
+    return op == out_end;
+}
+
+} // namespace lz4
+
+// CompressedFS stores files compressed in another filesystem.
+//
+// It is a FileSystem that keeps every file it writes as LZ4 blocks in
+// fixed-size frames, either through HostFS or in another FileSystem, and
+// decompresses on read. The frame index at the front of each stored file
+// lets a range read fetch and decompress only the frames covering
+// [offset, offset + size), so reading the tail of a large log costs a frame
+// or two of host I/O instead of the whole file. Frames that do not shrink
+// are kept uncompressed.
+//
+// Stored layout (little endian):
+//
+//   magic       4 bytes "AGZ1"
+//   frame_size  u32     Uncompressed bytes per frame (the last may be short)
+//   size        u64     Uncompressed file size
+//   frame_count u32     ceil(size / frame_size)
+//   reserved    u32     0
+//   frames      frame_count x u32: stored length of each frame, with the
+//               high bit set if the frame is kept uncompressed
+//   data        the frames, back to back
+//
+// Files without the magic (written by someone else, or created empty) are
+// passed through unchanged. Frame indexes are cached for a short TTL, so a
+// run of reads costs one backend read each; changes made through this object
+// update the cache, changes made by anyone else show up once the TTL expires
+// or after invalidate(). stat() and readdir() report the uncompressed size.
+//
+// Like CachedHostFS, keep one per plugin and forward the operations it should
+// handle to it.
+class CompressedFS : public FileSystem {
+public:
+    struct Options {
+        size_t frame_size = 64 * 1024; // Uncompressed bytes per frame
+        size_t probe_bytes = 4096;     // First read of a file with no cached index
+        size_t index_entries = 256;    // Cached frame indexes
+        int64_t ttl_ms = 1000;         // Lifetime of a cached index; 0 disables caching
+    };
+
+    // Magic at the start of every stored file
+    static constexpr char kMagic[4] = {'A', 'G', 'Z', '1'};
+
+    // Size of the fixed header, before the frame table
+    static constexpr size_t kHeaderSize = 24;
+
+    // Set in a frame table entry for a frame kept uncompressed
+    static constexpr uint32_t kStoredRaw = 1u << 31;
+
+    // Frame sizes accepted in config and in stored headers
+    static constexpr size_t kMinFrameSize = 1024;
+    static constexpr size_t kMaxFrameSize = 1 << 24;
+
+    // Store files through HostFS
+    CompressedFS() : CompressedFS(Options()) {}
+
+    explicit CompressedFS(const Options& options) : CompressedFS(nullptr, options) {}
+
+    // Store files in inner, which must outlive this object
+    explicit CompressedFS(FileSystem& inner) : CompressedFS(&inner, Options()) {}
+
+    CompressedFS(FileSystem& inner, const Options& options) : CompressedFS(&inner, options) {}
+
+    // The compression settings in plugin config
+    static const ConfigSchema<Options>& options_schema() {
+        static const auto schema = ConfigSchema<Options>()
+            .field("compress_frame_size", &Options::frame_size, (long long)kMinFrameSize, (long long)kMaxFrameSize)
+            .field("compress_probe_bytes", &Options::probe_bytes, (long long)kHeaderSize)
+            .field("compress_index_entries", &Options::index_entries)
+            .field("compress_ttl_ms", &Options::ttl_ms, 0);
+        return schema;
+    }
+
+    // As CachedHostFS::configure(); the frame size only applies to files
+    // written afterwards.
+    Result<void> configure(const Config& config) {
+        auto parsed = options_schema().parse(config, options_);
+        if (parsed.is_err()) {
+            return parsed.unwrap_err();
+        }
+        options_ = parsed.unwrap();
+        indexes_.clear();
+        indexes_.set_capacity(options_.index_entries);
+        return Result<void>();
+    }
+
+    const Options& options() const { return options_; }
+
+    const char* name() const override {
+        return "compressedfs";
+    }
+
+    Result<FileInfo> stat(PathArg path) override {
+        auto result = inner_ ? inner_->stat(path) : HostFS::stat(path);
+        if (result.is_err() || result.unwrap().is_dir) {
+            return result;
+        }
+        auto loaded = load_index(std::string(path));
+        if (loaded.is_err()) {
+            return loaded.unwrap_err();
+        }
+        FileInfo info = result.unwrap();
+        if (!loaded.unwrap()->plain) {
+            info.size = (int64_t)loaded.unwrap()->size;
+        }
+        return info;
+    }
+
+    // List a directory, reading the header of every file with no cached index
+    // to report its uncompressed size (in one host call through HostFS)
+    Result<std::vector<FileInfo>> readdir(PathArg path) override {
+        auto result = inner_ ? inner_->readdir(path) : HostFS::readdir(path);
+        if (result.is_err()) {
+            return result;
+        }
+        std::vector<FileInfo> entries = std::move(result.unwrap());
+        std::string dir(path);
+
+        std::vector<size_t> misses;
+        std::vector<ReadRequest> headers;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].is_dir || entries[i].size < (int64_t)kHeaderSize) {
+                continue;
+            }
+            std::string child = join_path(dir, entries[i].name);
+            if (const FrameIndex* cached = cached_index(child)) {
+                if (!cached->plain) {
+                    entries[i].size = (int64_t)cached->size;
+                }
+                continue;
+            }
+            misses.push_back(i);
+            headers.emplace_back(child, 0, (int64_t)kHeaderSize);
+        }
+        if (headers.empty()) {
+            return entries;
+        }
+
+        auto fetched = read_many(headers);
+        for (size_t i = 0; i < misses.size(); i++) {
+            Header header;
+            if (fetched[i].is_ok() && parse_header(fetched[i].unwrap(), header)) {
+                entries[misses[i]].size = (int64_t)header.size;
+            }
+        }
+        return entries;
+    }
+
+    Result<std::vector<uint8_t>> read(PathArg path, int64_t offset, int64_t size) override {
+        std::string key(path);
+        std::vector<uint8_t> probe;
+        auto loaded = load_index(key, &probe);
+        if (loaded.is_err()) {
+            return loaded.unwrap_err();
+        }
+        const FrameIndex& index = *loaded.unwrap();
+        if (index.plain) {
+            return inner_ ? inner_->read(path, offset, size) : HostFS::read(path, offset, size);
+        }
+        if (offset < 0) {
+            return Error::invalid_input("negative offset");
+        }
+
+        uint64_t left = (uint64_t)offset < index.size ? index.size - (uint64_t)offset : 0;
+        size_t count = (size_t)(size < 0 || (uint64_t)size > left ? left : (uint64_t)size);
+        std::vector<uint8_t> data(count);
+        auto decoded = decode(key, index, probe, (uint64_t)offset, Span<uint8_t>(data));
+        if (decoded.is_err()) {
+            return decoded.unwrap_err();
+        }
+        return data;
+    }
+
+    Result<size_t> read_into(PathArg path, int64_t offset, Span<uint8_t> out) override {
+        std::string key(path);
+        std::vector<uint8_t> probe;
+        auto loaded = load_index(key, &probe);
+        if (loaded.is_err()) {
+            return loaded.unwrap_err();
+        }
+        const FrameIndex& index = *loaded.unwrap();
+        if (index.plain) {
+            return inner_ ? inner_->read_into(path, offset, out) : HostFS::read_into(path, offset, out);
+        }
+        if (offset < 0) {
+            return Error::invalid_input("negative offset");
+        }
+
+        uint64_t left = (uint64_t)offset < index.size ? index.size - (uint64_t)offset : 0;
+        size_t count = (size_t)std::min<uint64_t>(out.size(), left);
+        auto decoded = decode(key, index, probe, (uint64_t)offset, out.subspan(0, count));
+        if (decoded.is_err()) {
+            return decoded.unwrap_err();
+        }
+        return count;
+    }
+
+    // Replace path with data, compressed
+    Result<std::vector<uint8_t>> write(PathArg path, DataArg data) override {
+        std::string key(path);
+        FrameIndex index;
+        std::vector<uint8_t> stored = encode(Span<const uint8_t>(data.data(), data.size()), index);
+
+        indexes_.erase(key);
+        auto result = inner_ ? inner_->write(path, stored) : HostFS::write(path, stored);
+        if (result.is_ok() && caching()) {
+            index.expires = expiry();
+            indexes_.put(key, std::move(index));
+        }
+        return result;
+    }
+
+    Result<void> create(PathArg path) override {
+        indexes_.erase(std::string(path));
+        return inner_ ? inner_->create(path) : HostFS::create(path);
+    }
+
+    Result<void> mkdir(PathArg path, uint32_t perm) override {
+        return inner_ ? inner_->mkdir(path, perm) : HostFS::mkdir(path, perm);
+    }
+
+    Result<void> remove(PathArg path) override {
+        indexes_.erase(std::string(path));
+        return inner_ ? inner_->remove(path) : HostFS::remove(path);
+    }
+
+    Result<void> remove_all(PathArg path) override {
+        invalidate_tree(std::string(path));
+        return inner_ ? inner_->remove_all(path) : HostFS::remove_all(path);
+    }
+
+    Result<void> rename(PathArg old_path, PathArg new_path) override {
+        invalidate_tree(std::string(old_path));
+        invalidate_tree(std::string(new_path));
+        return inner_ ? inner_->rename(old_path, new_path) : HostFS::rename(old_path, new_path);
+    }
+
+    Result<void> chmod(PathArg path, uint32_t mode) override {
+        return inner_ ? inner_->chmod(path, mode) : HostFS::chmod(path, mode);
+    }
+
+    // Whole-file copies move the stored bytes without decompressing them and
+    // return the uncompressed size; copies of a range are left to the host
+    Result<uint64_t> copy(PathArg src, PathArg dst, int64_t offset, int64_t size) override {
+        if (offset != 0 || size >= 0) {
+            return Error::unsupported();
+        }
+        auto loaded = load_index(std::string(src));
+        if (loaded.is_err()) {
+            return loaded.unwrap_err();
+        }
+        bool plain = loaded.unwrap()->plain;
+        uint64_t raw_size = loaded.unwrap()->size;
+
+        indexes_.erase(std::string(dst));
+        auto result = inner_ ? inner_->copy(src, dst, 0, -1) : HostFS::copy(src, dst, 0, -1);
+        if (result.is_err() || plain) {
+            return result;
+        }
+        return raw_size;
+    }
+
+    // Drop the cached index of path
+    void invalidate(const std::string& path) {
+        indexes_.erase(path);
+    }
+
+    // Drop every cached index
+    void clear() {
+        indexes_.clear();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Header {
+        uint32_t frame_size = 0;
+        uint64_t size = 0;
+        uint32_t frame_count = 0;
+    };
+
+    struct FrameIndex {
+        bool plain = false;           // Not stored by CompressedFS; passed through
+        uint64_t size = 0;            // Uncompressed size
+        uint32_t frame_size = 0;
+        std::vector<uint32_t> frames; // Frame table entries
+        std::vector<uint64_t> starts; // Stored offset of each frame, then the end
+        Clock::time_point expires;
+    };
+
+    CompressedFS(FileSystem* inner, const Options& options)
+        : inner_(inner), options_(options), indexes_(options.index_entries),
+          table_(lz4::kHashEntries) {}
+
+    bool caching() const {
+        return options_.ttl_ms > 0;
+    }
+
+    Clock::time_point expiry() const {
+        return Clock::now() + std::chrono::milliseconds(options_.ttl_ms);
+    }
+
+    static bool parse_header(const std::vector<uint8_t>& data, Header& header) {
+        if (data.size() < kHeaderSize || std::memcmp(data.data(), kMagic, 4) != 0) {
+            return false;
+        }
+        header.frame_size = wire::get_u32(data.data() + 4);
+        header.size = wire::get_u64(data.data() + 8);
+        header.frame_count = wire::get_u32(data.data() + 16);
+        return header.frame_size >= kMinFrameSize && header.frame_size <= kMaxFrameSize &&
+               header.frame_count == (header.size + header.frame_size - 1) / header.frame_size;
+    }
+
+    // Uncompressed length of frame i
+    static size_t frame_length(const FrameIndex& index, size_t i) {
+        uint64_t start = (uint64_t)i * index.frame_size;
+        return (size_t)std::min<uint64_t>(index.frame_size, index.size - start);
+    }
+
+    const FrameIndex* cached_index(const std::string& path) {
+        FrameIndex* cached = indexes_.get(path);
+        if (cached != nullptr && Clock::now() >= cached->expires) {
+            indexes_.erase(path);
+            return nullptr;
+        }
+        return cached;
+    }
+
+    // The frame index of path, from the cache or read from the backend. When
+    // read, probe receives the first bytes of the stored file, which may
+    // already hold the frames a small read needs. The pointer stays valid
+    // until the next call that touches the cache.
+    Result<const FrameIndex*> load_index(const std::string& path, std::vector<uint8_t>* probe = nullptr) {
+        if (const FrameIndex* cached = cached_index(path)) {
+            return cached;
+        }
+
+        auto first = backend_read(path, 0, (int64_t)options_.probe_bytes);
+        if (first.is_err()) {
+            return first.unwrap_err();
+        }
+        std::vector<uint8_t> data = std::move(first.unwrap());
+
+        FrameIndex index;
+        Header header;
+        if (!parse_header(data, header)) {
+            index.plain = true;
+        } else {
+            uint64_t table_end = kHeaderSize + (uint64_t)header.frame_count * 4;
+            if (data.size() < table_end) {
+                // Check the table fits in the stored file before asking for
+                // it; a short probe already saw the whole file
+                uint64_t stored = data.size();
+                if (data.size() >= options_.probe_bytes) {
+                    auto info = backend_stat(path);
+                    if (info.is_err()) {
+                        return info.unwrap_err();
+                    }
+                    stored = (uint64_t)info.unwrap().size;
+                }
+                if (stored < table_end) {
+                    return Error::io("truncated frame table in " + path);
+                }
+                auto rest = backend_read(path, (int64_t)data.size(), (int64_t)(table_end - data.size()));
+                if (rest.is_err()) {
+                    return rest.unwrap_err();
+                }
+                data.insert(data.end(), rest.unwrap().begin(), rest.unwrap().end());
+                if (data.size() < table_end) {
+                    return Error::io("truncated frame table in " + path);
+                }
+            }
+
+            index.size = header.size;
+            index.frame_size = header.frame_size;
+            index.frames.resize(header.frame_count);
+            index.starts.resize(header.frame_count + 1);
+            uint64_t at = table_end;
+            for (size_t i = 0; i < header.frame_count; i++) {
+                uint32_t entry = wire::get_u32(data.data() + kHeaderSize + i * 4);
+                if ((entry & kStoredRaw) && (entry & ~kStoredRaw) != frame_length(index, i)) {
+                    return Error::io("corrupt frame table in " + path);
+                }
+                index.frames[i] = entry;
+                index.starts[i] = at;
+                at += entry & ~kStoredRaw;
+            }
+            index.starts[header.frame_count] = at;
+        }
+
+        if (probe != nullptr) {
+            *probe = std::move(data);
+        }
+        if (!caching() || options_.index_entries == 0) {
+            uncached_ = std::move(index);
+            return &uncached_;
+        }
+        index.expires = expiry();
+        indexes_.put(path, std::move(index));
+        return indexes_.get(path);
+    }
+
+    // Decompress bytes [offset, offset + out.size()) of a stored file, which
+    // must lie within it, fetching only the frames that cover them
+    Result<void> decode(const std::string& path, const FrameIndex& index,
+                        const std::vector<uint8_t>& probe, uint64_t offset, Span<uint8_t> out) {
+        if (out.empty()) {
+            return Result<void>();
+        }
+        size_t first = (size_t)(offset / index.frame_size);
+        size_t last = (size_t)((offset + out.size() - 1) / index.frame_size);
+        uint64_t begin = index.starts[first];
+        uint64_t end = index.starts[last + 1];
+
+        const uint8_t* stored;
+        std::vector<uint8_t> fetched;
+        if (end <= probe.size()) {
+            stored = probe.data() + begin;
+        } else {
+            auto result = backend_read(path, (int64_t)begin, (int64_t)(end - begin));
+            if (result.is_err()) {
+                return result.unwrap_err();
+            }
+            fetched = std::move(result.unwrap());
+            if (fetched.size() != end - begin) {
+                return Error::io("truncated compressed file " + path);
+            }
+            stored = fetched.data();
+        }
+
+        size_t done = 0;
+        for (size_t i = first; i <= last; i++) {
+            uint32_t entry = index.frames[i];
+            Span<const uint8_t> frame(stored + (index.starts[i] - begin), entry & ~kStoredRaw);
+            size_t length = frame_length(index, i);
+            uint64_t frame_start = (uint64_t)i * index.frame_size;
+            size_t skip = offset > frame_start ? (size_t)(offset - frame_start) : 0;
+            size_t take = std::min(length - skip, out.size() - done);
+
+            if (entry & kStoredRaw) {
+                std::memcpy(out.data() + done, frame.data() + skip, take);
+            } else if (skip == 0 && take == length) {
+                if (!lz4::decompress(frame, out.subspan(done, length))) {
+                    return Error::io("corrupt frame in " + path);
+                }
+            } else {
+                frame_buf_.resize(length);
+                if (!lz4::decompress(frame, Span<uint8_t>(frame_buf_))) {
+                    return Error::io("corrupt frame in " + path);
+                }
+                std::memcpy(out.data() + done, frame_buf_.data() + skip, take);
+            }
+            done += take;
+        }
+        return Result<void>();
+    }
+
+    // Lay out data as a stored file and fill index to match
+    std::vector<uint8_t> encode(Span<const uint8_t> data, FrameIndex& index) {
+        index.size = data.size();
+        index.frame_size = (uint32_t)options_.frame_size;
+        size_t count = (data.size() + options_.frame_size - 1) / options_.frame_size;
+        index.frames.resize(count);
+        index.starts.resize(count + 1);
+
+        size_t table_end = kHeaderSize + count * 4;
+        std::vector<uint8_t> stored(table_end);
+        std::memcpy(stored.data(), kMagic, 4);
+        wire::put_u32(stored.data() + 4, index.frame_size);
+        wire::put_u64(stored.data() + 8, index.size);
+        wire::put_u32(stored.data() + 16, (uint32_t)count);
+        wire::put_u32(stored.data() + 20, 0);
+
+        scratch_.resize(lz4::compress_bound(options_.frame_size));
+        for (size_t i = 0; i < count; i++) {
+            auto raw = data.subspan(i * options_.frame_size, frame_length(index, i));
+            size_t packed = lz4::compress(raw, scratch_.data(), table_.data());
+
+            index.starts[i] = stored.size();
+            if (packed < raw.size()) {
+                index.frames[i] = (uint32_t)packed;
+                stored.insert(stored.end(), scratch_.begin(), scratch_.begin() + packed);
+            } else {
+                index.frames[i] = (uint32_t)raw.size() | kStoredRaw;
+                stored.insert(stored.end(), raw.data(), raw.data() + raw.size());
+            }
+            wire::put_u32(stored.data() + kHeaderSize + i * 4, index.frames[i]);
+        }
+        index.starts[count] = stored.size();
+        return stored;
+    }
+
+    Result<std::vector<uint8_t>> backend_read(const std::string& path, int64_t offset, int64_t size) {
+        return inner_ ? inner_->read(path, offset, size) : HostFS::read(path, offset, size);
+    }
+
+    Result<FileInfo> backend_stat(const std::string& path) {
+        return inner_ ? inner_->stat(path) : HostFS::stat(path);
+    }
+
+    std::vector<Result<std::vector<uint8_t>>> read_many(const std::vector<ReadRequest>& requests) {
+        if (!inner_) {
+            return HostFS::read_many(requests);
+        }
+        std::vector<Result<std::vector<uint8_t>>> results;
+        results.reserve(requests.size());
+        for (const auto& request : requests) {
+            results.push_back(inner_->read(request.path, request.offset, request.size));
+        }
+        return results;
+    }
+
+    void invalidate_tree(const std::string& path) {
+        indexes_.erase_if([&path](const std::string& key) {
+            return key == path || path == "/" ||
+                   (key.size() > path.size() && key.compare(0, path.size(), path) == 0 &&
+                    key[path.size()] == '/');
+        });
+    }
+
+    FileSystem* inner_; // nullptr stores through HostFS
+    Options options_;
+    LruCache<std::string, FrameIndex> indexes_;
+    FrameIndex uncached_;             // Last index loaded while the cache holds none
+    std::vector<uint32_t> table_;     // Compressor hash table
+    std::vector<uint8_t> scratch_;    // One compressed frame
+    std::vector<uint8_t> frame_buf_;  // One decompressed frame a read only partly covers
+};
+
+} // namespace agfs
+
+#endif // AGFS_COMPRESS_H
@@ -0,0 +1,209 @@
+#ifndef AGFS_CONFIG_H
+#define AGFS_CONFIG_H
+
+#include "agfs_types.h"
+#include <cerrno>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace agfs {
+
+// Typed plugin configuration
+//
+// A ConfigSchema<T> maps config keys to members of a plain struct T whose
+// default member initializers are the defaults. parse() checks every field
+// in one pass and reports all problems in a single InvalidInput error, so
+// validate() and initialize() share it and the plugin keeps the resulting
+// struct; reads after that are plain member accesses.
+//
+//   struct Settings {
+//       std::string root;
+//       int64_t cache_entries = 1024;
+//       bool read_only = false;
+//   };
+//
+//   static const agfs::ConfigSchema<Settings>& schema() {
+//       static const auto s = agfs::ConfigSchema<Settings>()
+//           .field("root", &Settings::root).required()
+//           .field("cache_entries", &Settings::cache_entries, 0, 1 << 20)
+//           .field("read_only", &Settings::read_only);
+//       return s;
+//   }
+//
+//   agfs::Result<void> validate(const agfs::Config& c) override { return schema().validate(c); }
+
+namespace internal {
+
+// Strict decimal integer: the whole text, no overflow
+inline bool parse_config_int(const std::string& text, long long& out) {
+    if (text.empty()) {
+        return false;
+    }
+    errno = 0;
+    char* end = nullptr;
+    out = std::strtoll(text.c_str(), &end, 10);
+    return errno == 0 && end == text.c_str() + text.size();
+}
+
+inline bool parse_config_double(const std::string& text, double& out) {
+    if (text.empty()) {
+        return false;
+    }
+    errno = 0;
+    char* end = nullptr;
+    out = std::strtod(text.c_str(), &end);
+    return errno == 0 && end == text.c_str() + text.size();
+}
+
+inline bool parse_config_bool(const std::string& text, bool& out) {
+    if (text == "true" || text == "1") {
+        out = true;
+        return true;
+    }
+    if (text == "false" || text == "0") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+} // namespace internal
+
+template<typename T>
+class ConfigSchema {
+public:
+    // A string field
+    ConfigSchema& field(const char* name, std::string T::*member) {
+        return add(name, [member](T& out, const std::string& text, std::string& err) {
+            (void)err;
+            out.*member = text;
+            return true;
+        });
+    }
+
+    // A bool field: true/false (or 1/0)
+    ConfigSchema& field(const char* name, bool T::*member) {
+        return add(name, [member](T& out, const std::string& text, std::string& err) {
+            if (!internal::parse_config_bool(text, out.*member)) {
+                err = "expected true or false";
+                return false;
+            }
+            return true;
+        });
+    }
+
+    // A floating-point field
+    ConfigSchema& field(const char* name, double T::*member) {
+        return add(name, [member](T& out, const std::string& text, std::string& err) {
+            if (!internal::parse_config_double(text, out.*member)) {
+                err = "expected a number";
+                return false;
+            }
+            return true;
+        });
+    }
+
+    // An integer field of any width, checked against [min, max] as well as
+    // the range of the member's type
+    template<typename I, typename = std::enable_if_t<std::is_integral<I>::value && !std::is_same<I, bool>::value>>
+    ConfigSchema& field(const char* name, I T::*member,
+                        long long min = std::numeric_limits<long long>::min(),
+                        long long max = std::numeric_limits<long long>::max()) {
+        if (std::is_signed<I>::value) {
+            if (min < (long long)std::numeric_limits<I>::min()) {
+                min = (long long)std::numeric_limits<I>::min();
+            }
+        } else if (min < 0) {
+            min = 0;
+        }
+        if (max > 0 && (unsigned long long)max > (unsigned long long)std::numeric_limits<I>::max()) {
+            max = (long long)std::numeric_limits<I>::max();
+        }
+        return add(name, [member, min, max](T& out, const std::string& text, std::string& err) {
+            long long v = 0;
+            if (!internal::parse_config_int(text, v)) {
+                err = "expected an integer";
+                return false;
+            }
+            if (v < min || v > max) {
+                err = "must be between " + std::to_string(min) + " and " + std::to_string(max);
+                return false;
+            }
+            out.*member = (I)v;
+            return true;
+        });
+    }
+
+    // Make the field declared last mandatory
+    ConfigSchema& required() {
+        if (!fields_.empty()) {
+            fields_.back().required = true;
+        }
+        return *this;
+    }
+
+    // Parse config over base (by default T's own defaults). Fields missing
+    // from config keep their base value.
+    Result<T> parse(const Config& config, T base = T()) const {
+        std::string errors;
+        for (const Field& f : fields_) {
+            auto it = config.values.find(f.name);
+            if (it == config.values.end()) {
+                if (f.required) {
+                    append_error(errors, f.name, "required");
+                }
+                continue;
+            }
+            std::string err;
+            if (!f.apply(base, it->second, err)) {
+                append_error(errors, f.name, err);
+            }
+        }
+        if (!errors.empty()) {
+            return Error::invalid_input("config: " + errors);
+        }
+        return base;
+    }
+
+    // Check config without keeping the result, for FileSystem::validate()
+    Result<void> validate(const Config& config) const {
+        auto result = parse(config);
+        if (result.is_err()) {
+            return result.unwrap_err();
+        }
+        return Result<void>();
+    }
+
+private:
+    using Apply = std::function<bool(T&, const std::string&, std::string&)>;
+
+    struct Field {
+        const char* name;
+        Apply apply;
+        bool required;
+    };
+
+    std::vector<Field> fields_;
+
+    ConfigSchema& add(const char* name, Apply apply) {
+        fields_.push_back(Field{name, std::move(apply), false});
+        return *this;
+    }
+
+    static void append_error(std::string& errors, const char* name, const std::string& err) {
+        if (!errors.empty()) {
+            errors += "; ";
+        }
+        errors += name;
+        errors += ": ";
+        errors += err;
+    }
+};
+
+} // namespace agfs
+
+#endif // AGFS_CONFIG_H
@@ -4,6 +4,8 @@
 #include "agfs_types.h"
 #include "agfs_ffi.h"
 #include "agfs_filesystem.h"
+#include "agfs_metrics.h"
+#include <type_traits>
 
 namespace agfs {
 namespace internal {
@@ -17,189 +19,579 @@ struct PluginInstance {
 template<typename T>
 T* PluginInstance<T>::instance = nullptr;
 
+// overrides_<method><T>: whether T (or a base between it and FileSystem)
+// overrides FileSystem::<method>. A method &T::<method> cannot name, because
+// T overloads it, counts as overridden.
+#define AGFS_DEFINE_OVERRIDES(method) \
+    template<typename T, typename = void> \
+    struct overrides_##method : std::true_type {}; \
+    template<typename T> \
+    struct overrides_##method<T, std::void_t<decltype(&T::method)>> \
+        : std::integral_constant<bool, \
+              !std::is_same<decltype(&T::method), decltype(&FileSystem::method)>::value> {};
+
+AGFS_DEFINE_OVERRIDES(write)
+AGFS_DEFINE_OVERRIDES(create)
+AGFS_DEFINE_OVERRIDES(mkdir)
+AGFS_DEFINE_OVERRIDES(remove)
+AGFS_DEFINE_OVERRIDES(remove_all)
+AGFS_DEFINE_OVERRIDES(rename)
+AGFS_DEFINE_OVERRIDES(chmod)
+AGFS_DEFINE_OVERRIDES(open)
+AGFS_DEFINE_OVERRIDES(readdir_page)
+AGFS_DEFINE_OVERRIDES(snapshot)
+AGFS_DEFINE_OVERRIDES(restore)
+AGFS_DEFINE_OVERRIDES(copy)
+AGFS_DEFINE_OVERRIDES(warmup)
+
+#undef AGFS_DEFINE_OVERRIDES
+
+} // namespace internal
+
+// The Capability bits of the operations T implements, computed from which
+// FileSystem methods it overrides
+template<typename T>
+constexpr uint32_t plugin_capabilities() {
+    uint32_t caps = 0;
+    if (internal::overrides_write<T>::value) caps |= CapWrite;
+    if (internal::overrides_create<T>::value) caps |= CapCreate;
+    if (internal::overrides_mkdir<T>::value) caps |= CapMkdir;
+    if (internal::overrides_remove<T>::value) caps |= CapRemove;
+    if (internal::overrides_remove_all<T>::value) caps |= CapRemoveAll;
+    if (internal::overrides_rename<T>::value) caps |= CapRename;
+    if (internal::overrides_chmod<T>::value) caps |= CapChmod;
+    if (internal::overrides_open<T>::value) caps |= CapStreaming;
+    if (internal::overrides_readdir_page<T>::value) caps |= CapReadDirPage;
+    if (internal::overrides_snapshot<T>::value && internal::overrides_restore<T>::value) {
+        caps |= CapSnapshot;
+    }
+    if (internal::overrides_copy<T>::value) caps |= CapCopy;
+    if (internal::overrides_warmup<T>::value) caps |= CapWarmup;
+    return caps;
+}
+
+namespace internal {
+
+// Exports of the optional operations. Each one is a class template whose
+// exporting specialization exists only when T implements the operation, and
+// AGFS_EXPORT_PLUGIN explicitly instantiates all of them: an operation the
+// plugin leaves to FileSystem's default never becomes an export, so the host
+// refuses it without crossing the boundary. Calls are qualified with T:: and
+// bind statically to the plugin's own methods.
+template<typename T, bool = (plugin_capabilities<T>() & CapWrite) != 0>
+struct WriteExport {};
+
+template<typename T>
+struct WriteExport<T, true> {
+    __attribute__((export_name("fs_write")))
+    static uint64_t fs_write(const char* path_ptr, const uint8_t* data_ptr, size_t size) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::Write);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return 0;
+        auto path = ffi::read_path(path_ptr);
+        auto data = ffi::read_data(data_ptr, size);
+        scope.bytes_in(size);
+        auto result = plugin->T::write(path, data);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error_buffer(result.unwrap_err());
+        }
+        auto& response = result.unwrap();
+        uint32_t len = response.size();
+        uint8_t* buf = ffi::result_bytes(response.data(), len);
+        return ffi::pack_u64((uint32_t)buf, len);
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapCreate) != 0>
+struct CreateExport {};
+
+template<typename T>
+struct CreateExport<T, true> {
+    __attribute__((export_name("fs_create")))
+    static char* fs_create(const char* path_ptr) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::Create);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_string("not initialized");
+        auto path = ffi::read_path(path_ptr);
+        auto result = plugin->T::create(path);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error(result.unwrap_err());
+        }
+        return nullptr;
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapMkdir) != 0>
+struct MkdirExport {};
+
+template<typename T>
+struct MkdirExport<T, true> {
+    __attribute__((export_name("fs_mkdir")))
+    static char* fs_mkdir(const char* path_ptr, uint32_t perm) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::Mkdir);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_string("not initialized");
+        auto path = ffi::read_path(path_ptr);
+        auto result = plugin->T::mkdir(path, perm);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error(result.unwrap_err());
+        }
+        return nullptr;
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapRemove) != 0>
+struct RemoveExport {};
+
+template<typename T>
+struct RemoveExport<T, true> {
+    __attribute__((export_name("fs_remove")))
+    static char* fs_remove(const char* path_ptr) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::Remove);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_string("not initialized");
+        auto path = ffi::read_path(path_ptr);
+        auto result = plugin->T::remove(path);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error(result.unwrap_err());
+        }
+        return nullptr;
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapRemoveAll) != 0>
+struct RemoveAllExport {};
+
+template<typename T>
+struct RemoveAllExport<T, true> {
+    __attribute__((export_name("fs_remove_all")))
+    static char* fs_remove_all(const char* path_ptr) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::RemoveAll);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_string("not initialized");
+        auto path = ffi::read_path(path_ptr);
+        auto result = plugin->T::remove_all(path);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error(result.unwrap_err());
+        }
+        return nullptr;
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapRename) != 0>
+struct RenameExport {};
+
+template<typename T>
+struct RenameExport<T, true> {
+    __attribute__((export_name("fs_rename")))
+    static char* fs_rename(const char* old_path_ptr, const char* new_path_ptr) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::Rename);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_string("not initialized");
+        auto old_path = ffi::read_path(old_path_ptr);
+        auto new_path = ffi::read_path(new_path_ptr);
+        auto result = plugin->T::rename(old_path, new_path);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error(result.unwrap_err());
+        }
+        return nullptr;
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapChmod) != 0>
+struct ChmodExport {};
+
+template<typename T>
+struct ChmodExport<T, true> {
+    __attribute__((export_name("fs_chmod")))
+    static char* fs_chmod(const char* path_ptr, uint32_t mode) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::Chmod);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_string("not initialized");
+        auto path = ffi::read_path(path_ptr);
+        auto result = plugin->T::chmod(path, mode);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error(result.unwrap_err());
+        }
+        return nullptr;
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapStreaming) != 0>
+struct StreamingExport {};
+
+template<typename T>
+struct StreamingExport<T, true> {
+    __attribute__((export_name("fs_open")))
+    static int64_t fs_open(const char* path_ptr, uint32_t flags) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::Open);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_error_count(Error::other("not initialized"));
+        auto path = ffi::read_path(path_ptr);
+        auto result = plugin->T::open(path, flags);
+        scope.check(result);
+        if (result.is_err()) {
+            // 0 asks the host to fall back to whole-file I/O
+            if (result.unwrap_err().kind == ErrorKind::Unsupported) {
+                return 0;
+            }
+            return ffi::result_error_count(result.unwrap_err());
+        }
+        return result.unwrap();
+    }
+
+    __attribute__((export_name("fs_read_chunk")))
+    static int64_t fs_read_chunk(int64_t handle, uint8_t* buf, uint32_t cap) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::ReadChunk);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_error_count(Error::other("not initialized"));
+        auto result = plugin->T::read_chunk(handle, Span<uint8_t>(buf, cap));
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error_count(result.unwrap_err());
+        }
+        scope.bytes_out(result.unwrap());
+        return (int64_t)result.unwrap();
+    }
+
+    __attribute__((export_name("fs_write_chunk")))
+    static int64_t fs_write_chunk(int64_t handle, const uint8_t* data, uint32_t len) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::WriteChunk);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_error_count(Error::other("not initialized"));
+        auto result = plugin->T::write_chunk(handle, Span<const uint8_t>(data, len));
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error_count(result.unwrap_err());
+        }
+        scope.bytes_in(result.unwrap());
+        return (int64_t)result.unwrap();
+    }
+
+    __attribute__((export_name("fs_close")))
+    static char* fs_close(int64_t handle) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::Close);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_string("not initialized");
+        auto result = plugin->T::close(handle);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error(result.unwrap_err());
+        }
+        return nullptr;
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapReadDirPage) != 0>
+struct ReadDirPageExport {};
+
+template<typename T>
+struct ReadDirPageExport<T, true> {
+    __attribute__((export_name("fs_readdir_page")))
+    static uint64_t fs_readdir_page(const char* path_ptr, const char* cursor_ptr, uint32_t max_entries) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::ReadDirPage);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::pack_u64(0, (uint32_t)ffi::result_string("not initialized"));
+        auto path = ffi::read_path(path_ptr);
+        auto cursor = ffi::read_path(cursor_ptr);
+        auto result = plugin->T::readdir_page(path, cursor, max_entries > 0 ? max_entries : 1);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::pack_u64(0, (uint32_t)ffi::result_error(result.unwrap_err()));
+        }
+        char* page_ptr = ffi::result_dir_page(result.unwrap());
+        return ffi::pack_u64((uint32_t)page_ptr, 0);
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapSnapshot) != 0>
+struct SnapshotExport {};
+
+template<typename T>
+struct SnapshotExport<T, true> {
+    __attribute__((export_name("plugin_snapshot")))
+    static uint64_t plugin_snapshot() {
+        ffi::begin_call();
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return 0;
+        auto result = plugin->T::snapshot();
+        if (result.is_err()) {
+            return ffi::result_error_buffer(result.unwrap_err());
+        }
+        auto& data = result.unwrap();
+        uint32_t len = data.size();
+        uint8_t* buf = ffi::result_bytes(data.data(), len);
+        return ffi::pack_u64((uint32_t)buf, len);
+    }
+
+    __attribute__((export_name("plugin_restore")))
+    static char* plugin_restore(const char* config_ptr, const uint8_t* data_ptr, uint32_t len) {
+        ffi::begin_call();
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_string("not initialized");
+        Config config = ffi::JsonParser::parse_config(config_ptr);
+        auto result = plugin->T::restore(config, Span<const uint8_t>(data_ptr, len));
+        if (result.is_err()) {
+            return ffi::result_string(result.unwrap_err().to_string());
+        }
+        return nullptr;
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapCopy) != 0>
+struct CopyExport {};
+
+template<typename T>
+struct CopyExport<T, true> {
+    __attribute__((export_name("fs_copy")))
+    static int64_t fs_copy(const char* src_ptr, const char* dst_ptr, int64_t offset, int64_t size) {
+        ffi::begin_call();
+        metrics::Scope scope(metrics::Op::Copy);
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::result_error_count(Error::other("not initialized"));
+        auto src = ffi::read_path(src_ptr);
+        auto dst = ffi::read_path(dst_ptr);
+        auto result = plugin->T::copy(src, dst, offset, size);
+        scope.check(result);
+        if (result.is_err()) {
+            return ffi::result_error_count(result.unwrap_err());
+        }
+        return (int64_t)result.unwrap();
+    }
+};
+
+template<typename T, bool = (plugin_capabilities<T>() & CapWarmup) != 0>
+struct WarmupExport {};
+
+template<typename T>
+struct WarmupExport<T, true> {
+    // Low 32 bits: 1 while work remains; high 32 bits: error string
+    __attribute__((export_name("plugin_warmup")))
+    static uint64_t plugin_warmup(uint32_t budget_us) {
+        ffi::begin_call();
+        T* plugin = PluginInstance<T>::instance;
+        if (!plugin) return ffi::pack_u64(0, (uint32_t)ffi::result_string("not initialized"));
+        auto result = plugin->T::warmup(Deadline(std::chrono::microseconds(budget_us)));
+        if (result.is_err()) {
+            return ffi::pack_u64(0, (uint32_t)ffi::result_string(result.unwrap_err().to_string()));
+        }
+        return ffi::pack_u64(result.unwrap() ? 1 : 0, 0);
+    }
+};
+
 } // namespace internal
 } // namespace agfs
 
-// Export a FileSystem implementation as a WASM plugin
+// Export a FileSystem implementation as a WASM plugin. Only the optional
+// operations PluginType overrides are exported; see plugin_capabilities().
 #define AGFS_EXPORT_PLUGIN(PluginType) \
-    static PluginType* g_plugin_instance = nullptr; \
+    static PluginType*& g_plugin_instance = agfs::internal::PluginInstance<PluginType>::instance; \
+    \
+    template struct agfs::internal::WriteExport<PluginType>; \
+    template struct agfs::internal::CreateExport<PluginType>; \
+    template struct agfs::internal::MkdirExport<PluginType>; \
+    template struct agfs::internal::RemoveExport<PluginType>; \
+    template struct agfs::internal::RemoveAllExport<PluginType>; \
+    template struct agfs::internal::RenameExport<PluginType>; \
+    template struct agfs::internal::ChmodExport<PluginType>; \
+    template struct agfs::internal::StreamingExport<PluginType>; \
+    template struct agfs::internal::ReadDirPageExport<PluginType>; \
+    template struct agfs::internal::SnapshotExport<PluginType>; \
+    template struct agfs::internal::CopyExport<PluginType>; \
+    template struct agfs::internal::WarmupExport<PluginType>; \
     \
     extern "C" { \
     \
     __attribute__((export_name("plugin_new"))) \
     int plugin_new() { \
-        g_plugin_instance = new PluginType(); \
+        agfs::ffi::begin_call(); \
+        /* Created once, before any ThreadPool worker can observe it */ \
+        if (!g_plugin_instance) g_plugin_instance = new PluginType(); \
         return 1; \
     } \
     \
     __attribute__((export_name("plugin_name"))) \
     char* plugin_name() { \
+        agfs::ffi::begin_call(); \
         if (!g_plugin_instance) return nullptr; \
-        return agfs::ffi::copy_string(g_plugin_instance->name()); \
+        return agfs::ffi::result_string(g_plugin_instance->PluginType::name()); \
+    } \
+    \
+    __attribute__((export_name("plugin_abi_version"))) \
+    uint32_t plugin_abi_version(uint32_t host_version) { \
+        return agfs::ffi::negotiate_abi(host_version); \
+    } \
+    \
+    __attribute__((export_name("plugin_concurrency"))) \
+    uint32_t plugin_concurrency() { \
+        if (!g_plugin_instance) return 0; \
+        return (uint32_t)g_plugin_instance->PluginType::concurrency(); \
+    } \
+    \
+    __attribute__((export_name("plugin_capabilities"))) \
+    uint32_t plugin_capabilities() { \
+        return agfs::plugin_capabilities<PluginType>(); \
+    } \
+    \
+    __attribute__((export_name("plugin_last_error"))) \
+    char* plugin_last_error() { \
+        return agfs::ffi::result_string(agfs::ffi::last_error()); \
+    } \
+    \
+    AGFS_METRICS_EXPORT \
+    \
+    __attribute__((export_name("plugin_free_result"))) \
+    void plugin_free_result(void* ptr) { \
+        agfs::ffi::release(ptr); \
+    } \
+    \
+    __attribute__((export_name("plugin_scratch_alloc"))) \
+    void* plugin_scratch_alloc(uint32_t size) { \
+        return agfs::ffi::scratch_alloc(size); \
     } \
     \
     __attribute__((export_name("plugin_get_readme"))) \
     char* plugin_get_readme() { \
+        agfs::ffi::begin_call(); \
         if (!g_plugin_instance) return nullptr; \
-        return agfs::ffi::copy_string(g_plugin_instance->readme()); \
+        return agfs::ffi::result_string(g_plugin_instance->PluginType::readme()); \
     } \
     \
     __attribute__((export_name("plugin_validate"))) \
     char* plugin_validate(const char* config_ptr) { \
-        if (!g_plugin_instance) return agfs::ffi::copy_string("not initialized"); \
+        agfs::ffi::begin_call(); \
+        if (!g_plugin_instance) return agfs::ffi::result_string("not initialized"); \
         agfs::Config config = agfs::ffi::JsonParser::parse_config(config_ptr); \
-        auto result = g_plugin_instance->validate(config); \
+        auto result = g_plugin_instance->PluginType::validate(config); \
         if (result.is_err()) { \
-            return agfs::ffi::copy_string(result.unwrap_err().to_string()); \
+            return agfs::ffi::result_string(result.unwrap_err().to_string()); \
         } \
         return nullptr; \
     } \
     \
     __attribute__((export_name("plugin_initialize"))) \
     char* plugin_initialize(const char* config_ptr) { \
-        if (!g_plugin_instance) return agfs::ffi::copy_string("not initialized"); \
+        agfs::ffi::begin_call(); \
+        if (!g_plugin_instance) return agfs::ffi::result_string("not initialized"); \
         agfs::Config config = agfs::ffi::JsonParser::parse_config(config_ptr); \
-        auto result = g_plugin_instance->initialize(config); \
+        auto result = g_plugin_instance->PluginType::initialize(config); \
         if (result.is_err()) { \
-            return agfs::ffi::copy_string(result.unwrap_err().to_string()); \
+            return agfs::ffi::result_string(result.unwrap_err().to_string()); \
         } \
         return nullptr; \
     } \
     \
     __attribute__((export_name("plugin_shutdown"))) \
     char* plugin_shutdown() { \
-        if (!g_plugin_instance) return agfs::ffi::copy_string("not initialized"); \
-        auto result = g_plugin_instance->shutdown(); \
+        agfs::ffi::begin_call(); \
+        if (!g_plugin_instance) return agfs::ffi::result_string("not initialized"); \
+        auto result = g_plugin_instance->PluginType::shutdown(); \
         if (result.is_err()) { \
-            return agfs::ffi::copy_string(result.unwrap_err().to_string()); \
+            return agfs::ffi::result_string(result.unwrap_err().to_string()); \
         } \
         return nullptr; \
     } \
     \
     __attribute__((export_name("fs_read"))) \
     uint64_t fs_read(const char* path_ptr, int64_t offset, int64_t size) { \
+        agfs::ffi::begin_call(); \
+        agfs::metrics::Scope scope(agfs::metrics::Op::Read); \
         if (!g_plugin_instance) return 0; \
-        std::string path = agfs::ffi::read_string(path_ptr); \
-        auto result = g_plugin_instance->read(path, offset, size); \
+        auto path = agfs::ffi::read_path(path_ptr); \
+        if (const agfs::ProvidedContent* content = g_plugin_instance->provided(path)) { \
+            /* Only the requested window is produced and copied */ \
+            size_t window = content->window(offset, size); \
+            uint8_t* buf = (uint8_t*)agfs::ffi::scratch_alloc(window); \
+            if (buf == nullptr) return 0; \
+            uint32_t n = (uint32_t)content->read(offset, agfs::Span<uint8_t>(buf, window)); \
+            scope.bytes_out(n); \
+            return agfs::ffi::pack_u64((uint32_t)buf, n); \
+        } \
+        auto result = g_plugin_instance->PluginType::read(path, offset, size); \
+        scope.check(result); \
         if (result.is_err()) { \
-            return 0; \
+            return agfs::ffi::result_error_buffer(result.unwrap_err()); \
         } \
         auto& data = result.unwrap(); \
         uint32_t len = data.size(); \
-        uint8_t* buf = (uint8_t*)agfs::ffi::wasm_malloc(len); \
-        std::memcpy(buf, data.data(), len); \
+        scope.bytes_out(len); \
+        uint8_t* buf = agfs::ffi::result_bytes(data.data(), len); \
         return agfs::ffi::pack_u64((uint32_t)buf, len); \
     } \
     \
-    __attribute__((export_name("fs_stat"))) \
-    uint64_t fs_stat(const char* path_ptr) { \
-        if (!g_plugin_instance) return agfs::ffi::pack_u64(0, (uint32_t)agfs::ffi::copy_string("not initialized")); \
-        std::string path = agfs::ffi::read_string(path_ptr); \
-        auto result = g_plugin_instance->stat(path); \
-        if (result.is_err()) { \
-            char* err_ptr = agfs::ffi::copy_string(result.unwrap_err().to_string()); \
-            return agfs::ffi::pack_u64(0, (uint32_t)err_ptr); \
+    __attribute__((export_name("fs_read_into"))) \
+    int64_t fs_read_into(const char* path_ptr, int64_t offset, uint8_t* buf, uint32_t cap) { \
+        agfs::ffi::begin_call(); \
+        agfs::metrics::Scope scope(agfs::metrics::Op::Read); \
+        if (!g_plugin_instance) return agfs::ffi::result_error_count(agfs::Error::other("not initialized")); \
+        auto path = agfs::ffi::read_path(path_ptr); \
+        if (const agfs::ProvidedContent* content = g_plugin_instance->provided(path)) { \
+            size_t n = content->read(offset, agfs::Span<uint8_t>(buf, cap)); \
+            scope.bytes_out(n); \
+            return (int64_t)n; \
         } \
-        std::string json = agfs::ffi::JsonParser::serialize_fileinfo(result.unwrap()); \
-        char* json_ptr = agfs::ffi::copy_string(json); \
-        return agfs::ffi::pack_u64((uint32_t)json_ptr, 0); \
-    } \
-    \
-    __attribute__((export_name("fs_readdir"))) \
-    uint64_t fs_readdir(const char* path_ptr) { \
-        if (!g_plugin_instance) return agfs::ffi::pack_u64(0, (uint32_t)agfs::ffi::copy_string("not initialized")); \
-        std::string path = agfs::ffi::read_string(path_ptr); \
-        auto result = g_plugin_instance->readdir(path); \
+        auto result = g_plugin_instance->PluginType::read_into(path, offset, agfs::Span<uint8_t>(buf, cap)); \
+        scope.check(result); \
         if (result.is_err()) { \
-            char* err_ptr = agfs::ffi::copy_string(result.unwrap_err().to_string()); \
-            return agfs::ffi::pack_u64(0, (uint32_t)err_ptr); \
+            return agfs::ffi::result_error_count(result.unwrap_err()); \
         } \
-        std::string json = agfs::ffi::JsonParser::serialize_fileinfo_array(result.unwrap()); \
-        char* json_ptr = agfs::ffi::copy_string(json); \
-        return agfs::ffi::pack_u64((uint32_t)json_ptr, 0); \
+        scope.bytes_out(result.unwrap()); \
+        return (int64_t)result.unwrap(); \
     } \
     \
-    __attribute__((export_name("fs_write"))) \
-    uint64_t fs_write(const char* path_ptr, const uint8_t* data_ptr, size_t size) { \
-        if (!g_plugin_instance) return 0; \
-        std::string path = agfs::ffi::read_string(path_ptr); \
-        std::vector<uint8_t> data(data_ptr, data_ptr + size); \
-        auto result = g_plugin_instance->write(path, data); \
-        if (result.is_err()) { \
-            return 0; \
-        } \
-        auto& response = result.unwrap(); \
-        uint32_t len = response.size(); \
-        uint8_t* buf = (uint8_t*)agfs::ffi::wasm_malloc(len); \
-        std::memcpy(buf, response.data(), len); \
-        return agfs::ffi::pack_u64((uint32_t)buf, len); \
-    } \
-    \
-    __attribute__((export_name("fs_create"))) \
-    char* fs_create(const char* path_ptr) { \
-        if (!g_plugin_instance) return agfs::ffi::copy_string("not initialized"); \
-        std::string path = agfs::ffi::read_string(path_ptr); \
-        auto result = g_plugin_instance->create(path); \
-        if (result.is_err()) { \
-            return agfs::ffi::copy_string(result.unwrap_err().to_string()); \
-        } \
-        return nullptr; \
-    } \
-    \
-    __attribute__((export_name("fs_mkdir"))) \
-    char* fs_mkdir(const char* path_ptr, uint32_t perm) { \
-        if (!g_plugin_instance) return agfs::ffi::copy_string("not initialized"); \
-        std::string path = agfs::ffi::read_string(path_ptr); \
-        auto result = g_plugin_instance->mkdir(path, perm); \
-        if (result.is_err()) { \
-            return agfs::ffi::copy_string(result.unwrap_err().to_string()); \
-        } \
-        return nullptr; \
-    } \
-    \
-    __attribute__((export_name("fs_remove"))) \
-    char* fs_remove(const char* path_ptr) { \
-        if (!g_plugin_instance) return agfs::ffi::copy_string("not initialized"); \
-        std::string path = agfs::ffi::read_string(path_ptr); \
-        auto result = g_plugin_instance->remove(path); \
-        if (result.is_err()) { \
-            return agfs::ffi::copy_string(result.unwrap_err().to_string()); \
+    __attribute__((export_name("fs_stat"))) \
+    uint64_t fs_stat(const char* path_ptr) { \
+        agfs::ffi::begin_call(); \
+        agfs::metrics::Scope scope(agfs::metrics::Op::Stat); \
+        if (!g_plugin_instance) return agfs::ffi::pack_u64(0, (uint32_t)agfs::ffi::result_string("not initialized")); \
+        auto path = agfs::ffi::read_path(path_ptr); \
+        if (const agfs::ffi::EncodedResult* encoded = g_plugin_instance->PluginType::encoded_stat(path)) { \
+            return agfs::ffi::pack_u64((uint32_t)encoded->emit(), 0); \
         } \
-        return nullptr; \
-    } \
-    \
-    __attribute__((export_name("fs_remove_all"))) \
-    char* fs_remove_all(const char* path_ptr) { \
-        if (!g_plugin_instance) return agfs::ffi::copy_string("not initialized"); \
-        std::string path = agfs::ffi::read_string(path_ptr); \
-        auto result = g_plugin_instance->remove_all(path); \
+        auto result = g_plugin_instance->PluginType::stat(path); \
+        scope.check(result); \
         if (result.is_err()) { \
-            return agfs::ffi::copy_string(result.unwrap_err().to_string()); \
+            return agfs::ffi::pack_u64(0, (uint32_t)agfs::ffi::result_error(result.unwrap_err())); \
         } \
-        return nullptr; \
+        char* json_ptr = agfs::ffi::result_stat(result.unwrap()); \
+        return agfs::ffi::pack_u64((uint32_t)json_ptr, 0); \
     } \
     \
-    __attribute__((export_name("fs_rename"))) \
-    char* fs_rename(const char* old_path_ptr, const char* new_path_ptr) { \
-        if (!g_plugin_instance) return agfs::ffi::copy_string("not initialized"); \
-        std::string old_path = agfs::ffi::read_string(old_path_ptr); \
-        std::string new_path = agfs::ffi::read_string(new_path_ptr); \
-        auto result = g_plugin_instance->rename(old_path, new_path); \
-        if (result.is_err()) { \
-            return agfs::ffi::copy_string(result.unwrap_err().to_string()); \
+    __attribute__((export_name("fs_readdir"))) \
+    uint64_t fs_readdir(const char* path_ptr) { \
+        agfs::ffi::begin_call(); \
+        agfs::metrics::Scope scope(agfs::metrics::Op::ReadDir); \
+        if (!g_plugin_instance) return agfs::ffi::pack_u64(0, (uint32_t)agfs::ffi::result_string("not initialized")); \
+        auto path = agfs::ffi::read_path(path_ptr); \
+        if (const agfs::ffi::EncodedResult* encoded = g_plugin_instance->PluginType::encoded_readdir(path)) { \
+            return agfs::ffi::pack_u64((uint32_t)encoded->emit(), 0); \
         } \
-        return nullptr; \
-    } \
-    \
-    __attribute__((export_name("fs_chmod"))) \
-    char* fs_chmod(const char* path_ptr, uint32_t mode) { \
-        if (!g_plugin_instance) return agfs::ffi::copy_string("not initialized"); \
-        std::string path = agfs::ffi::read_string(path_ptr); \
-        auto result = g_plugin_instance->chmod(path, mode); \
+        auto result = g_plugin_instance->PluginType::readdir(path); \
+        scope.check(result); \
         if (result.is_err()) { \
-            return agfs::ffi::copy_string(result.unwrap_err().to_string()); \
+            return agfs::ffi::pack_u64(0, (uint32_t)agfs::ffi::result_error(result.unwrap_err())); \
         } \
-        return nullptr; \
+        char* json_ptr = agfs::ffi::result_readdir(result.unwrap()); \
+        return agfs::ffi::pack_u64((uint32_t)json_ptr, 0); \
     } \
     \
     } /* extern "C" */
@@ -2,16 +2,41 @@
 #define AGFS_FFI_H
 
 #include "agfs_types.h"
-#include "json.hpp"
+#include "agfs_arena.h"
+#include "agfs_wire.h"
+#include "agfs_json.h"
 #include <cstring>
 #include <cstdlib>
+#include <string_view>
 
+// The SDK's own JSON (agfs_json.h) needs no third-party code. Plugins that
+// use nlohmann/json themselves define AGFS_NLOHMANN_JSON to get it as ::json,
+// as earlier SDKs always did.
+#if defined(AGFS_NLOHMANN_JSON)
+#include "json.hpp"
 using json = nlohmann::json;
+#endif
 
 namespace agfs {
 namespace ffi {
 
 // Memory management functions
+//
+// Ownership protocol between the host and the plugin:
+// - Buffers the plugin returns to the host (results, error strings) are
+//   allocated with wasm_malloc. The host copies them out and hands them back
+//   through the plugin_free_result export.
+// - Buffers the host allocates in linear memory for arguments (paths, config,
+//   write payloads) are released by the host through plugin_free_result once
+//   the call returns.
+// - Buffers returned by host_fs_* imports belong to the plugin. HostFS copies
+//   them out and frees them before returning to the caller.
+//
+// Results and host_fs_* buffers are normally carved out of the per-call arena
+// (see call_arena()), which makes releasing them a no-op. The arena is reset
+// when the next export is entered, after the host has copied the result, and
+// HostFS rewinds it after every import call (see ArenaScope), so reading
+// many host files within one export reuses the same space.
 inline void* wasm_malloc(size_t size) {
     return malloc(size);
 }
@@ -20,6 +45,163 @@ inline void wasm_free(void* ptr) {
     free(ptr);
 }
 
+// ABI versions negotiated through the plugin_abi_version export.
+// Hosts that never call it speak version 1.
+constexpr uint32_t kAbiJson = 1;            // FileInfo travels as JSON
+constexpr uint32_t kAbiBinaryFileInfo = 2;  // FileInfo travels in the agfs_wire.h format
+constexpr uint32_t kAbiStringLength = 3;    // Strings carry a u32 length prefix
+constexpr uint32_t kAbiErrorCodes = 4;      // Failed exports return ErrorKind codes
+constexpr uint32_t kAbiVersion = kAbiErrorCodes;
+
+inline uint32_t& abi_version() {
+    static uint32_t version = kAbiJson;
+    return version;
+}
+
+// Agree on the highest version both sides support
+inline uint32_t negotiate_abi(uint32_t host_version) {
+    abi_version() = host_version < kAbiVersion ? host_version : kAbiVersion;
+    if (abi_version() < kAbiJson) {
+        abi_version() = kAbiJson;
+    }
+    return abi_version();
+}
+
+inline bool binary_fileinfo() {
+    return abi_version() >= kAbiBinaryFileInfo;
+}
+
+// Strings crossing the boundary in either direction are laid out as
+// u32 length, bytes, NUL, and passed as a pointer to the bytes. Writers on
+// both sides always add the prefix; readers trust it from kAbiStringLength
+// on and fall back to scanning for the NUL otherwise.
+inline bool string_lengths() {
+    return abi_version() >= kAbiStringLength;
+}
+
+// Called on entry to every exported call
+inline void begin_call() {
+    call_arena().reset();
+}
+
+// Release a buffer that crossed the boundary, whichever allocator it came from
+inline void release(void* ptr) {
+    if (ptr == nullptr || call_arena().owns(ptr)) {
+        return;
+    }
+    wasm_free(ptr);
+}
+
+// Allocate a scratch buffer that lives until the next exported call
+inline void* scratch_alloc(size_t size) {
+    return call_arena().allocate(size);
+}
+
+// Copy a result string into the call arena for the host to read
+inline char* result_string(std::string_view str) {
+    if (str.empty()) {
+        return nullptr;
+    }
+    return call_arena().copy_string_with_length(str.data(), str.size());
+}
+
+// Errors of fs_* exports
+//
+// From kAbiErrorCodes on a failed export returns an error code instead of a
+// message: the ErrorKind value, plus kErrorHasMessage when the error carries a
+// message of its own, which the host then fetches through plugin_last_error.
+// Codes are below kErrorCodeLimit, so they never collide with a pointer. Where
+// an export returns a pointer the code takes its place, where it returns a
+// count the code is negated, and where it packs a buffer as (ptr, len) the
+// code goes in len with ptr 0. Older hosts get the message string, or just -1
+// or 0, as before.
+constexpr uint32_t kErrorHasMessage = 0x80;
+constexpr uint32_t kErrorCodeLimit = 0x100;
+
+inline bool error_codes() {
+    return abi_version() >= kAbiErrorCodes;
+}
+
+// Message of the last failed export that had one. Threaded builds
+// (AGFS_THREADS) keep one per thread, like call_arena(), so a worker's error
+// never replaces the one the host is about to fetch.
+inline std::string& last_error() {
+#if defined(AGFS_THREADS)
+    static thread_local std::string message;
+#else
+    static std::string message;
+#endif
+    return message;
+}
+
+inline uint32_t error_code(const Error& err) {
+    uint32_t code = (uint32_t)err.kind;
+    if (err.has_detail()) {
+        last_error() = err.message;
+        code |= kErrorHasMessage;
+    }
+    return code;
+}
+
+// Error result of an export returning a message pointer
+inline char* result_error(const Error& err) {
+    if (error_codes()) {
+        return reinterpret_cast<char*>((uintptr_t)error_code(err));
+    }
+    return result_string(err.to_string());
+}
+
+// Error result of an export returning a count or handle
+inline int64_t result_error_count(const Error& err) {
+    return error_codes() ? -(int64_t)error_code(err) : -1;
+}
+
+// Errors of host_fs_* imports
+//
+// From kAbiErrorCodes on the host reports ErrorKind codes back the same way:
+// an error message it returns carries the code in the u32 ahead of its length
+// prefix, a count or handle is the negated code, a (ptr, len) buffer has the
+// code in len with ptr 0, and a result pointer that fails without a message
+// is the code itself. Older hosts send the message, -1 or 0 alone.
+
+// The kind of a code the host sent; codes this SDK does not know are Other
+inline ErrorKind host_error_kind(uint32_t code) {
+    code &= ~kErrorHasMessage;
+    if (code < (uint32_t)ErrorKind::NotFound || code > (uint32_t)ErrorKind::Other) {
+        return ErrorKind::Other;
+    }
+    return (ErrorKind)code;
+}
+
+// Error of an import that failed with code (0 if it sent none). what is the
+// message when the host sent no code, or one that says no more than Io or
+// Other.
+inline Error host_error(uint64_t code, const char* what) {
+    if (!error_codes() || code == 0 || code >= kErrorCodeLimit) {
+        return Error::io(what);
+    }
+    ErrorKind kind = host_error_kind((uint32_t)code);
+    if (kind == ErrorKind::Io || kind == ErrorKind::Other) {
+        return Error(kind, what);
+    }
+    return Error(kind);
+}
+
+// Error of an import that returned a negative count or handle
+inline Error host_error_count(int64_t n, const char* what) {
+    return host_error(n < 0 ? (uint64_t)0 - (uint64_t)n : 0, what);
+}
+
+// Copy a string argument for a host_fs_* import into the call arena
+inline const char* pass_string(std::string_view str) {
+    return call_arena().copy_string_with_length(str.data(), str.size());
+}
+
+// Copy a result buffer into the call arena for the host to read
+inline uint8_t* result_bytes(const uint8_t* data, size_t len) {
+    return call_arena().copy_bytes(data, len);
+}
+
 // String helpers
 inline char* copy_string(const std::string& str) {
     if (str.empty()) {
@@ -31,11 +213,74 @@ inline char* copy_string(const std::string& str) {
     return buf;
 }
 
-inline std::string read_string(const char* ptr) {
+// View of a string the host wrote into linear memory
+inline std::string_view read_view(const char* ptr) {
     if (ptr == nullptr) {
+        return std::string_view();
+    }
+    if (string_lengths()) {
+        uint32_t len;
+        std::memcpy(&len, ptr - 4, 4);
+        return std::string_view(ptr, len);
+    }
+    return std::string_view(ptr);
+}
+
+inline std::string read_string(const char* ptr) {
+    return std::string(read_view(ptr));
+}
+
+// Path and write payload arguments as the FileSystem interface takes them
+// (see PathArg and DataArg)
+#if defined(AGFS_STRING_VIEW_API)
+inline std::string_view read_path(const char* ptr) {
+    return read_view(ptr);
+}
+
+inline Span<const uint8_t> read_data(const uint8_t* ptr, size_t len) {
+    return Span<const uint8_t>(ptr, len);
+}
+#else
+inline std::string read_path(const char* ptr) {
+    return read_string(ptr);
+}
+
+inline std::vector<uint8_t> read_data(const uint8_t* ptr, size_t len) {
+    return std::vector<uint8_t>(ptr, ptr + len);
+}
+#endif
+
+// Copy a NUL-terminated string the host returned and free its buffer
+inline std::string take_string(uint32_t ptr) {
+    if (ptr == 0) {
         return "";
     }
-    return std::string(ptr);
+    char* str = reinterpret_cast<char*>(ptr);
+    std::string result(read_view(str));
+    release(str);
+    return result;
+}
+
+// Copy an error message the host returned and free it
+inline Error take_error(uint32_t ptr) {
+    ErrorKind kind = ErrorKind::Other;
+    if (error_codes()) {
+        uint32_t code;
+        std::memcpy(&code, reinterpret_cast<const char*>(ptr) - 8, 4);
+        kind = host_error_kind(code);
+    }
+    return Error(kind, take_string(ptr));
+}
+
+// Copy a buffer the host returned and free it
+inline std::vector<uint8_t> take_bytes(uint32_t ptr, uint32_t len) {
+    if (ptr == 0) {
+        return std::vector<uint8_t>();
+    }
+    uint8_t* data = reinterpret_cast<uint8_t*>(ptr);
+    std::vector<uint8_t> result(data, data + len);
+    release(data);
+    return result;
 }
 
 // Pack two u32 into u64
@@ -43,113 +288,378 @@ inline uint64_t pack_u64(uint32_t low, uint32_t high) {
     return ((uint64_t)high << 32) | (uint64_t)low;
 }
 
+// Error result of an export returning a (ptr, len) buffer
+inline uint64_t result_error_buffer(const Error& err) {
+    return error_codes() ? pack_u64(0, error_code(err)) : 0;
+}
+
 // Unpack u64 to two u32
 inline void unpack_u64(uint64_t packed, uint32_t& low, uint32_t& high) {
     low = (uint32_t)(packed & 0xFFFFFFFF);
     high = (uint32_t)((packed >> 32) & 0xFFFFFFFF);
 }
 
-// JSON parsing helpers using nlohmann/json
+// JSON encoding of config and FileInfo for hosts that negotiate kAbiJson
 class JsonParser {
 public:
+    // Config object; strings and booleans are kept as text and numbers as
+    // written ("8080" stays "8080"). Nested values are ignored.
     static Config parse_config(const char* json_str) {
         Config config;
         if (json_str == nullptr) {
             return config;
         }
 
-        auto j = json::parse(json_str, nullptr, false);
-        if (j.is_discarded() || !j.is_object()) {
+        json::Reader reader(read_view(json_str));
+        if (!reader.begin_object()) {
             return config;
         }
-
-        for (auto& [key, value] : j.items()) {
-            if (value.is_string()) {
-                config.values[key] = value.get<std::string>();
-            } else if (value.is_number()) {
-                config.values[key] = std::to_string(value.get<double>());
-            } else if (value.is_boolean()) {
-                config.values[key] = value.get<bool>() ? "true" : "false";
+        std::string key;
+        while (reader.next_key(key)) {
+            switch (reader.peek()) {
+                case json::Reader::Type::String:
+                    reader.read_string(config.values[key]);
+                    break;
+                case json::Reader::Type::Number: {
+                    std::string_view number;
+                    if (reader.read_number(number)) {
+                        config.values[key] = std::string(number);
+                    }
+                    break;
+                }
+                case json::Reader::Type::Bool: {
+                    bool b = false;
+                    if (reader.read_bool(b)) {
+                        config.values[key] = b ? "true" : "false";
+                    }
+                    break;
+                }
+                default:
+                    reader.skip_value();
             }
         }
-
+        if (!reader.ok()) {
+            return Config();
+        }
         return config;
     }
 
-    static std::string serialize_fileinfo(const FileInfo& info) {
-        json j = {
-            {"Name", info.name},
-            {"Size", info.size},
-            {"Mode", info.mode},
-            {"ModTime", "0001-01-01T00:00:00Z"},
-            {"IsDir", info.is_dir}
-        };
-
+    template<typename Sink>
+    static void write_fileinfo(json::Writer<Sink>& w, const FileInfo& info) {
+        char mod_time[json::kTimestampSize];
+        json::format_timestamp(info.mod_time, mod_time);
+        w.begin_object();
+        w.key("Name");
+        w.value(info.name);
+        w.key("Size");
+        w.value(info.size);
+        w.key("Mode");
+        w.value(info.mode);
+        w.key("ModTime");
+        w.value(std::string_view(mod_time, sizeof(mod_time)));
+        w.key("IsDir");
+        w.value(info.is_dir);
         if (info.meta.has_value()) {
-            auto meta_content = json::parse(info.meta->content, nullptr, false);
-            j["Meta"] = {
-                {"Name", info.meta->name},
-                {"Type", info.meta->type},
-                {"Content", meta_content.is_discarded() ? json{} : meta_content}
-            };
+            w.key("Meta");
+            w.begin_object();
+            w.key("Name");
+            w.value(info.meta->name);
+            w.key("Type");
+            w.value(info.meta->type);
+            w.key("Content");
+            if (json::valid(info.meta->content)) {
+                w.raw(info.meta->content);
+            } else {
+                w.null();
+            }
+            w.end_object();
         }
-
-        return j.dump();
+        w.end_object();
     }
 
-    static std::string serialize_fileinfo_array(const std::vector<FileInfo>& infos) {
-        json j = json::array();
+    template<typename Sink>
+    static void write_fileinfo_array(json::Writer<Sink>& w, const std::vector<FileInfo>& infos) {
+        w.begin_array();
         for (const auto& info : infos) {
-            j.push_back({
-                {"Name", info.name},
-                {"Size", info.size},
-                {"Mode", info.mode},
-                {"ModTime", "0001-01-01T00:00:00Z"},
-                {"IsDir", info.is_dir}
-            });
+            write_fileinfo(w, info);
         }
-        return j.dump();
+        w.end_array();
+    }
+
+    static std::string serialize_fileinfo(const FileInfo& info) {
+        std::string out;
+        json::StringSink sink(out);
+        json::Writer<json::StringSink> w(sink);
+        write_fileinfo(w, info);
+        return out;
+    }
+
+    static std::string serialize_fileinfo_array(const std::vector<FileInfo>& infos) {
+        std::string out;
+        json::StringSink sink(out);
+        json::Writer<json::StringSink> w(sink);
+        write_fileinfo_array(w, infos);
+        return out;
     }
 
     static FileInfo parse_fileinfo(const std::string& json_str) {
-        FileInfo info;
+        return parse_fileinfo(json_str.c_str());
+    }
 
-        auto j = json::parse(json_str, nullptr, false);
-        if (j.is_discarded() || !j.is_object()) {
+    static FileInfo parse_fileinfo(const char* json_str) {
+        FileInfo info;
+        if (json_str == nullptr) {
             return info;
         }
-
-        info.name = j.value("Name", "");
-        info.size = j.value("Size", 0);
-        info.mode = j.value("Mode", 0);
-        info.is_dir = j.value("IsDir", false);
-
+        json::Reader reader(read_view(json_str));
+        if (reader.peek() != json::Reader::Type::Object || !read_fileinfo(reader, info)) {
+            return FileInfo();
+        }
         return info;
     }
 
     static std::vector<FileInfo> parse_fileinfo_array(const std::string& json_str) {
-        std::vector<FileInfo> infos;
+        return parse_fileinfo_array(json_str.c_str());
+    }
 
-        auto j = json::parse(json_str, nullptr, false);
-        if (j.is_discarded() || !j.is_array()) {
+    static std::vector<FileInfo> parse_fileinfo_array(const char* json_str) {
+        std::vector<FileInfo> infos;
+        if (json_str == nullptr) {
             return infos;
         }
+        json::Reader reader(read_view(json_str));
+        if (reader.peek() != json::Reader::Type::Array) {
+            return infos;
+        }
+        reader.begin_array();
+        while (reader.next_element()) {
+            if (reader.peek() != json::Reader::Type::Object) {
+                reader.skip_value();
+                continue;
+            }
+            FileInfo info;
+            if (!read_fileinfo(reader, info)) {
+                break;
+            }
+            infos.push_back(std::move(info));
+        }
+        if (!reader.ok()) {
+            return std::vector<FileInfo>();
+        }
+        return infos;
+    }
 
-        for (const auto& item : j) {
-            if (!item.is_object()) continue;
+private:
+    // Decode the MetaData object at reader. Content keeps its JSON text.
+    static bool read_meta(json::Reader& reader, MetaData& meta) {
+        reader.begin_object();
+        std::string key;
+        while (reader.next_key(key)) {
+            json::Reader::Type type = reader.peek();
+            if (key == "Name" && type == json::Reader::Type::String) {
+                reader.read_string(meta.name);
+            } else if (key == "Type" && type == json::Reader::Type::String) {
+                reader.read_string(meta.type);
+            } else if (key == "Content" && type == json::Reader::Type::Object) {
+                std::string_view content;
+                if (reader.raw_value(content)) {
+                    meta.content = std::string(content);
+                }
+            } else {
+                reader.skip_value();
+            }
+        }
+        return reader.ok();
+    }
 
-            FileInfo info;
-            info.name = item.value("Name", "");
-            info.size = item.value("Size", 0);
-            info.mode = item.value("Mode", 0);
-            info.is_dir = item.value("IsDir", false);
-            infos.push_back(info);
+    // Decode the FileInfo object at reader; unknown members are skipped
+    static bool read_fileinfo(json::Reader& reader, FileInfo& info) {
+        reader.begin_object();
+        std::string key;
+        std::string text;
+        while (reader.next_key(key)) {
+            if (key == "Name" && reader.peek() == json::Reader::Type::String) {
+                reader.read_string(info.name);
+            } else if (key == "Size" && reader.peek() == json::Reader::Type::Number) {
+                reader.read_int(info.size);
+            } else if (key == "Mode" && reader.peek() == json::Reader::Type::Number) {
+                int64_t mode = 0;
+                reader.read_int(mode);
+                info.mode = (uint32_t)mode;
+            } else if (key == "IsDir" && reader.peek() == json::Reader::Type::Bool) {
+                reader.read_bool(info.is_dir);
+            } else if (key == "ModTime" && reader.peek() == json::Reader::Type::String) {
+                if (reader.read_string(text) && !json::parse_timestamp(text, info.mod_time)) {
+                    info.mod_time = 0;
+                }
+            } else if (key == "Meta" && reader.peek() == json::Reader::Type::Object) {
+                MetaData meta;
+                if (!read_meta(reader, meta)) {
+                    return false;
+                }
+                // Go sends an empty MetaData for "none"
+                if (!meta.name.empty() || !meta.type.empty() || !meta.content.empty()) {
+                    info.meta = std::move(meta);
+                }
+            } else {
+                reader.skip_value();
+            }
         }
+        return reader.ok();
+    }
+};
 
-        return infos;
+// Encode a JSON value straight into the call arena as a result string. The
+// value is measured first, so the only allocation is one arena bump.
+template<typename Emit>
+inline char* result_json(Emit&& emit) {
+    json::SizeSink measure;
+    json::Writer<json::SizeSink> counter(measure);
+    emit(counter);
+
+    char* buf = static_cast<char*>(call_arena().allocate(measure.size + 5, 4));
+    if (buf == nullptr) {
+        return nullptr;
     }
+    uint32_t prefix = (uint32_t)measure.size;
+    std::memcpy(buf, &prefix, 4);
+    json::BufferSink sink(buf + 4);
+    json::Writer<json::BufferSink> writer(sink);
+    emit(writer);
+    buf[4 + measure.size] = '\0';
+    return buf + 4;
+}
+
+// Encode a stat result for the host in the negotiated format
+inline char* result_stat(const FileInfo& info) {
+    if (!binary_fileinfo()) {
+        return result_json([&info](auto& w) { JsonParser::write_fileinfo(w, info); });
+    }
+    uint8_t* buf = static_cast<uint8_t*>(call_arena().allocate(wire::encoded_size(info), 1));
+    if (buf != nullptr) {
+        wire::encode(buf, info);
+    }
+    return reinterpret_cast<char*>(buf);
+}
+
+// Encode a readdir result for the host in the negotiated format
+inline char* result_readdir(const std::vector<FileInfo>& infos) {
+    if (!binary_fileinfo()) {
+        return result_json([&infos](auto& w) { JsonParser::write_fileinfo_array(w, infos); });
+    }
+    uint8_t* buf = static_cast<uint8_t*>(call_arena().allocate(wire::encoded_size(infos), 1));
+    if (buf != nullptr) {
+        wire::encode(buf, infos);
+    }
+    return reinterpret_cast<char*>(buf);
+}
+
+// A stat or readdir result encoded once and returned many times. It keeps
+// the bytes result_stat()/result_readdir() produced, length prefix included,
+// and the ABI version they were encoded for; emit() copies them into the call
+// arena, which costs one memcpy instead of a fresh encoding.
+class EncodedResult {
+public:
+    static EncodedResult stat(const FileInfo& info) {
+        return EncodedResult(result_stat(info));
+    }
+
+    static EncodedResult readdir(const std::vector<FileInfo>& infos) {
+        return EncodedResult(result_readdir(infos));
+    }
+
+    EncodedResult() = default;
+
+    // Whether the bytes are there and match the negotiated ABI version
+    bool valid() const {
+        return !bytes_.empty() && abi_ == abi_version();
+    }
+
+    void clear() {
+        bytes_.clear();
+    }
+
+    // Copy the result into the call arena and return it as result_stat() or
+    // result_readdir() would
+    char* emit() const {
+        char* buf = static_cast<char*>(call_arena().allocate(bytes_.size(), 4));
+        if (buf == nullptr) {
+            return nullptr;
+        }
+        std::memcpy(buf, bytes_.data(), bytes_.size());
+        return buf + offset_;
+    }
+
+private:
+    explicit EncodedResult(const char* result) : abi_(abi_version()) {
+        if (result == nullptr) {
+            return;
+        }
+        const uint8_t* start = reinterpret_cast<const uint8_t*>(result);
+        size_t len;
+        if (binary_fileinfo()) {
+            len = wire::peek_total_len(start);
+        } else {
+            // JSON: u32 length, the text, NUL
+            uint32_t text_len;
+            std::memcpy(&text_len, result - 4, 4);
+            start -= 4;
+            len = text_len + 5;
+            offset_ = 4;
+        }
+        bytes_.assign(start, start + len);
+    }
+
+    std::vector<uint8_t> bytes_;
+    uint32_t offset_ = 0; // Where the result pointer points within bytes_
+    uint32_t abi_ = 0;
 };
 
+// Decode a stat result the host returned in the negotiated format
+inline FileInfo parse_stat(const char* data) {
+    if (!binary_fileinfo()) {
+        return JsonParser::parse_fileinfo(data);
+    }
+    const uint8_t* buf = reinterpret_cast<const uint8_t*>(data);
+    wire::Decoder decoder(buf, wire::peek_total_len(buf));
+    wire::FileInfoView view;
+    if (!decoder.next(view)) {
+        return FileInfo();
+    }
+    return view.to_fileinfo();
+}
+
+// Decode a readdir result the host returned in the negotiated format
+inline std::vector<FileInfo> parse_readdir(const char* data) {
+    if (!binary_fileinfo()) {
+        return JsonParser::parse_fileinfo_array(data);
+    }
+    const uint8_t* buf = reinterpret_cast<const uint8_t*>(data);
+    wire::Decoder decoder(buf, wire::peek_total_len(buf));
+    std::vector<FileInfo> infos;
+    infos.reserve(decoder.count());
+    wire::FileInfoView view;
+    while (decoder.next(view)) {
+        infos.push_back(view.to_fileinfo());
+    }
+    return infos;
+}
+
+// Encode a readdir page for the host. Paged listings are only exchanged once
+// ABI version 2 has been negotiated, so pages are always binary.
+inline char* result_dir_page(const DirPage& page) {
+    uint8_t* buf = static_cast<uint8_t*>(call_arena().allocate(wire::encoded_size(page), 1));
+    if (buf != nullptr) {
+        wire::encode(buf, page);
+    }
+    return reinterpret_cast<char*>(buf);
+}
+
+// Decode a readdir page the host returned
+inline DirPage parse_dir_page(const char* data) {
+    return wire::decode_page(reinterpret_cast<const uint8_t*>(data));
+}
+
 } // namespace ffi
 } // namespace agfs
 
@@ -2,9 +2,42 @@
 #define AGFS_FILESYSTEM_H
 
 #include "agfs_types.h"
+#include "agfs_ffi.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <map>
 
 namespace agfs {
 
+// Writes bytes [offset, offset + out.size()) of a provided file into out and
+// returns how many it wrote; see FileSystem::provide()
+using ContentProvider = std::function<size_t(int64_t offset, Span<uint8_t> out)>;
+
+// A file served by a ContentProvider
+class ProvidedContent {
+public:
+    int64_t size;
+    ContentProvider provider;
+
+    // Bytes a read of size (-1 for the rest) at offset returns
+    size_t window(int64_t offset, int64_t count) const {
+        if (offset < 0 || offset >= size) {
+            return 0;
+        }
+        int64_t left = size - offset;
+        return (size_t)(count < 0 || count > left ? left : count);
+    }
+
+    // Read at offset into out, asking the provider for that window only
+    size_t read(int64_t offset, Span<uint8_t> out) const {
+        size_t n = window(offset, (int64_t)out.size());
+        return n == 0 ? 0 : provider(offset, out.subspan(0, n));
+    }
+};
+
 // FileSystem base class that plugin developers should implement
 class FileSystem {
 public:
@@ -18,6 +51,14 @@ public:
         return "No documentation available";
     }
 
+    // Declare whether the host may run several instances of this module in
+    // parallel. Each instance is a separate copy of the plugin with its own
+    // memory, and every instance receives the same initialize() config. Keep
+    // the default (Exclusive) if any state is mutated after initialize().
+    virtual Concurrency concurrency() const {
+        return Concurrency::Exclusive;
+    }
+
     // Validate the configuration before initialization
     virtual Result<void> validate(const Config& config) {
         (void)config; // unused
@@ -35,59 +76,228 @@ public:
         return Result<void>();
     }
 
+    // Startup snapshots
+    //
+    // A plugin whose initialize() builds expensive state, such as an index or
+    // a routing table, can override both methods below. After initialize()
+    // the host takes a snapshot() and, when it has a cache directory, stores
+    // it keyed by module and config; later loads with the same config call
+    // restore() instead of initialize(). Pooled instances restore from the
+    // first instance's snapshot. Content providers are not part of a
+    // snapshot, so restore() must provide() them again.
+
+    // Serialize the state initialize() built. An empty result stores nothing.
+    virtual Result<std::vector<uint8_t>> snapshot() {
+        return Error::unsupported();
+    }
+
+    // Rebuild the state from snapshot() bytes taken under the same config. On
+    // error the host calls initialize() instead.
+    virtual Result<void> restore(const Config& config, Span<const uint8_t> data) {
+        (void)config; (void)data; // unused
+        return Error::unsupported();
+    }
+
+    // Background warm-up
+    //
+    // A plugin whose state is slow to build, such as an index over a host
+    // directory, can keep initialize() cheap and build it here instead. Once
+    // initialize() or restore() returns, the host calls warmup() over and
+    // over between the calls it serves, one at a time like any other call,
+    // until it returns false (done) or an error (the plugin keeps serving
+    // without the rest). Each call should return once deadline expires.
+    // Paths the state does not cover yet must still be served, typically
+    // straight through HostFS (see HostWalk). Pooled instances warm up on
+    // their own, and the startup snapshot is taken before warm-up starts.
+    virtual Result<bool> warmup(const Deadline& deadline) {
+        (void)deadline; // unused
+        return false;
+    }
+
     // Read data from a file
-    virtual Result<std::vector<uint8_t>> read(const std::string& path, int64_t offset, int64_t size) {
+    virtual Result<std::vector<uint8_t>> read(PathArg path, int64_t offset, int64_t size) {
         (void)path; (void)offset; (void)size; // unused
         return Error::read_only();
     }
 
+    // Read data from a file directly into a caller-supplied buffer, returning
+    // the number of bytes written. The default forwards to read(); override it
+    // to produce the bytes in place and skip the intermediate vector.
+    virtual Result<size_t> read_into(PathArg path, int64_t offset, Span<uint8_t> out) {
+        auto result = read(path, offset, (int64_t)out.size());
+        if (result.is_err()) {
+            return result.unwrap_err();
+        }
+        const auto& data = result.unwrap();
+        size_t n = std::min(data.size(), out.size());
+        if (n > 0) {
+            std::memcpy(out.data(), data.data(), n);
+        }
+        return n;
+    }
+
+    // Content providers
+    //
+    // Reads of a path registered with provide() are answered by its provider,
+    // which is only asked for the requested window, before read() and
+    // read_into() are consulted. Register providers from initialize();
+    // stat() and readdir() still describe the file.
+
+    // Serve path from provider as a file of the given size
+    void provide(std::string_view path, int64_t size, ContentProvider provider) {
+        provided_[std::string(path)] = ProvidedContent{size, std::move(provider)};
+    }
+
+    // Serve path from fixed content, which must outlive the plugin
+    void provide(std::string_view path, Span<const uint8_t> content) {
+        provide(path, (int64_t)content.size(), [content](int64_t offset, Span<uint8_t> out) {
+            auto range = serve_range(content, offset, (int64_t)out.size());
+            std::memcpy(out.data(), range.data(), range.size());
+            return range.size();
+        });
+    }
+
+    // The provider registered for path, or nullptr
+    const ProvidedContent* provided(std::string_view path) const {
+        auto it = provided_.find(path);
+        return it == provided_.end() ? nullptr : &it->second;
+    }
+
+    // Pre-encoded metadata
+    //
+    // The fs_stat and fs_readdir exports first ask encoded_stat() and
+    // encoded_readdir() for a result already encoded for the host (see
+    // ffi::EncodedResult) and return a copy of it without calling stat() or
+    // readdir(). Returning nullptr (the default) falls back to those, as does
+    // every error. MemTreeFS implements both for its nodes.
+
+    virtual const ffi::EncodedResult* encoded_stat(PathArg path) {
+        (void)path; // unused
+        return nullptr;
+    }
+
+    virtual const ffi::EncodedResult* encoded_readdir(PathArg path) {
+        (void)path; // unused
+        return nullptr;
+    }
+
+    // Streaming I/O
+    //
+    // open() returns an opaque, positive handle that read_chunk(), write_chunk()
+    // and close() operate on, so the host can move large files through the
+    // plugin in bounded chunks. Returning Error::unsupported() (the default)
+    // makes the host fall back to whole-file read()/write().
+
+    // Open a file for streaming; flags is OpenRead or OpenWrite
+    virtual Result<FileHandle> open(PathArg path, uint32_t flags) {
+        (void)path; (void)flags; // unused
+        return Error::unsupported();
+    }
+
+    // Read the next chunk into out. Returns 0 at end of file.
+    virtual Result<size_t> read_chunk(FileHandle handle, Span<uint8_t> out) {
+        (void)handle; (void)out; // unused
+        return Error::unsupported();
+    }
+
+    // Append a chunk to a file opened with OpenWrite. Returns bytes consumed.
+    virtual Result<size_t> write_chunk(FileHandle handle, Span<const uint8_t> data) {
+        (void)handle; (void)data; // unused
+        return Error::unsupported();
+    }
+
+    // Close a streaming handle, flushing any pending writes
+    virtual Result<void> close(FileHandle handle) {
+        (void)handle; // unused
+        return Error::unsupported();
+    }
+
     // Write data to a file (returns response data)
-    virtual Result<std::vector<uint8_t>> write(const std::string& path, const std::vector<uint8_t>& data) {
+    virtual Result<std::vector<uint8_t>> write(PathArg path, DataArg data) {
         (void)path; (void)data; // unused
         return Error::read_only();
     }
 
     // Create a new empty file
-    virtual Result<void> create(const std::string& path) {
+    virtual Result<void> create(PathArg path) {
         (void)path; // unused
         return Error::read_only();
     }
 
     // Create a new directory
-    virtual Result<void> mkdir(const std::string& path, uint32_t perm) {
+    virtual Result<void> mkdir(PathArg path, uint32_t perm) {
         (void)path; (void)perm; // unused
         return Error::read_only();
     }
 
     // Remove a file or empty directory
-    virtual Result<void> remove(const std::string& path) {
+    virtual Result<void> remove(PathArg path) {
         (void)path; // unused
         return Error::read_only();
     }
 
     // Remove a file or directory and all its contents
-    virtual Result<void> remove_all(const std::string& path) {
+    virtual Result<void> remove_all(PathArg path) {
         (void)path; // unused
         return Error::read_only();
     }
 
     // Get file information
-    virtual Result<FileInfo> stat(const std::string& path) = 0;
+    virtual Result<FileInfo> stat(PathArg path) = 0;
 
     // List directory contents
-    virtual Result<std::vector<FileInfo>> readdir(const std::string& path) = 0;
+    virtual Result<std::vector<FileInfo>> readdir(PathArg path) = 0;
+
+    // List at most max_entries entries starting at cursor ("" for the first
+    // page). The host pages through huge directories this way so neither side
+    // holds the whole listing at once. The default pages over readdir() with a
+    // numeric offset cursor; override it to produce each batch on demand.
+    virtual Result<DirPage> readdir_page(PathArg path, PathArg cursor,
+                                         size_t max_entries) {
+        auto result = readdir(path);
+        if (result.is_err()) {
+            return result.unwrap_err();
+        }
+        auto& entries = result.unwrap();
+
+        size_t start = cursor.empty() ? 0 : (size_t)std::strtoull(std::string(cursor).c_str(), nullptr, 10);
+        start = std::min(start, entries.size());
+        size_t end = entries.size() - start > max_entries ? start + max_entries : entries.size();
+
+        DirPage page;
+        page.entries.assign(std::make_move_iterator(entries.begin() + start),
+                            std::make_move_iterator(entries.begin() + end));
+        if (end < entries.size()) {
+            page.next_cursor = std::to_string(end);
+        }
+        return page;
+    }
 
     // Rename/move a file or directory
-    virtual Result<void> rename(const std::string& old_path, const std::string& new_path) {
+    virtual Result<void> rename(PathArg old_path, PathArg new_path) {
         (void)old_path; (void)new_path; // unused
         return Error::read_only();
     }
 
     // Change file permissions
-    virtual Result<void> chmod(const std::string& path, uint32_t mode) {
+    virtual Result<void> chmod(PathArg path, uint32_t mode) {
         (void)path; (void)mode; // unused
         return Result<void>(); // Default: no-op
     }
+
+    // Copy size bytes (-1 for the rest) of src starting at offset into dst,
+    // replacing it, and return the bytes copied. Without an override the host
+    // copies through read and write itself; override it when the plugin can
+    // copy without moving the data, for example by sharing blocks or calling
+    // HostFS::copy() on the paths it maps to, and return Error::unsupported()
+    // for any copy the host should do itself.
+    virtual Result<uint64_t> copy(PathArg src, PathArg dst, int64_t offset, int64_t size) {
+        (void)src; (void)dst; (void)offset; (void)size; // unused
+        return Error::unsupported();
+    }
+
+private:
+    std::map<std::string, ProvidedContent, std::less<>> provided_;
 };
 
 } // namespace agfs
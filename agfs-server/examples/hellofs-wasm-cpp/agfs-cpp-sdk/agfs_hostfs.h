@@ -3,7 +3,9 @@
 
 #include "agfs_types.h"
 #include "agfs_ffi.h"
+#include "agfs_metrics.h"
 #include <cstring>
+#include <deque>
 
 namespace agfs {
 
@@ -12,6 +14,21 @@ extern "C" {
     __attribute__((import_module("env"))) __attribute__((import_name("host_fs_read")))
     uint64_t host_fs_read(const char* path, int64_t offset, int64_t size);
 
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_read_into")))
+    int64_t host_fs_read_into(const char* path, int64_t offset, uint8_t* buf, uint32_t cap);
+
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_open")))
+    int64_t host_fs_open(const char* path, uint32_t flags);
+
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_read_chunk")))
+    int64_t host_fs_read_chunk(int64_t handle, uint8_t* buf, uint32_t cap);
+
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_write_chunk")))
+    int64_t host_fs_write_chunk(int64_t handle, const uint8_t* data, uint32_t len);
+
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_close")))
+    uint32_t host_fs_close(int64_t handle);
+
     __attribute__((import_module("env"))) __attribute__((import_name("host_fs_write")))
     uint64_t host_fs_write(const char* path, const uint8_t* data, uint32_t len);
 
@@ -21,6 +38,21 @@ extern "C" {
     __attribute__((import_module("env"))) __attribute__((import_name("host_fs_readdir")))
     uint64_t host_fs_readdir(const char* path);
 
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_batch")))
+    uint64_t host_fs_batch(const uint8_t* request, uint32_t len);
+
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_submit")))
+    int64_t host_fs_submit(const uint8_t* request, uint32_t len);
+
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_wait_any")))
+    int64_t host_fs_wait_any(const int64_t* tickets, uint32_t count, int64_t timeout_ms);
+
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_take")))
+    uint32_t host_fs_take(int64_t ticket);
+
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_readdir_page")))
+    uint64_t host_fs_readdir_page(const char* path, const char* cursor, uint32_t max_entries);
+
     __attribute__((import_module("env"))) __attribute__((import_name("host_fs_create")))
     uint32_t host_fs_create(const char* path);
 
@@ -38,166 +70,675 @@ extern "C" {
 
     __attribute__((import_module("env"))) __attribute__((import_name("host_fs_chmod")))
     uint32_t host_fs_chmod(const char* path, uint32_t mode);
+
+    __attribute__((import_module("env"))) __attribute__((import_name("host_fs_copy")))
+    int64_t host_fs_copy(const char* src, const char* dst, int64_t offset, int64_t size);
 }
 
 // Helper to read string from pointer
 inline std::string read_string_from_ptr(uint32_t ptr) {
-    if (ptr == 0) {
-        return "";
-    }
-
-    // Find null terminator
-    const char* start_ptr = reinterpret_cast<const char*>(ptr);
-    size_t len = 0;
-    while (start_ptr[len] != '\0') {
-        len++;
-    }
-
-    return std::string(start_ptr, len);
+    return ffi::read_string(reinterpret_cast<const char*>(ptr));
 }
 
 // HostFS provides access to the host filesystem from WASM
 class HostFS {
 public:
     // Read data from a file on the host filesystem
-    static Result<std::vector<uint8_t>> read(const std::string& path, int64_t offset, int64_t size) {
-        uint64_t result = host_fs_read(path.c_str(), offset, size);
+    static Result<std::vector<uint8_t>> read(std::string_view path, int64_t offset, int64_t size) {
+        HostCall scope;
+        uint64_t result = host_fs_read(ffi::pass_string(path), offset, size);
 
         // Unpack: lower 32 bits = pointer, upper 32 bits = size
         uint32_t data_ptr = (uint32_t)(result & 0xFFFFFFFF);
         uint32_t data_size = (uint32_t)((result >> 32) & 0xFFFFFFFF);
 
         if (data_ptr == 0) {
-            return Error::io("read failed");
+            scope.fail();
+            return ffi::host_error(data_size, "read failed");
         }
 
-        // Read data from memory
-        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data_ptr);
-        std::vector<uint8_t> data(ptr, ptr + data_size);
-        return data;
+        // Copy data out of the host-allocated buffer and release it
+        return ffi::take_bytes(data_ptr, data_size);
+    }
+
+    // Read data from a file on the host filesystem straight into out.
+    // Returns the number of bytes the host wrote.
+    static Result<size_t> read_into(std::string_view path, int64_t offset, Span<uint8_t> out) {
+        HostCall scope;
+        int64_t n = host_fs_read_into(ffi::pass_string(path), offset, out.data(), (uint32_t)out.size());
+        if (n < 0) {
+            scope.fail();
+            return ffi::host_error_count(n, "read failed");
+        }
+        return (size_t)n;
+    }
+
+    // Open a host file for streaming I/O; flags is OpenRead or OpenWrite
+    static Result<FileHandle> open(std::string_view path, uint32_t flags) {
+        HostCall scope;
+        int64_t handle = host_fs_open(ffi::pass_string(path), flags);
+        if (handle <= 0) {
+            scope.fail();
+            return ffi::host_error_count(handle, "open failed");
+        }
+        return handle;
+    }
+
+    // Read the next chunk of a host file into out. Returns 0 at end of file.
+    static Result<size_t> read_chunk(FileHandle handle, Span<uint8_t> out) {
+        HostCall scope;
+        int64_t n = host_fs_read_chunk(handle, out.data(), (uint32_t)out.size());
+        if (n < 0) {
+            scope.fail();
+            return ffi::host_error_count(n, "read failed");
+        }
+        return (size_t)n;
+    }
+
+    // Append a chunk to a host file opened with OpenWrite
+    static Result<size_t> write_chunk(FileHandle handle, Span<const uint8_t> data) {
+        HostCall scope;
+        int64_t n = host_fs_write_chunk(handle, data.data(), (uint32_t)data.size());
+        if (n < 0) {
+            scope.fail();
+            return ffi::host_error_count(n, "write failed");
+        }
+        return (size_t)n;
+    }
+
+    // Close a host streaming handle
+    static Result<void> close(FileHandle handle) {
+        HostCall scope;
+        uint32_t err_ptr = host_fs_close(handle);
+        if (err_ptr != 0) {
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
+        }
+        return Result<void>();
     }
 
     // Write data to a file on the host filesystem
-    static Result<std::vector<uint8_t>> write(const std::string& path, const std::vector<uint8_t>& data) {
-        uint64_t result = host_fs_write(path.c_str(), data.data(), data.size());
+    static Result<std::vector<uint8_t>> write(std::string_view path, Span<const uint8_t> data) {
+        HostCall scope;
+        uint64_t result = host_fs_write(ffi::pass_string(path), data.data(), data.size());
 
         // Unpack: lower 32 bits = pointer, upper 32 bits = size
         uint32_t response_ptr = (uint32_t)(result & 0xFFFFFFFF);
         uint32_t response_size = (uint32_t)((result >> 32) & 0xFFFFFFFF);
 
         if (response_ptr == 0) {
-            return Error::io("write failed");
+            scope.fail();
+            return ffi::host_error(response_size, "write failed");
         }
 
-        // Read response from memory
-        const uint8_t* ptr = reinterpret_cast<const uint8_t*>(response_ptr);
-        std::vector<uint8_t> response(ptr, ptr + response_size);
-        return response;
+        // Copy response out of the host-allocated buffer and release it
+        return ffi::take_bytes(response_ptr, response_size);
     }
 
     // Get file information
-    static Result<FileInfo> stat(const std::string& path) {
-        uint64_t result = host_fs_stat(path.c_str());
+    static Result<FileInfo> stat(std::string_view path) {
+        HostCall scope;
+        uint64_t result = host_fs_stat(ffi::pass_string(path));
 
-        // Unpack: lower 32 bits = json pointer, upper 32 bits = error pointer
+        // Unpack: lower 32 bits = result pointer (JSON or binary, see
+        // ffi::abi_version()), upper 32 bits = error pointer
         uint32_t json_ptr = (uint32_t)(result & 0xFFFFFFFF);
         uint32_t err_ptr = (uint32_t)((result >> 32) & 0xFFFFFFFF);
 
         // Check for error
         if (err_ptr != 0) {
-            std::string err_str = read_string_from_ptr(err_ptr);
-            return Error::other(err_str);
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
         }
 
         if (json_ptr == 0) {
-            return Error::not_found();
+            scope.fail();
+            return Error::io("stat failed");
+        }
+
+        // Parse in place, then release the host-allocated buffer
+        char* json_str = reinterpret_cast<char*>(json_ptr);
+        FileInfo info = ffi::parse_stat(json_str);
+        ffi::release(json_str);
+        return info;
+    }
+
+    // Stat many host paths in one host call. Results are in the order of
+    // paths, and each one succeeds or fails on its own.
+    static std::vector<Result<FileInfo>> stat_many(const std::vector<std::string>& paths) {
+        ArenaScope scratch;
+        std::vector<Result<FileInfo>> results;
+        results.reserve(paths.size());
+        if (!ffi::binary_fileinfo()) {
+            // Hosts that only speak JSON have no batch import
+            for (const auto& path : paths) {
+                results.push_back(stat(path));
+            }
+            return results;
+        }
+
+        size_t len = wire::kHeaderSize;
+        for (const auto& path : paths) {
+            len += wire::batch_entry_size(path);
+        }
+        uint8_t* req = static_cast<uint8_t*>(call_arena().allocate(len, 1));
+        if (req == nullptr) {
+            fill_missing(results, paths.size(), Error::io("out of memory"));
+            return results;
+        }
+        uint8_t* out = wire::encode_header(req, (uint32_t)len, (uint32_t)paths.size());
+        for (const auto& path : paths) {
+            out = wire::encode_batch_entry(out, wire::kBatchStat, path, 0, 0);
+        }
+
+        auto sent = send_batch(req, (uint32_t)len, [&](const wire::BatchResultView& view) {
+            if (view.status != wire::kBatchOk) {
+                results.push_back(batch_error(view, ErrorKind::Other));
+                return;
+            }
+            wire::Decoder decoder(view.data, view.len);
+            wire::FileInfoView info;
+            if (decoder.next(info)) {
+                results.push_back(info.to_fileinfo());
+            } else {
+                results.push_back(Error::io("malformed batch stat result"));
+            }
+        });
+        fill_missing(results, paths.size(), sent);
+        return results;
+    }
+
+    // Read many host files (or ranges of them) in one host call. Results are
+    // in the order of requests, and each one succeeds or fails on its own.
+    static std::vector<Result<std::vector<uint8_t>>> read_many(const std::vector<ReadRequest>& requests) {
+        ArenaScope scratch;
+        std::vector<Result<std::vector<uint8_t>>> results;
+        results.reserve(requests.size());
+        if (!ffi::binary_fileinfo()) {
+            for (const auto& r : requests) {
+                results.push_back(read(r.path, r.offset, r.size));
+            }
+            return results;
+        }
+
+        uint32_t len = 0;
+        const uint8_t* req = encode_reads(requests, len);
+        if (req == nullptr) {
+            fill_missing(results, requests.size(), Error::io("out of memory"));
+            return results;
         }
 
-        std::string json_str = read_string_from_ptr(json_ptr);
-        return ffi::JsonParser::parse_fileinfo(json_str);
+        auto sent = send_batch(req, len, [&](const wire::BatchResultView& view) {
+            if (view.status != wire::kBatchOk) {
+                results.push_back(batch_error(view, ErrorKind::Io));
+                return;
+            }
+            results.push_back(std::vector<uint8_t>(view.data, view.data + view.len));
+        });
+        fill_missing(results, requests.size(), sent);
+        return results;
     }
 
     // Read directory contents
-    static Result<std::vector<FileInfo>> readdir(const std::string& path) {
-        uint64_t result = host_fs_readdir(path.c_str());
+    static Result<std::vector<FileInfo>> readdir(std::string_view path) {
+        HostCall scope;
+        uint64_t result = host_fs_readdir(ffi::pass_string(path));
 
-        // Unpack: lower 32 bits = json pointer, upper 32 bits = error pointer
+        // Unpack: lower 32 bits = result pointer (JSON or binary, see
+        // ffi::abi_version()), upper 32 bits = error pointer
         uint32_t json_ptr = (uint32_t)(result & 0xFFFFFFFF);
         uint32_t err_ptr = (uint32_t)((result >> 32) & 0xFFFFFFFF);
 
         // Check for error
         if (err_ptr != 0) {
-            std::string err_str = read_string_from_ptr(err_ptr);
-            return Error::other(err_str);
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
         }
 
         if (json_ptr == 0) {
             return std::vector<FileInfo>();
         }
 
-        std::string json_str = read_string_from_ptr(json_ptr);
-        return ffi::JsonParser::parse_fileinfo_array(json_str);
+        // Parse in place, then release the host-allocated buffer
+        char* json_str = reinterpret_cast<char*>(json_ptr);
+        std::vector<FileInfo> infos = ffi::parse_readdir(json_str);
+        ffi::release(json_str);
+        return infos;
+    }
+
+    // Read one page of a directory listing; pass "" as the first cursor and
+    // page.next_cursor afterwards until page.done()
+    static Result<DirPage> readdir_page(std::string_view path, std::string_view cursor,
+                                        size_t max_entries = kDirPageSize) {
+        if (!ffi::binary_fileinfo()) {
+            // Hosts that only speak JSON have no paged import; return
+            // everything as a single page
+            auto all = readdir(path);
+            if (all.is_err()) {
+                return all.unwrap_err();
+            }
+            DirPage page;
+            page.entries = std::move(all.unwrap());
+            return page;
+        }
+
+        HostCall scope;
+        uint64_t result = host_fs_readdir_page(ffi::pass_string(path), ffi::pass_string(cursor), (uint32_t)max_entries);
+
+        // Unpack: lower 32 bits = page pointer, upper 32 bits = error pointer
+        uint32_t page_ptr = (uint32_t)(result & 0xFFFFFFFF);
+        uint32_t err_ptr = (uint32_t)((result >> 32) & 0xFFFFFFFF);
+
+        if (err_ptr != 0) {
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
+        }
+
+        if (page_ptr == 0) {
+            return DirPage();
+        }
+
+        char* page_buf = reinterpret_cast<char*>(page_ptr);
+        DirPage page = ffi::parse_dir_page(page_buf);
+        ffi::release(page_buf);
+        return page;
+    }
+
+    // Visit every entry of a directory one page at a time, so only a single
+    // page is held in memory. Stops early when fn returns false.
+    template<typename Fn>
+    static Result<void> readdir_each(std::string_view path, Fn&& fn,
+                                     size_t page_size = kDirPageSize) {
+        std::string cursor;
+        do {
+            auto result = readdir_page(path, cursor, page_size);
+            if (result.is_err()) {
+                return result.unwrap_err();
+            }
+            auto& page = result.unwrap();
+            for (const auto& entry : page.entries) {
+                if (!fn(entry)) {
+                    return Result<void>();
+                }
+            }
+            cursor = std::move(page.next_cursor);
+        } while (!cursor.empty());
+        return Result<void>();
     }
 
     // Create a new file
-    static Result<void> create(const std::string& path) {
-        uint32_t err_ptr = host_fs_create(path.c_str());
+    static Result<void> create(std::string_view path) {
+        HostCall scope;
+        uint32_t err_ptr = host_fs_create(ffi::pass_string(path));
         if (err_ptr != 0) {
-            std::string err_str = read_string_from_ptr(err_ptr);
-            return Error::other(err_str);
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
         }
         return Result<void>();
     }
 
     // Create a directory
-    static Result<void> mkdir(const std::string& path, uint32_t perm) {
-        uint32_t err_ptr = host_fs_mkdir(path.c_str(), perm);
+    static Result<void> mkdir(std::string_view path, uint32_t perm) {
+        HostCall scope;
+        uint32_t err_ptr = host_fs_mkdir(ffi::pass_string(path), perm);
         if (err_ptr != 0) {
-            std::string err_str = read_string_from_ptr(err_ptr);
-            return Error::other(err_str);
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
         }
         return Result<void>();
     }
 
     // Remove a file or empty directory
-    static Result<void> remove(const std::string& path) {
-        uint32_t err_ptr = host_fs_remove(path.c_str());
+    static Result<void> remove(std::string_view path) {
+        HostCall scope;
+        uint32_t err_ptr = host_fs_remove(ffi::pass_string(path));
         if (err_ptr != 0) {
-            std::string err_str = read_string_from_ptr(err_ptr);
-            return Error::other(err_str);
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
         }
         return Result<void>();
     }
 
     // Remove a file or directory recursively
-    static Result<void> remove_all(const std::string& path) {
-        uint32_t err_ptr = host_fs_remove_all(path.c_str());
+    static Result<void> remove_all(std::string_view path) {
+        HostCall scope;
+        uint32_t err_ptr = host_fs_remove_all(ffi::pass_string(path));
         if (err_ptr != 0) {
-            std::string err_str = read_string_from_ptr(err_ptr);
-            return Error::other(err_str);
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
         }
         return Result<void>();
     }
 
     // Rename a file or directory
-    static Result<void> rename(const std::string& old_path, const std::string& new_path) {
-        uint32_t err_ptr = host_fs_rename(old_path.c_str(), new_path.c_str());
+    static Result<void> rename(std::string_view old_path, std::string_view new_path) {
+        HostCall scope;
+        uint32_t err_ptr = host_fs_rename(ffi::pass_string(old_path), ffi::pass_string(new_path));
         if (err_ptr != 0) {
-            std::string err_str = read_string_from_ptr(err_ptr);
-            return Error::other(err_str);
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
         }
         return Result<void>();
     }
 
     // Change file permissions
-    static Result<void> chmod(const std::string& path, uint32_t mode) {
-        uint32_t err_ptr = host_fs_chmod(path.c_str(), mode);
+    static Result<void> chmod(std::string_view path, uint32_t mode) {
+        HostCall scope;
+        uint32_t err_ptr = host_fs_chmod(ffi::pass_string(path), mode);
         if (err_ptr != 0) {
-            std::string err_str = read_string_from_ptr(err_ptr);
-            return Error::other(err_str);
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
         }
         return Result<void>();
     }
+
+    // Copy size bytes (-1 for the rest) of src starting at offset into dst,
+    // replacing it. The host moves the data between its filesystems directly,
+    // so none of it passes through linear memory. Returns the bytes copied.
+    static Result<uint64_t> copy(std::string_view src, std::string_view dst,
+                                 int64_t offset = 0, int64_t size = -1) {
+        HostCall scope;
+        int64_t n = host_fs_copy(ffi::pass_string(src), ffi::pass_string(dst), offset, size);
+        if (n < 0) {
+            scope.fail();
+            return ffi::host_error_count(n, "copy failed");
+        }
+        return (uint64_t)n;
+    }
+
+    // Asynchronous reads
+    //
+    // submit_read() starts a read on the host and returns at once with a
+    // ticket. The host runs submitted reads concurrently, so a plugin that
+    // needs many files from a slow backend submits them all and then collects
+    // the results, paying roughly one round trip instead of one per file:
+    //
+    //   std::vector<agfs::Ticket> tickets;
+    //   for (const auto& path : paths) {
+    //       tickets.push_back(agfs::HostFS::submit_read(path).unwrap());
+    //   }
+    //   for (auto& data : agfs::HostFS::wait_all(tickets)) { ... }
+    //
+    // Every ticket must be collected with take() or wait_all(), which spend
+    // it; tickets outlive the export call that submitted them.
+
+    // Start reading size bytes (-1 for the rest) of path at offset
+    static Result<Ticket> submit_read(std::string_view path, int64_t offset = 0, int64_t size = -1) {
+        HostCall scope;
+        size_t len = wire::kHeaderSize + wire::batch_entry_size(path);
+        uint8_t* req = static_cast<uint8_t*>(call_arena().allocate(len, 1));
+        if (req == nullptr) {
+            scope.fail();
+            return Error::io("out of memory");
+        }
+        uint8_t* out = wire::encode_header(req, (uint32_t)len, 1);
+        wire::encode_batch_entry(out, wire::kBatchRead, path, offset, size);
+        return submit(req, (uint32_t)len, scope);
+    }
+
+    // Start every read of requests in one host call. Their tickets are
+    // consecutive, starting with the one returned.
+    static Result<Ticket> submit_reads(const std::vector<ReadRequest>& requests) {
+        HostCall scope;
+        if (requests.empty()) {
+            scope.fail();
+            return Error::invalid_input("no reads to submit");
+        }
+        uint32_t len = 0;
+        const uint8_t* req = encode_reads(requests, len);
+        if (req == nullptr) {
+            scope.fail();
+            return Error::io("out of memory");
+        }
+        return submit(req, len, scope);
+    }
+
+    // Wait until one of tickets has completed and return it, or 0 once
+    // timeout_ms has passed. A timeout of 0 polls; -1 waits as long as needed.
+    static Result<Ticket> wait_any(Span<const Ticket> tickets, int64_t timeout_ms = -1) {
+        HostCall scope;
+        if (tickets.empty()) {
+            scope.fail();
+            return Error::invalid_input("no tickets to wait for");
+        }
+        int64_t ticket = host_fs_wait_any(tickets.data(), (uint32_t)tickets.size(), timeout_ms);
+        if (ticket < 0) {
+            scope.fail();
+            return ffi::host_error_count(ticket, "wait failed");
+        }
+        return ticket;
+    }
+
+    // The data of a submitted read, waiting for it to complete if needed
+    static Result<std::vector<uint8_t>> take(Ticket ticket) {
+        HostCall scope;
+        uint32_t resp_ptr = host_fs_take(ticket);
+        if (resp_ptr < ffi::kErrorCodeLimit) {
+            scope.fail();
+            return ffi::host_error(resp_ptr, "take failed");
+        }
+
+        std::vector<Result<std::vector<uint8_t>>> results;
+        read_response(reinterpret_cast<const uint8_t*>(resp_ptr), [&](const wire::BatchResultView& view) {
+            if (view.status != wire::kBatchOk) {
+                results.push_back(batch_error(view, ErrorKind::Io));
+                return;
+            }
+            results.push_back(std::vector<uint8_t>(view.data, view.data + view.len));
+        });
+        fill_missing(results, 1, Error::io("malformed take result"));
+        return std::move(results[0]);
+    }
+
+    // Collect every ticket's result, in the order of tickets
+    static std::vector<Result<std::vector<uint8_t>>> wait_all(Span<const Ticket> tickets) {
+        std::vector<Result<std::vector<uint8_t>>> results;
+        results.reserve(tickets.size());
+        for (Ticket ticket : tickets) {
+            results.push_back(take(ticket));
+        }
+        return results;
+    }
+
+private:
+    // A host import call: counted in the metrics, and giving back the call
+    // arena space its arguments and results took once HostFS has copied what
+    // it returns out of them, so a loop of host reads inside one export does
+    // not grow linear memory by every byte it read
+    struct HostCall : metrics::HostScope {
+        ArenaScope scratch;
+    };
+
+    // Encode a host_fs_batch request reading every entry of requests into the
+    // call arena, or return nullptr if it is full
+    static const uint8_t* encode_reads(const std::vector<ReadRequest>& requests, uint32_t& len) {
+        size_t total = wire::kHeaderSize;
+        for (const auto& r : requests) {
+            total += wire::batch_entry_size(r.path);
+        }
+        uint8_t* req = static_cast<uint8_t*>(call_arena().allocate(total, 1));
+        if (req == nullptr) {
+            return nullptr;
+        }
+        uint8_t* out = wire::encode_header(req, (uint32_t)total, (uint32_t)requests.size());
+        for (const auto& r : requests) {
+            out = wire::encode_batch_entry(out, wire::kBatchRead, r.path, r.offset, r.size);
+        }
+        len = (uint32_t)total;
+        return req;
+    }
+
+    // Submit an encoded request, counting a failure against scope
+    static Result<Ticket> submit(const uint8_t* req, uint32_t len, HostCall& scope) {
+        int64_t ticket = host_fs_submit(req, len);
+        if (ticket <= 0) {
+            scope.fail();
+            return ffi::host_error_count(ticket, "submit failed");
+        }
+        return ticket;
+    }
+
+    // Error of a failed batch entry; hosts before kAbiErrorCodes send only the
+    // message, which gets fallback
+    static Error batch_error(const wire::BatchResultView& view, ErrorKind fallback) {
+        std::string message((const char*)view.data, view.len);
+        if (!ffi::error_codes()) {
+            return Error(fallback, std::move(message));
+        }
+        return Error(ffi::host_error_kind(view.status), std::move(message));
+    }
+
+    // Send an encoded host_fs_batch request and pass every response entry to
+    // fn in order. Fails only if the batch as a whole failed.
+    template<typename Fn>
+    static Result<void> send_batch(const uint8_t* req, uint32_t len, Fn&& fn) {
+        HostCall scope;
+        uint64_t result = host_fs_batch(req, len);
+
+        // Unpack: lower 32 bits = response pointer, upper 32 bits = error pointer
+        uint32_t resp_ptr = (uint32_t)(result & 0xFFFFFFFF);
+        uint32_t err_ptr = (uint32_t)((result >> 32) & 0xFFFFFFFF);
+
+        if (err_ptr != 0) {
+            Error err = ffi::take_error(err_ptr);
+            scope.fail();
+            return err;
+        }
+        if (resp_ptr == 0) {
+            scope.fail();
+            return Error::io("batch failed");
+        }
+
+        read_response(reinterpret_cast<const uint8_t*>(resp_ptr), fn);
+        return Result<void>();
+    }
+
+    // Pass every entry of a host_fs_batch response to fn in order, then
+    // release the response
+    template<typename Fn>
+    static void read_response(const uint8_t* resp, Fn&& fn) {
+        wire::BatchDecoder decoder(resp);
+        wire::BatchResultView view;
+        while (decoder.next(view)) {
+            fn(view);
+        }
+        ffi::release(const_cast<uint8_t*>(resp));
+    }
+
+    // Pad results up to count with the batch error, or with a generic one when
+    // the host returned fewer entries than requested
+    template<typename T>
+    static void fill_missing(std::vector<Result<T>>& results, size_t count, const Result<void>& sent) {
+        Error err = sent.is_err() ? sent.unwrap_err() : Error::io("missing batch result");
+        while (results.size() < count) {
+            results.push_back(err);
+        }
+    }
+};
+
+// Incremental breadth-first walk of a host directory tree, for indexes built
+// a slice at a time from FileSystem::warmup(). Each step() lists directories
+// a page at a time until its deadline passes, so one huge directory cannot
+// stretch a slice by much more than a page:
+//
+//   HostWalk walk("/data");
+//   walk.step(deadline, [&](const std::string& dir, std::vector<FileInfo>& entries, bool complete) {
+//       ... // complete: this was the last page of dir
+//   });
+class HostWalk {
+public:
+    HostWalk() = default;
+
+    explicit HostWalk(const std::string& root, size_t page_entries = kDirPageSize) {
+        reset(root, page_entries);
+    }
+
+    // Start over at root
+    void reset(const std::string& root, size_t page_entries = kDirPageSize) {
+        pending_.clear();
+        pending_.push_back(root);
+        current_.clear();
+        cursor_.clear();
+        listing_ = false;
+        page_entries_ = page_entries;
+        directories_ = 0;
+        skipped_ = 0;
+    }
+
+    bool done() const {
+        return !listing_ && pending_.empty();
+    }
+
+    // Directories listed completely, and ones skipped because listing them
+    // failed after the root (they may have been removed since their parent
+    // was listed)
+    size_t directories() const { return directories_; }
+    size_t skipped() const { return skipped_; }
+
+    // List pages until the deadline passes or the walk is done, calling
+    // visit(dir, entries, complete) for each. Subdirectories are queued
+    // after visit returns, which may modify entries but not remove any.
+    // Returns whether directories remain; listing the root fails the step.
+    template<typename Visit>
+    Result<bool> step(const Deadline& deadline, Visit&& visit) {
+        do {
+            if (!listing_) {
+                if (pending_.empty()) {
+                    return false;
+                }
+                current_ = std::move(pending_.front());
+                pending_.pop_front();
+                cursor_.clear();
+                listing_ = true;
+            }
+
+            auto page = HostFS::readdir_page(current_, cursor_, page_entries_);
+            if (page.is_err()) {
+                listing_ = false;
+                if (directories_ == 0 && skipped_ == 0) {
+                    return page.unwrap_err();
+                }
+                skipped_++;
+                continue;
+            }
+
+            DirPage& listed = page.unwrap();
+            bool complete = listed.done();
+            visit(current_, listed.entries, complete);
+            for (const auto& entry : listed.entries) {
+                if (entry.is_dir) {
+                    pending_.push_back(join_path(current_, entry.name));
+                }
+            }
+
+            if (complete) {
+                listing_ = false;
+                directories_++;
+            } else {
+                cursor_ = std::move(listed.next_cursor);
+            }
+        } while (!deadline.expired());
+        return !done();
+    }
+
+private:
+    std::deque<std::string> pending_; // Directories not listed yet
+    std::string current_;             // Directory being listed when listing_
+    std::string cursor_;
+    bool listing_ = false;
+    size_t page_entries_ = kDirPageSize;
+    size_t directories_ = 0;
+    size_t skipped_ = 0;
 };
 
 } // namespace agfs
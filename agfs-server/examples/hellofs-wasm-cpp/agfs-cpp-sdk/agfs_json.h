@@ -0,0 +1,589 @@
+#ifndef AGFS_JSON_H
+#define AGFS_JSON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace agfs {
+namespace json {
+
+// Minimal JSON for the shapes the SDK exchanges with the host: config
+// objects, FileInfo and MetaData. Writer streams into a sink without
+// building a tree, and Reader is a pull parser over a string_view; neither
+// allocates beyond the strings it is asked to decode.
+
+// Sinks for Writer. SizeSink only counts, so a value can be measured and then
+// written straight into a buffer of the right size.
+class SizeSink {
+public:
+    size_t size = 0;
+
+    void put(char) { size++; }
+    void write(const char*, size_t len) { size += len; }
+};
+
+class BufferSink {
+public:
+    char* out;
+
+    explicit BufferSink(char* buf) : out(buf) {}
+
+    void put(char c) { *out++ = c; }
+    void write(const char* data, size_t len) {
+        std::memcpy(out, data, len);
+        out += len;
+    }
+};
+
+class StringSink {
+public:
+    std::string& out;
+
+    explicit StringSink(std::string& s) : out(s) {}
+
+    void put(char c) { out += c; }
+    void write(const char* data, size_t len) { out.append(data, len); }
+};
+
+// Streaming writer. Callers emit a well-formed sequence (key() before every
+// member value); commas and quoting are handled here.
+template<typename Sink>
+class Writer {
+public:
+    explicit Writer(Sink& sink) : sink_(sink) {}
+
+    void begin_object() { separate(); sink_.put('{'); comma_ = false; }
+    void end_object() { sink_.put('}'); comma_ = true; }
+    void begin_array() { separate(); sink_.put('['); comma_ = false; }
+    void end_array() { sink_.put(']'); comma_ = true; }
+
+    void key(std::string_view name) {
+        separate();
+        quoted(name);
+        sink_.put(':');
+        comma_ = false;
+    }
+
+    void value(std::string_view s) { separate(); quoted(s); comma_ = true; }
+    void value(const char* s) { value(std::string_view(s)); }
+    void value(bool b) { separate(); b ? sink_.write("true", 4) : sink_.write("false", 5); comma_ = true; }
+
+    void value(int64_t n) {
+        separate();
+        uint64_t u = n < 0 ? 0 - (uint64_t)n : (uint64_t)n;
+        if (n < 0) {
+            sink_.put('-');
+        }
+        digits(u);
+        comma_ = true;
+    }
+    void value(uint64_t n) { separate(); digits(n); comma_ = true; }
+    void value(int32_t n) { value((int64_t)n); }
+    void value(uint32_t n) { value((uint64_t)n); }
+
+    void null() { separate(); sink_.write("null", 4); comma_ = true; }
+
+    // Emit already-encoded JSON as one value
+    void raw(std::string_view encoded) { separate(); sink_.write(encoded.data(), encoded.size()); comma_ = true; }
+
+private:
+    Sink& sink_;
+    bool comma_ = false;
+
+    void separate() {
+        if (comma_) {
+            sink_.put(',');
+        }
+    }
+
+    void digits(uint64_t u) {
+        char buf[20];
+        size_t i = sizeof(buf);
+        do {
+            buf[--i] = (char)('0' + u % 10);
+            u /= 10;
+        } while (u != 0);
+        sink_.write(buf + i, sizeof(buf) - i);
+    }
+
+    void quoted(std::string_view s) {
+        static const char hex[] = "0123456789abcdef";
+        sink_.put('"');
+        size_t run = 0; // Start of the current span that needs no escaping
+        for (size_t i = 0; i < s.size(); i++) {
+            unsigned char c = (unsigned char)s[i];
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            sink_.write(s.data() + run, i - run);
+            run = i + 1;
+            sink_.put('\\');
+            switch (c) {
+                case '"': sink_.put('"'); break;
+                case '\\': sink_.put('\\'); break;
+                case '\n': sink_.put('n'); break;
+                case '\r': sink_.put('r'); break;
+                case '\t': sink_.put('t'); break;
+                default: {
+                    char u[5] = {'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    sink_.write(u, 5);
+                }
+            }
+        }
+        sink_.write(s.data() + run, s.size() - run);
+        sink_.put('"');
+    }
+};
+
+// Pull parser. Every method returns false once the input turns out to be
+// malformed, after which ok() is false and all further calls fail.
+class Reader {
+public:
+    enum class Type { Object, Array, String, Number, Bool, Null, Invalid };
+
+    explicit Reader(std::string_view text) : p_(text.data()), end_(text.data() + text.size()) {}
+
+    bool ok() const { return ok_; }
+
+    // Type of the next value
+    Type peek() {
+        if (!skip_ws()) {
+            return Type::Invalid;
+        }
+        switch (*p_) {
+            case '{': return Type::Object;
+            case '[': return Type::Array;
+            case '"': return Type::String;
+            case 't': case 'f': return Type::Bool;
+            case 'n': return Type::Null;
+            default:
+                return (*p_ == '-' || (*p_ >= '0' && *p_ <= '9')) ? Type::Number : Type::Invalid;
+        }
+    }
+
+    bool begin_object() { return open('{'); }
+    bool begin_array() { return open('['); }
+
+    // Advance to the next member of the current object, decoding its key.
+    // Returns false at the closing brace (or on malformed input).
+    bool next_key(std::string& key) {
+        if (!next('}')) {
+            return false;
+        }
+        if (!read_string(key) || !skip_ws() || *p_ != ':') {
+            return fail();
+        }
+        p_++;
+        return true;
+    }
+
+    // Advance to the next element of the current array. Returns false at the
+    // closing bracket (or on malformed input).
+    bool next_element() { return next(']'); }
+
+    bool read_string(std::string& out) {
+        out.clear();
+        if (!skip_ws() || *p_ != '"') {
+            return fail();
+        }
+        p_++;
+        while (p_ < end_) {
+            const char* run = p_;
+            while (p_ < end_ && *p_ != '"' && *p_ != '\\') {
+                p_++;
+            }
+            out.append(run, p_ - run);
+            if (p_ >= end_) {
+                break;
+            }
+            if (*p_ == '"') {
+                p_++;
+                return true;
+            }
+            if (!unescape(out)) {
+                return fail();
+            }
+        }
+        return fail();
+    }
+
+    // The literal text of a number, exactly as written
+    bool read_number(std::string_view& text) {
+        if (peek() != Type::Number) {
+            return fail();
+        }
+        const char* start = p_;
+        while (p_ < end_ && (std::strchr("+-.eE", *p_) != nullptr || (*p_ >= '0' && *p_ <= '9'))) {
+            p_++;
+        }
+        text = std::string_view(start, p_ - start);
+        return true;
+    }
+
+    // An integer; fractions and exponents are truncated away
+    bool read_int(int64_t& out) {
+        std::string_view text;
+        if (!read_number(text)) {
+            return false;
+        }
+        bool negative = text[0] == '-';
+        uint64_t v = 0;
+        for (size_t i = negative ? 1 : 0; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++) {
+            v = v * 10 + (uint64_t)(text[i] - '0');
+        }
+        out = negative ? (int64_t)(0 - v) : (int64_t)v;
+        return true;
+    }
+
+    bool read_bool(bool& out) {
+        if (literal("true")) {
+            out = true;
+            return true;
+        }
+        if (literal("false")) {
+            out = false;
+            return true;
+        }
+        return fail();
+    }
+
+    bool read_null() {
+        return literal("null") || fail();
+    }
+
+    // Skip the next value, whatever it is
+    bool skip_value() {
+        std::string_view ignored;
+        return raw_value(ignored);
+    }
+
+    // The encoded text of the next value, which is skipped
+    bool raw_value(std::string_view& text) {
+        if (!skip_ws()) {
+            return fail();
+        }
+        const char* start = p_;
+        if (!skip(0)) {
+            return fail();
+        }
+        text = std::string_view(start, p_ - start);
+        return true;
+    }
+
+    // Whether only whitespace is left
+    bool at_end() {
+        while (p_ < end_ && is_ws(*p_)) {
+            p_++;
+        }
+        return ok_ && p_ == end_;
+    }
+
+private:
+    static constexpr int kMaxDepth = 64;
+
+    const char* p_;
+    const char* end_;
+    bool ok_ = true;
+    bool first_ = false; // No member/element consumed yet in the innermost container
+
+    bool fail() {
+        ok_ = false;
+        p_ = end_;
+        return false;
+    }
+
+    static bool is_ws(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool skip_ws() {
+        while (p_ < end_ && is_ws(*p_)) {
+            p_++;
+        }
+        if (!ok_ || p_ >= end_) {
+            return fail();
+        }
+        return true;
+    }
+
+    bool literal(const char* word) {
+        size_t len = std::strlen(word);
+        if (!skip_ws() || (size_t)(end_ - p_) < len || std::memcmp(p_, word, len) != 0) {
+            return false;
+        }
+        p_ += len;
+        return true;
+    }
+
+    bool open(char c) {
+        if (!skip_ws() || *p_ != c) {
+            return fail();
+        }
+        p_++;
+        first_ = true;
+        return true;
+    }
+
+    // Step over the separator before the next member/element, or the closer
+    bool next(char closer) {
+        if (!skip_ws()) {
+            return false;
+        }
+        if (*p_ == closer) {
+            p_++;
+            first_ = false;
+            return false;
+        }
+        if (!first_) {
+            if (*p_ != ',') {
+                return fail();
+            }
+            p_++;
+        }
+        first_ = false;
+        return skip_ws();
+    }
+
+    bool skip(int depth) {
+        if (depth > kMaxDepth || !skip_ws()) {
+            return false;
+        }
+        std::string scratch;
+        switch (peek()) {
+            case Type::Object:
+                begin_object();
+                while (next_key(scratch)) {
+                    if (!skip(depth + 1)) {
+                        return false;
+                    }
+                }
+                return ok_;
+            case Type::Array:
+                begin_array();
+                while (next_element()) {
+                    if (!skip(depth + 1)) {
+                        return false;
+                    }
+                }
+                return ok_;
+            case Type::String:
+                return read_string(scratch);
+            case Type::Number: {
+                std::string_view text;
+                return read_number(text);
+            }
+            case Type::Bool: {
+                bool b;
+                return read_bool(b);
+            }
+            case Type::Null:
+                return read_null();
+            default:
+                return false;
+        }
+    }
+
+    static void append_utf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += (char)cp;
+        } else if (cp < 0x800) {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool hex4(uint32_t& out) {
+        if (end_ - p_ < 4) {
+            return false;
+        }
+        out = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = *p_++;
+            out <<= 4;
+            if (c >= '0' && c <= '9') out |= (uint32_t)(c - '0');
+            else if (c >= 'a' && c <= 'f') out |= (uint32_t)(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') out |= (uint32_t)(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    // Decode the escape at p_ (a backslash) into out
+    bool unescape(std::string& out) {
+        if (end_ - p_ < 2) {
+            return false;
+        }
+        p_++;
+        char c = *p_++;
+        switch (c) {
+            case '"': out += '"'; return true;
+            case '\\': out += '\\'; return true;
+            case '/': out += '/'; return true;
+            case 'b': out += '\b'; return true;
+            case 'f': out += '\f'; return true;
+            case 'n': out += '\n'; return true;
+            case 'r': out += '\r'; return true;
+            case 't': out += '\t'; return true;
+            case 'u': {
+                uint32_t cp;
+                if (!hex4(cp)) {
+                    return false;
+                }
+                if (cp >= 0xD800 && cp < 0xDC00 && end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') {
+                    p_ += 2;
+                    uint32_t low;
+                    if (!hex4(low) || low < 0xDC00 || low >= 0xE000) {
+                        return false;
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(out, cp);
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+};
+
+// Timestamps
+//
+// FileInfo.ModTime travels as RFC 3339 text, the way Go encodes time.Time.
+// mod_time 0 means unknown and maps to Go's zero time, 0001-01-01T00:00:00Z.
+
+constexpr size_t kTimestampSize = 20; // "YYYY-MM-DDTHH:MM:SSZ"
+constexpr int64_t kGoZeroUnix = -62135596800; // 0001-01-01T00:00:00Z
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+inline int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+inline void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int64_t)yoe + era * 400 + (m <= 2);
+}
+
+// Write unix seconds as UTC RFC 3339 into out[kTimestampSize]
+inline void format_timestamp(int64_t unix_seconds, char* out) {
+    if (unix_seconds == 0) {
+        unix_seconds = kGoZeroUnix;
+    }
+    int64_t days = unix_seconds / 86400;
+    int64_t secs = unix_seconds % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        days--;
+    }
+    int64_t y;
+    unsigned m, d;
+    civil_from_days(days, y, m, d);
+    if (y < 0 || y > 9999) {
+        y = y < 0 ? 0 : 9999;
+    }
+    auto two = [](char* p, unsigned v) { p[0] = (char)('0' + v / 10); p[1] = (char)('0' + v % 10); };
+    two(out, (unsigned)(y / 100));
+    two(out + 2, (unsigned)(y % 100));
+    out[4] = '-';
+    two(out + 5, m);
+    out[7] = '-';
+    two(out + 8, d);
+    out[10] = 'T';
+    two(out + 11, (unsigned)(secs / 3600));
+    out[13] = ':';
+    two(out + 14, (unsigned)(secs / 60 % 60));
+    out[16] = ':';
+    two(out + 17, (unsigned)(secs % 60));
+    out[19] = 'Z';
+}
+
+// Parse RFC 3339 ("2024-05-01T12:00:00.5+02:00") into unix seconds,
+// dropping fractions. Go's zero time parses as 0.
+inline bool parse_timestamp(std::string_view s, int64_t& unix_seconds) {
+    auto num = [&s](size_t pos, size_t len, unsigned& out) {
+        out = 0;
+        if (pos + len > s.size()) {
+            return false;
+        }
+        for (size_t i = pos; i < pos + len; i++) {
+            if (s[i] < '0' || s[i] > '9') {
+                return false;
+            }
+            out = out * 10 + (unsigned)(s[i] - '0');
+        }
+        return true;
+    };
+    // "YYYY-MM-DDTHH:MM:SSZ" is the shortest form; check before indexing
+    if (s.size() < 20) {
+        return false;
+    }
+    unsigned y, mo, d, h, mi, sec;
+    if (!num(0, 4, y) || s[4] != '-' || !num(5, 2, mo) || s[7] != '-' || !num(8, 2, d) ||
+        (s[10] != 'T' && s[10] != 't' && s[10] != ' ') || !num(11, 2, h) || s[13] != ':' ||
+        !num(14, 2, mi) || s[16] != ':' || !num(17, 2, sec) || mo < 1 || mo > 12 || d < 1 || d > 31) {
+        return false;
+    }
+    size_t pos = 19;
+    if (pos < s.size() && s[pos] == '.') {
+        pos++;
+        while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9') {
+            pos++;
+        }
+    }
+    int64_t offset = 0;
+    if (pos < s.size() && (s[pos] == 'Z' || s[pos] == 'z')) {
+        pos++;
+    } else if (pos < s.size() && (s[pos] == '+' || s[pos] == '-')) {
+        unsigned oh, om;
+        if (!num(pos + 1, 2, oh) || pos + 3 >= s.size() || s[pos + 3] != ':' || !num(pos + 4, 2, om)) {
+            return false;
+        }
+        offset = (int64_t)(oh * 3600 + om * 60) * (s[pos] == '-' ? -1 : 1);
+        pos += 6;
+    } else {
+        return false;
+    }
+    if (pos != s.size()) {
+        return false;
+    }
+    unix_seconds = days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + sec - offset;
+    if (unix_seconds == kGoZeroUnix) {
+        unix_seconds = 0;
+    }
+    return true;
+}
+
+// Whether text is exactly one well-formed JSON value
+inline bool valid(std::string_view text) {
+    Reader reader(text);
+    return reader.skip_value() && reader.at_end();
+}
+
+} // namespace json
+} // namespace agfs
+
+#endif // AGFS_JSON_H
@@ -0,0 +1,516 @@
+#ifndef AGFS_MEMTREE_H
+#define AGFS_MEMTREE_H
+
+#include "agfs_types.h"
+#include "agfs_ffi.h"
+#include "agfs_filesystem.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace agfs {
+
+// MemTreeFS is a FileSystem base class for trees held in memory.
+//
+// Subclasses build the tree with add_dir()/add_file(), usually from
+// initialize(), and get stat(), readdir(), read() and read_into() for free.
+// The layout is meant for read-mostly virtual trees served at high rates:
+//
+// - Nodes live in one flat array and are addressed by NodeId. Names are
+//   interned in a single character pool, so a node holds an offset instead
+//   of a std::string.
+// - The children of a directory occupy a contiguous range of one shared
+//   array, sorted by name, so a lookup is a binary search per path segment:
+//   O(depth) and no allocation.
+// - Files of up to kInlineBytes keep their content inside the node.
+// - Each node caches its stat result, and each directory its listing,
+//   already encoded for the host (see FileSystem::encoded_stat()). Repeated
+//   fs_stat/fs_readdir calls then cost a lookup and a memcpy. A cached
+//   result is dropped when its node, or for listings one of its children,
+//   changes.
+//
+// A subclass that answers some paths itself (say a proxied subtree) routes
+// them in its own stat()/readdir() overrides before calling these; if such a
+// path is also a node, it must override encoded_stat()/encoded_readdir() to
+// return nullptr for it. Mutating the tree after initialize() makes it
+// per-instance state, see FileSystem::concurrency().
+class MemTreeFS : public FileSystem {
+public:
+    using NodeId = uint32_t;
+
+    static constexpr NodeId kRoot = 0;
+    static constexpr NodeId kNoNode = 0xFFFFFFFFu;
+
+    // Largest file content stored inside its node
+    static constexpr size_t kInlineBytes = 16;
+
+    MemTreeFS() {
+        clear_tree();
+    }
+
+    // Building the tree
+
+    // Remove every node but the root
+    void clear_tree() {
+        nodes_.clear();
+        cache_.clear();
+        children_.clear();
+        free_nodes_.clear();
+        contents_.clear();
+        free_contents_.clear();
+        names_.clear();
+        interned_.clear();
+        wasted_children_ = 0;
+
+        Node root;
+        root.parent = kNoNode;
+        root.flags = kDir;
+        root.mode = 0755;
+        nodes_.push_back(root);
+        cache_.emplace_back();
+    }
+
+    // Create the directory at path and any missing parents, and return it.
+    // An existing directory is returned as is.
+    Result<NodeId> add_dir(std::string_view path, uint32_t mode = 0755) {
+        NodeId id = kRoot;
+        size_t pos = 0;
+        std::string_view segment;
+        while (next_segment(path, pos, segment)) {
+            NodeId child = find_child(id, segment);
+            if (child == kNoNode) {
+                child = new_node(id, segment, kDir, mode);
+            } else if (!is_dir(child)) {
+                return Error::not_directory();
+            }
+            id = child;
+        }
+        return id;
+    }
+
+    // Create or replace the file at path, creating missing parents
+    Result<NodeId> add_file(std::string_view path, Span<const uint8_t> content, uint32_t mode = 0644) {
+        size_t slash = path.find_last_of('/');
+        std::string_view dir = slash == std::string_view::npos ? std::string_view() : path.substr(0, slash);
+        std::string_view name = slash == std::string_view::npos ? path : path.substr(slash + 1);
+        if (name.empty()) {
+            return Error::invalid_input("file path must not end with '/'");
+        }
+
+        auto parent = add_dir(dir);
+        if (parent.is_err()) {
+            return parent;
+        }
+        NodeId id = find_child(parent.unwrap(), name);
+        if (id == kNoNode) {
+            id = new_node(parent.unwrap(), name, 0, mode);
+        } else if (is_dir(id)) {
+            return Error::is_directory();
+        } else {
+            set_mode(id, mode);
+        }
+        set_content(id, content);
+        return id;
+    }
+
+    Result<NodeId> add_file(std::string_view path, std::string_view content, uint32_t mode = 0644) {
+        return add_file(path, Span<const uint8_t>((const uint8_t*)content.data(), content.size()), mode);
+    }
+
+    // Replace a file's content
+    void set_content(NodeId id, Span<const uint8_t> content) {
+        Node& node = nodes_[id];
+        if (content.size() <= kInlineBytes) {
+            release_content(node);
+            if (!content.empty()) {
+                std::memcpy(node.bytes, content.data(), content.size());
+            }
+            node.flags |= kInline;
+        } else {
+            if (node.flags & kInline) {
+                node.content = allocate_content();
+                node.flags &= ~kInline;
+            }
+            contents_[node.content].assign(content.data(), content.data() + content.size());
+        }
+        node.size = (int64_t)content.size();
+        changed(id);
+    }
+
+    void set_mode(NodeId id, uint32_t mode) {
+        nodes_[id].mode = mode;
+        changed(id);
+    }
+
+    void set_mod_time(NodeId id, int64_t mod_time) {
+        nodes_[id].mod_time = mod_time;
+        changed(id);
+    }
+
+    // Remove a node and everything below it. The root cannot be removed;
+    // passing it removes its children.
+    void remove_node(NodeId id) {
+        if (is_dir(id)) {
+            while (nodes_[id].children.count > 0) {
+                remove_node(children_[nodes_[id].children.first + nodes_[id].children.count - 1]);
+            }
+        }
+        if (id == kRoot) {
+            return;
+        }
+
+        Node& node = nodes_[id];
+        NodeId parent = node.parent;
+        remove_child(parent, id);
+        release_content(node);
+        node.flags = kFree;
+        node.parent = kNoNode;
+        cache_[id].stat.clear();
+        cache_[id].listing.clear();
+        free_nodes_.push_back(id);
+        cache_[parent].listing.clear();
+    }
+
+    // Looking up nodes
+
+    // The node at path, or kNoNode. Empty segments are ignored, so "" and
+    // "/" are the root and "/a//b/" is "/a/b".
+    NodeId lookup(std::string_view path) const {
+        NodeId id = kRoot;
+        size_t pos = 0;
+        std::string_view segment;
+        while (next_segment(path, pos, segment)) {
+            if (!is_dir(id)) {
+                return kNoNode;
+            }
+            id = find_child(id, segment);
+            if (id == kNoNode) {
+                return kNoNode;
+            }
+        }
+        return id;
+    }
+
+    bool is_dir(NodeId id) const {
+        return (nodes_[id].flags & kDir) != 0;
+    }
+
+    std::string_view node_name(NodeId id) const {
+        const Node& node = nodes_[id];
+        return std::string_view(names_.data() + node.name_offset, node.name_length);
+    }
+
+    NodeId parent(NodeId id) const {
+        return nodes_[id].parent;
+    }
+
+    size_t child_count(NodeId id) const {
+        return is_dir(id) ? nodes_[id].children.count : 0;
+    }
+
+    // The i-th child of a directory, in name order
+    NodeId child(NodeId id, size_t i) const {
+        return children_[nodes_[id].children.first + i];
+    }
+
+    // A file's content; valid until the file changes
+    Span<const uint8_t> content(NodeId id) const {
+        const Node& node = nodes_[id];
+        if (node.flags & kDir) {
+            return Span<const uint8_t>();
+        }
+        if (node.flags & kInline) {
+            return Span<const uint8_t>(node.bytes, (size_t)node.size);
+        }
+        const auto& data = contents_[node.content];
+        return Span<const uint8_t>(data.data(), data.size());
+    }
+
+    FileInfo info(NodeId id) const {
+        const Node& node = nodes_[id];
+        FileInfo info;
+        info.name = std::string(node_name(id));
+        info.size = node.size;
+        info.mode = node.mode;
+        info.mod_time = node.mod_time;
+        info.is_dir = (node.flags & kDir) != 0;
+        return info;
+    }
+
+    // FileSystem
+
+    Result<FileInfo> stat(PathArg path) override {
+        NodeId id = lookup(path);
+        if (id == kNoNode) {
+            return Error::not_found();
+        }
+        return info(id);
+    }
+
+    Result<std::vector<FileInfo>> readdir(PathArg path) override {
+        NodeId id = lookup(path);
+        if (id == kNoNode) {
+            return Error::not_found();
+        }
+        if (!is_dir(id)) {
+            return Error::not_directory();
+        }
+        std::vector<FileInfo> entries;
+        entries.reserve(child_count(id));
+        for (size_t i = 0; i < child_count(id); i++) {
+            entries.push_back(info(child(id, i)));
+        }
+        return entries;
+    }
+
+    Result<std::vector<uint8_t>> read(PathArg path, int64_t offset, int64_t size) override {
+        NodeId id = lookup(path);
+        if (id == kNoNode) {
+            return Error::not_found();
+        }
+        if (is_dir(id)) {
+            return Error::is_directory();
+        }
+        auto range = serve_range(content(id), offset, size);
+        return std::vector<uint8_t>(range.data(), range.data() + range.size());
+    }
+
+    Result<size_t> read_into(PathArg path, int64_t offset, Span<uint8_t> out) override {
+        NodeId id = lookup(path);
+        if (id == kNoNode) {
+            return Error::not_found();
+        }
+        if (is_dir(id)) {
+            return Error::is_directory();
+        }
+        auto range = serve_range(content(id), offset, (int64_t)out.size());
+        if (!range.empty()) {
+            std::memcpy(out.data(), range.data(), range.size());
+        }
+        return range.size();
+    }
+
+    const ffi::EncodedResult* encoded_stat(PathArg path) override {
+        NodeId id = lookup(path);
+        if (id == kNoNode) {
+            return nullptr;
+        }
+        ffi::EncodedResult& cached = cache_[id].stat;
+        if (!cached.valid()) {
+            cached = ffi::EncodedResult::stat(info(id));
+        }
+        return cached.valid() ? &cached : nullptr;
+    }
+
+    const ffi::EncodedResult* encoded_readdir(PathArg path) override {
+        NodeId id = lookup(path);
+        if (id == kNoNode || !is_dir(id)) {
+            return nullptr;
+        }
+        ffi::EncodedResult& cached = cache_[id].listing;
+        if (!cached.valid()) {
+            auto entries = readdir(path);
+            if (entries.is_err()) {
+                return nullptr;
+            }
+            cached = ffi::EncodedResult::readdir(entries.unwrap());
+        }
+        return cached.valid() ? &cached : nullptr;
+    }
+
+private:
+    static constexpr uint32_t kDir = 1u << 0;
+    static constexpr uint32_t kInline = 1u << 1; // Content is in Node::bytes
+    static constexpr uint32_t kFree = 1u << 2;   // Slot awaiting reuse
+
+    struct ChildRange {
+        uint32_t first;    // Index into children_
+        uint32_t count;
+        uint32_t capacity; // Slots reserved at first
+    };
+
+    struct Node {
+        NodeId parent = kNoNode;
+        uint32_t name_offset = 0; // Into names_
+        uint32_t name_length = 0;
+        uint32_t mode = 0;
+        int64_t size = 0;
+        int64_t mod_time = 0;
+        uint32_t flags = kInline;
+        uint32_t content = 0;     // Slot in contents_ unless kInline
+        union {
+            ChildRange children;             // Directories
+            uint8_t bytes[kInlineBytes];     // Inline file content
+        };
+
+        Node() : children{0, 0, 0} {}
+    };
+
+    struct NodeCache {
+        ffi::EncodedResult stat;
+        ffi::EncodedResult listing; // Directories only
+    };
+
+    static bool next_segment(std::string_view path, size_t& pos, std::string_view& segment) {
+        while (pos < path.size() && path[pos] == '/') {
+            pos++;
+        }
+        if (pos >= path.size()) {
+            return false;
+        }
+        size_t end = path.find('/', pos);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        segment = path.substr(pos, end - pos);
+        pos = end;
+        return true;
+    }
+
+    // Position of name within a directory's children: the index of the
+    // child with that name, or where it would be inserted
+    size_t child_position(NodeId dir, std::string_view name) const {
+        const ChildRange& range = nodes_[dir].children;
+        const NodeId* first = children_.data() + range.first;
+        const NodeId* at = std::lower_bound(first, first + range.count, name,
+            [this](NodeId child, std::string_view key) { return node_name(child) < key; });
+        return (size_t)(at - first);
+    }
+
+    NodeId find_child(NodeId dir, std::string_view name) const {
+        const ChildRange& range = nodes_[dir].children;
+        size_t i = child_position(dir, name);
+        if (i < range.count && node_name(children_[range.first + i]) == name) {
+            return children_[range.first + i];
+        }
+        return kNoNode;
+    }
+
+    uint32_t intern(std::string_view name) {
+        auto it = interned_.find(std::string(name));
+        if (it != interned_.end()) {
+            return it->second;
+        }
+        uint32_t offset = (uint32_t)names_.size();
+        names_.append(name.data(), name.size());
+        interned_.emplace(std::string(name), offset);
+        return offset;
+    }
+
+    NodeId new_node(NodeId parent, std::string_view name, uint32_t flags, uint32_t mode) {
+        NodeId id;
+        if (!free_nodes_.empty()) {
+            id = free_nodes_.back();
+            free_nodes_.pop_back();
+            nodes_[id] = Node();
+        } else {
+            id = (NodeId)nodes_.size();
+            nodes_.emplace_back();
+            cache_.emplace_back();
+        }
+
+        Node& node = nodes_[id];
+        node.parent = parent;
+        node.name_offset = intern(name);
+        node.name_length = (uint32_t)name.size();
+        node.mode = mode;
+        node.flags = flags == kDir ? kDir : kInline;
+        insert_child(parent, id);
+        return id;
+    }
+
+    void insert_child(NodeId dir, NodeId id) {
+        size_t pos = child_position(dir, node_name(id));
+        ChildRange& range = nodes_[dir].children;
+        if (range.count == range.capacity) {
+            // Move the range to the end of children_ with room to grow
+            uint32_t capacity = std::max<uint32_t>(4, range.capacity * 2);
+            uint32_t first = (uint32_t)children_.size();
+            children_.resize(children_.size() + capacity, kNoNode);
+            std::copy(children_.begin() + range.first, children_.begin() + range.first + range.count,
+                      children_.begin() + first);
+            wasted_children_ += range.capacity;
+            range.first = first;
+            range.capacity = capacity;
+        }
+        NodeId* slots = children_.data() + range.first;
+        std::copy_backward(slots + pos, slots + range.count, slots + range.count + 1);
+        slots[pos] = id;
+        range.count++;
+        cache_[dir].listing.clear();
+
+        if (wasted_children_ > 1024 && wasted_children_ > children_.size() / 2) {
+            compact_children();
+        }
+    }
+
+    void remove_child(NodeId dir, NodeId id) {
+        ChildRange& range = nodes_[dir].children;
+        NodeId* slots = children_.data() + range.first;
+        NodeId* at = std::find(slots, slots + range.count, id);
+        if (at != slots + range.count) {
+            std::copy(at + 1, slots + range.count, at);
+            range.count--;
+        }
+    }
+
+    // Pack every directory's children back to back, dropping abandoned ranges
+    void compact_children() {
+        std::vector<NodeId> packed;
+        packed.reserve(children_.size() - wasted_children_);
+        for (auto& node : nodes_) {
+            if (!(node.flags & kDir)) {
+                continue;
+            }
+            ChildRange& range = node.children;
+            uint32_t first = (uint32_t)packed.size();
+            packed.insert(packed.end(), children_.begin() + range.first,
+                          children_.begin() + range.first + range.capacity);
+            range.first = first;
+        }
+        children_ = std::move(packed);
+        wasted_children_ = 0;
+    }
+
+    uint32_t allocate_content() {
+        if (!free_contents_.empty()) {
+            uint32_t slot = free_contents_.back();
+            free_contents_.pop_back();
+            return slot;
+        }
+        contents_.emplace_back();
+        return (uint32_t)(contents_.size() - 1);
+    }
+
+    void release_content(Node& node) {
+        if (node.flags & (kDir | kInline)) {
+            return;
+        }
+        contents_[node.content].clear();
+        contents_[node.content].shrink_to_fit();
+        free_contents_.push_back(node.content);
+        node.flags |= kInline;
+    }
+
+    // Drop the encoded results that show node id
+    void changed(NodeId id) {
+        cache_[id].stat.clear();
+        if (id != kRoot) {
+            cache_[nodes_[id].parent].listing.clear();
+        }
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<NodeCache> cache_;            // Parallel to nodes_
+    std::vector<NodeId> children_;            // Every directory's child range
+    std::vector<NodeId> free_nodes_;
+    std::vector<std::vector<uint8_t>> contents_; // Files larger than kInlineBytes
+    std::vector<uint32_t> free_contents_;
+    std::string names_;                       // Interned names, back to back
+    std::unordered_map<std::string, uint32_t> interned_;
+    size_t wasted_children_ = 0;              // Slots of abandoned child ranges
+};
+
+} // namespace agfs
+
+#endif // AGFS_MEMTREE_H
@@ -0,0 +1,245 @@
+#ifndef AGFS_METRICS_H
+#define AGFS_METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(AGFS_METRICS)
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace agfs {
+namespace metrics {
+
+// Operations the export layer accounts for. fs_read and fs_read_into both
+// count as Read.
+enum class Op : uint32_t {
+    Stat,
+    ReadDir,
+    ReadDirPage,
+    Read,
+    Write,
+    Open,
+    ReadChunk,
+    WriteChunk,
+    Close,
+    Create,
+    Mkdir,
+    Remove,
+    RemoveAll,
+    Rename,
+    Chmod,
+    Copy,
+    Count
+};
+
+inline const char* op_name(Op op) {
+    static const char* const names[] = {
+        "stat", "readdir", "readdir_page", "read", "write", "open", "read_chunk",
+        "write_chunk", "close", "create", "mkdir", "remove", "remove_all",
+        "rename", "chmod", "copy"
+    };
+    return names[(size_t)op];
+}
+
+// Latency histogram buckets: bucket 0 counts calls under 1us, bucket i those
+// in [2^(i-1), 2^i) us, and the last one everything slower
+constexpr size_t kLatencyBuckets = 24;
+
+#if defined(AGFS_METRICS)
+
+// Counters of one operation. They are relaxed atomics, so ThreadPool workers
+// can record without locks and single-threaded builds pay plain adds.
+class OpStats {
+public:
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> bytes_out{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> latency[kLatencyBuckets] = {};
+
+    void record(uint64_t ns, bool failed, uint64_t in, uint64_t out) {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        if (failed) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (in != 0) {
+            bytes_in.fetch_add(in, std::memory_order_relaxed);
+        }
+        if (out != 0) {
+            bytes_out.fetch_add(out, std::memory_order_relaxed);
+        }
+        total_ns.fetch_add(ns, std::memory_order_relaxed);
+        latency[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static size_t bucket(uint64_t ns) {
+        uint64_t us = ns / 1000;
+        size_t b = us == 0 ? 0 : (size_t)(64 - __builtin_clzll(us));
+        return b < kLatencyBuckets ? b : kLatencyBuckets - 1;
+    }
+};
+
+inline OpStats& op_stats(Op op) {
+    static OpStats stats[(size_t)Op::Count];
+    return stats[(size_t)op];
+}
+
+// Everything spent inside HostFS calls, across operations
+inline OpStats& host_stats() {
+    static OpStats stats;
+    return stats;
+}
+
+inline uint64_t now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Times one exported call from construction to destruction
+class Scope {
+public:
+    explicit Scope(Op op) : op_(op), start_(now_ns()) {}
+    ~Scope() {
+        op_stats(op_).record(now_ns() - start_, failed_, in_, out_);
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    void fail() { failed_ = true; }
+    void bytes_in(uint64_t n) { in_ += n; }
+    void bytes_out(uint64_t n) { out_ += n; }
+
+    // Mark the call failed if result is an error
+    template<typename R>
+    void check(const R& result) {
+        if (result.is_err()) {
+            failed_ = true;
+        }
+    }
+
+private:
+    Op op_;
+    uint64_t start_;
+    bool failed_ = false;
+    uint64_t in_ = 0;
+    uint64_t out_ = 0;
+};
+
+// Times one HostFS call; HostFS calls fail() before returning an error
+class HostScope {
+public:
+    HostScope() : start_(now_ns()) {}
+    ~HostScope() {
+        host_stats().record(now_ns() - start_, failed_, 0, 0);
+    }
+
+    HostScope(const HostScope&) = delete;
+    HostScope& operator=(const HostScope&) = delete;
+
+    void fail() { failed_ = true; }
+
+private:
+    uint64_t start_;
+    bool failed_ = false;
+};
+
+inline void append_stats(std::string& out, const OpStats& s) {
+    auto field = [&out](const char* name, uint64_t v) {
+        out += '"';
+        out += name;
+        out += "\":";
+        out += std::to_string(v);
+        out += ',';
+    };
+    out += '{';
+    field("calls", s.calls.load(std::memory_order_relaxed));
+    field("errors", s.errors.load(std::memory_order_relaxed));
+    field("bytes_in", s.bytes_in.load(std::memory_order_relaxed));
+    field("bytes_out", s.bytes_out.load(std::memory_order_relaxed));
+    field("total_ns", s.total_ns.load(std::memory_order_relaxed));
+    out += "\"latency_us_log2\":[";
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+        if (i > 0) {
+            out += ',';
+        }
+        out += std::to_string(s.latency[i].load(std::memory_order_relaxed));
+    }
+    out += "]}";
+}
+
+// Snapshot of every counter as JSON, returned by the plugin_metrics export.
+// Operations never called are left out.
+inline std::string to_json(size_t arena_high_water) {
+    std::string out = "{\"ops\":{";
+    bool first = true;
+    for (size_t i = 0; i < (size_t)Op::Count; i++) {
+        const OpStats& s = op_stats((Op)i);
+        if (s.calls.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        out += '"';
+        out += op_name((Op)i);
+        out += "\":";
+        append_stats(out, s);
+    }
+    out += "},\"hostfs\":";
+    append_stats(out, host_stats());
+    out += ",\"arena_high_water\":";
+    out += std::to_string(arena_high_water);
+#if defined(__wasm__)
+    // Linear memory never shrinks, so its size is malloc's high-water mark
+    out += ",\"memory_bytes\":";
+    out += std::to_string((uint64_t)__builtin_wasm_memory_size(0) * 65536);
+#endif
+    out += '}';
+    return out;
+}
+
+#else // !AGFS_METRICS
+
+// Compiled out: the scopes are empty and every call folds away
+class Scope {
+public:
+    explicit Scope(Op) {}
+    void fail() {}
+    void bytes_in(uint64_t) {}
+    void bytes_out(uint64_t) {}
+    template<typename R>
+    void check(const R&) {}
+};
+
+class HostScope {
+public:
+    HostScope() {}
+    void fail() {}
+};
+
+#endif // AGFS_METRICS
+
+} // namespace metrics
+} // namespace agfs
+
+// The plugin_metrics export, emitted by AGFS_EXPORT_PLUGIN only in metrics
+// builds. The host polls it; modules without it have no metrics.
+#if defined(AGFS_METRICS)
+#define AGFS_METRICS_EXPORT \
+    __attribute__((export_name("plugin_metrics"))) \
+    char* plugin_metrics() { \
+        agfs::ffi::begin_call(); \
+        return agfs::ffi::result_string( \
+            agfs::metrics::to_json(agfs::call_arena().high_water())); \
+    }
+#else
+#define AGFS_METRICS_EXPORT
+#endif
+
+#endif // AGFS_METRICS_H
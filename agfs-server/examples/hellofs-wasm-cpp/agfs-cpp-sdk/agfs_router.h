@@ -0,0 +1,150 @@
+#ifndef AGFS_ROUTER_H
+#define AGFS_ROUTER_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace agfs {
+
+// Most ":name" segments a single route may capture
+constexpr size_t kMaxRouteParams = 8;
+
+// Result of Router::match(). Views point into the matched path.
+template<typename T>
+class RouteMatch {
+public:
+    const T* value = nullptr;                     // nullptr if nothing matched
+    std::string_view rest;                        // What a trailing "*" matched: "" or "/a/b"
+    std::string_view params[kMaxRouteParams];     // ":name" segments, in pattern order
+    size_t param_count = 0;
+
+    explicit operator bool() const { return value != nullptr; }
+};
+
+// Router maps path patterns to values (handlers, enum tags, ...) with a
+// segment trie. Build it once in initialize(), then match() walks the path a
+// segment at a time without allocating.
+//
+// Patterns are made of '/'-separated segments:
+//   /hello.txt     static segments match exactly
+//   /users/:id     ":name" matches any single segment and captures it
+//   /host/*        a trailing "*" matches the node itself and everything below
+//
+// At each segment a static child is tried first, then a ":name" child, then a
+// "*" route at that level. Empty segments are ignored, so "/a//b/" matches
+// "/a/b".
+template<typename T>
+class Router {
+public:
+    // Add a route. Returns false if the pattern is malformed or already added.
+    bool add(std::string_view pattern, T value) {
+        Node* node = &root_;
+        size_t pos = 0;
+        std::string_view segment;
+        while (next_segment(pattern, pos, segment)) {
+            if (segment == "*") {
+                std::string_view trailing;
+                if (next_segment(pattern, pos, trailing) || node->prefix) {
+                    return false; // "*" must come last
+                }
+                node->prefix.emplace(std::move(value));
+                return true;
+            }
+            if (segment[0] == ':') {
+                if (!node->param) {
+                    node->param.reset(new Node());
+                }
+                node = node->param.get();
+                continue;
+            }
+            auto it = node->children.find(segment);
+            if (it == node->children.end()) {
+                it = node->children.emplace(std::string(segment), std::unique_ptr<Node>(new Node())).first;
+            }
+            node = it->second.get();
+        }
+        if (node->exact) {
+            return false;
+        }
+        node->exact.emplace(std::move(value));
+        return true;
+    }
+
+    RouteMatch<T> match(std::string_view path) const {
+        RouteMatch<T> m;
+        match_from(root_, path, 0, m);
+        return m;
+    }
+
+    void clear() {
+        root_ = Node();
+    }
+
+private:
+    struct Node {
+        std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
+        std::unique_ptr<Node> param; // ":name" child
+        std::optional<T> exact;      // Route ending at this node
+        std::optional<T> prefix;     // "*" route at this node
+    };
+
+    // Advance pos past the next non-empty segment of path
+    static bool next_segment(std::string_view path, size_t& pos, std::string_view& segment) {
+        while (pos < path.size() && path[pos] == '/') {
+            pos++;
+        }
+        if (pos >= path.size()) {
+            return false;
+        }
+        size_t end = path.find('/', pos);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        segment = path.substr(pos, end - pos);
+        pos = end;
+        return true;
+    }
+
+    bool match_from(const Node& node, std::string_view path, size_t pos, RouteMatch<T>& m) const {
+        size_t after = pos;
+        std::string_view segment;
+        if (!next_segment(path, after, segment)) {
+            const std::optional<T>& hit = node.exact ? node.exact : node.prefix;
+            if (!hit) {
+                return false;
+            }
+            m.value = &*hit;
+            m.rest = std::string_view();
+            return true;
+        }
+
+        auto it = node.children.find(segment);
+        if (it != node.children.end() && match_from(*it->second, path, after, m)) {
+            return true;
+        }
+        if (node.param && m.param_count < kMaxRouteParams) {
+            m.params[m.param_count++] = segment;
+            if (match_from(*node.param, path, after, m)) {
+                return true;
+            }
+            m.param_count--;
+        }
+        if (node.prefix) {
+            m.value = &*node.prefix;
+            m.rest = path.substr(pos);
+            return true;
+        }
+        return false;
+    }
+
+    Node root_;
+};
+
+} // namespace agfs
+
+#endif // AGFS_ROUTER_H
@@ -0,0 +1,375 @@
+#ifndef AGFS_SIMD_H
+#define AGFS_SIMD_H
+
+#include "agfs_types.h"
+#include "agfs_json.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+namespace agfs {
+namespace simd {
+
+// Content kernels for plugins that hash, checksum or search the data passing
+// through them. Built with -msimd128 (make build-simd) the search, count and
+// xxh32 kernels process 16 bytes per step with wasm SIMD128; without it they
+// fall back to scalar loops with identical results, so the same plugin code
+// builds either way. SIMD128 has no carry-less multiply, so crc32c always
+// uses slicing-by-8 tables.
+
+constexpr size_t npos = (size_t)-1;
+
+namespace internal {
+
+inline uint32_t load_u32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint64_t load_u64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint32_t rotl32(uint32_t v, int r) { return (v << r) | (v >> (32 - r)); }
+inline uint64_t rotl64(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+// CRC32C (Castagnoli, reflected 0x82F63B78) slicing-by-8 tables
+struct Crc32cTables {
+    uint32_t t[8][256];
+
+    constexpr Crc32cTables() : t() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            }
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int k = 1; k < 8; k++) {
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+inline constexpr Crc32cTables kCrc32c{};
+
+constexpr uint32_t kXxh32Prime1 = 2654435761u;
+constexpr uint32_t kXxh32Prime2 = 2246822519u;
+constexpr uint32_t kXxh32Prime3 = 3266489917u;
+constexpr uint32_t kXxh32Prime4 = 668265263u;
+constexpr uint32_t kXxh32Prime5 = 374761393u;
+
+constexpr uint64_t kXxh64Prime1 = 11400714785074694791ull;
+constexpr uint64_t kXxh64Prime2 = 14029467366897019727ull;
+constexpr uint64_t kXxh64Prime3 = 1609587929392839161ull;
+constexpr uint64_t kXxh64Prime4 = 9650029242287828579ull;
+constexpr uint64_t kXxh64Prime5 = 2870177450012600261ull;
+
+inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+    acc += input * kXxh64Prime2;
+    acc = rotl64(acc, 31);
+    return acc * kXxh64Prime1;
+}
+
+inline uint64_t xxh64_merge(uint64_t acc, uint64_t v) {
+    acc ^= xxh64_round(0, v);
+    return acc * kXxh64Prime1 + kXxh64Prime4;
+}
+
+inline void hex(std::string& out, uint64_t v, int digits) {
+    static const char kHex[] = "0123456789abcdef";
+    for (int i = digits - 1; i >= 0; i--) {
+        out += kHex[(v >> (i * 4)) & 0xF];
+    }
+}
+
+} // namespace internal
+
+// Checksums and hashes
+
+// CRC32C of data, continuing from crc (pass a previous result to checksum
+// data that arrives in pieces)
+inline uint32_t crc32c(Span<const uint8_t> data, uint32_t crc = 0) {
+    const auto& t = internal::kCrc32c.t;
+    const uint8_t* p = data.data();
+    size_t n = data.size();
+    uint32_t c = ~crc;
+    while (n >= 8) {
+        uint32_t lo = internal::load_u32(p) ^ c;
+        uint32_t hi = internal::load_u32(p + 4);
+        c = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        p += 8;
+        n -= 8;
+    }
+    while (n-- > 0) {
+        c = t[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+    }
+    return ~c;
+}
+
+// XXH32 of data. Its four 32-bit accumulators map onto one SIMD128 vector.
+inline uint32_t xxh32(Span<const uint8_t> data, uint32_t seed = 0) {
+    using namespace internal;
+    const uint8_t* p = data.data();
+    size_t n = data.size();
+    const uint8_t* end = p + n;
+    uint32_t h;
+
+    if (n >= 16) {
+#ifdef __wasm_simd128__
+        v128_t v = wasm_i32x4_make((int32_t)(seed + kXxh32Prime1 + kXxh32Prime2),
+                                   (int32_t)(seed + kXxh32Prime2), (int32_t)seed,
+                                   (int32_t)(seed - kXxh32Prime1));
+        const v128_t prime1 = wasm_i32x4_splat((int32_t)kXxh32Prime1);
+        const v128_t prime2 = wasm_i32x4_splat((int32_t)kXxh32Prime2);
+        for (; end - p >= 16; p += 16) {
+            v = wasm_i32x4_add(v, wasm_i32x4_mul(wasm_v128_load(p), prime2));
+            v = wasm_v128_or(wasm_i32x4_shl(v, 13), wasm_u32x4_shr(v, 19));
+            v = wasm_i32x4_mul(v, prime1);
+        }
+        h = rotl32((uint32_t)wasm_i32x4_extract_lane(v, 0), 1) +
+            rotl32((uint32_t)wasm_i32x4_extract_lane(v, 1), 7) +
+            rotl32((uint32_t)wasm_i32x4_extract_lane(v, 2), 12) +
+            rotl32((uint32_t)wasm_i32x4_extract_lane(v, 3), 18);
+#else
+        uint32_t v[4] = {seed + kXxh32Prime1 + kXxh32Prime2, seed + kXxh32Prime2, seed, seed - kXxh32Prime1};
+        for (; end - p >= 16; p += 16) {
+            for (int i = 0; i < 4; i++) {
+                v[i] = rotl32(v[i] + load_u32(p + i * 4) * kXxh32Prime2, 13) * kXxh32Prime1;
+            }
+        }
+        h = rotl32(v[0], 1) + rotl32(v[1], 7) + rotl32(v[2], 12) + rotl32(v[3], 18);
+#endif
+    } else {
+        h = seed + kXxh32Prime5;
+    }
+
+    h += (uint32_t)n;
+    for (; end - p >= 4; p += 4) {
+        h = rotl32(h + load_u32(p) * kXxh32Prime3, 17) * kXxh32Prime4;
+    }
+    for (; p < end; p++) {
+        h = rotl32(h + *p * kXxh32Prime5, 11) * kXxh32Prime1;
+    }
+    h ^= h >> 15;
+    h *= kXxh32Prime2;
+    h ^= h >> 13;
+    h *= kXxh32Prime3;
+    h ^= h >> 16;
+    return h;
+}
+
+// XXH64 of data. 64-bit lane multiplies are not faster in SIMD128 than in
+// scalar code, so this keeps four independent scalar accumulators.
+inline uint64_t xxh64(Span<const uint8_t> data, uint64_t seed = 0) {
+    using namespace internal;
+    const uint8_t* p = data.data();
+    size_t n = data.size();
+    const uint8_t* end = p + n;
+    uint64_t h;
+
+    if (n >= 32) {
+        uint64_t v1 = seed + kXxh64Prime1 + kXxh64Prime2;
+        uint64_t v2 = seed + kXxh64Prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kXxh64Prime1;
+        for (; end - p >= 32; p += 32) {
+            v1 = xxh64_round(v1, load_u64(p));
+            v2 = xxh64_round(v2, load_u64(p + 8));
+            v3 = xxh64_round(v3, load_u64(p + 16));
+            v4 = xxh64_round(v4, load_u64(p + 24));
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    } else {
+        h = seed + kXxh64Prime5;
+    }
+
+    h += (uint64_t)n;
+    for (; end - p >= 8; p += 8) {
+        h ^= xxh64_round(0, load_u64(p));
+        h = rotl64(h, 27) * kXxh64Prime1 + kXxh64Prime4;
+    }
+    if (end - p >= 4) {
+        h ^= (uint64_t)load_u32(p) * kXxh64Prime1;
+        h = rotl64(h, 23) * kXxh64Prime2 + kXxh64Prime3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= *p * kXxh64Prime5;
+        h = rotl64(h, 11) * kXxh64Prime1;
+    }
+    h ^= h >> 33;
+    h *= kXxh64Prime2;
+    h ^= h >> 29;
+    h *= kXxh64Prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Search
+
+// Index of the first c in data, or npos
+inline size_t find_byte(Span<const uint8_t> data, uint8_t c) {
+    const uint8_t* p = data.data();
+    size_t n = data.size();
+#ifdef __wasm_simd128__
+    const v128_t needle = wasm_i8x16_splat((int8_t)c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint32_t mask = wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(p + i), needle));
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    for (; i < n; i++) {
+        if (p[i] == c) {
+            return i;
+        }
+    }
+    return npos;
+#else
+    const void* hit = n > 0 ? std::memchr(p, c, n) : nullptr;
+    return hit != nullptr ? (size_t)(static_cast<const uint8_t*>(hit) - p) : npos;
+#endif
+}
+
+// Index of the first occurrence of needle in data, or npos. An empty needle
+// matches at 0.
+inline size_t find(Span<const uint8_t> data, Span<const uint8_t> needle) {
+    const uint8_t* p = data.data();
+    const uint8_t* q = needle.data();
+    size_t n = data.size();
+    size_t m = needle.size();
+    if (m == 0) {
+        return 0;
+    }
+    if (m > n) {
+        return npos;
+    }
+    if (m == 1) {
+        return find_byte(data, q[0]);
+    }
+
+    size_t i = 0;
+#ifdef __wasm_simd128__
+    // Compare the needle's first and last bytes at 16 positions at once and
+    // verify only the positions where both match
+    const v128_t first = wasm_i8x16_splat((int8_t)q[0]);
+    const v128_t last = wasm_i8x16_splat((int8_t)q[m - 1]);
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        v128_t eq_first = wasm_i8x16_eq(wasm_v128_load(p + i), first);
+        v128_t eq_last = wasm_i8x16_eq(wasm_v128_load(p + i + m - 1), last);
+        uint32_t mask = wasm_i8x16_bitmask(wasm_v128_and(eq_first, eq_last));
+        while (mask != 0) {
+            size_t at = i + (size_t)__builtin_ctz(mask);
+            if (std::memcmp(p + at + 1, q + 1, m - 2) == 0) {
+                return at;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    while (i + m <= n) {
+        size_t at = find_byte(data.subspan(i, n - m + 1 - i), q[0]);
+        if (at == npos) {
+            return npos;
+        }
+        i += at;
+        if (p[i + m - 1] == q[m - 1] && std::memcmp(p + i + 1, q + 1, m - 2) == 0) {
+            return i;
+        }
+        i++;
+    }
+    return npos;
+}
+
+inline size_t find(std::string_view data, std::string_view needle) {
+    return find(Span<const uint8_t>(reinterpret_cast<const uint8_t*>(data.data()), data.size()),
+                Span<const uint8_t>(reinterpret_cast<const uint8_t*>(needle.data()), needle.size()));
+}
+
+// Counting
+
+// Number of bytes in data equal to c
+inline size_t count_byte(Span<const uint8_t> data, uint8_t c) {
+    const uint8_t* p = data.data();
+    size_t n = data.size();
+    size_t count = 0;
+    size_t i = 0;
+#ifdef __wasm_simd128__
+    const v128_t needle = wasm_i8x16_splat((int8_t)c);
+    for (; i + 16 <= n; i += 16) {
+        count += (size_t)__builtin_popcount(wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(p + i), needle)));
+    }
+#endif
+    for (; i < n; i++) {
+        count += p[i] == c;
+    }
+    return count;
+}
+
+// Number of newline characters in data, as wc -l counts lines
+inline size_t count_lines(Span<const uint8_t> data) {
+    return count_byte(data, '\n');
+}
+
+// Digests in FileInfo.meta
+//
+// Plugins that produce or pass through file contents can describe them with
+// digest fields in the meta content, so clients can compare files without
+// reading them: "etag" is the quoted xxh64 of the contents (the form of an
+// HTTP ETag) and "crc32c" is eight hex digits.
+
+// "\"<16 hex digits>\"", an ETag for data
+inline std::string etag(Span<const uint8_t> data) {
+    std::string out = "\"";
+    internal::hex(out, xxh64(data), 16);
+    out += '"';
+    return out;
+}
+
+// Meta content JSON carrying the etag and crc32c of data
+inline std::string digest_content(Span<const uint8_t> data) {
+    std::string crc;
+    internal::hex(crc, crc32c(data), 8);
+    std::string out;
+    json::StringSink sink(out);
+    json::Writer<json::StringSink> w(sink);
+    w.begin_object();
+    w.key("etag");
+    w.value(etag(data));
+    w.key("crc32c");
+    w.value(crc);
+    w.end_object();
+    return out;
+}
+
+// Set info's meta content to the digests of data, keeping its name and type
+inline FileInfo& with_digests(FileInfo& info, Span<const uint8_t> data) {
+    if (!info.meta.has_value()) {
+        info.meta = MetaData();
+    }
+    info.meta->content = digest_content(data);
+    return info;
+}
+
+} // namespace simd
+} // namespace agfs
+
+#endif // AGFS_SIMD_H
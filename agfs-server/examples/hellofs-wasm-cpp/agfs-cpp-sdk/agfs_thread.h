@@ -0,0 +1,157 @@
+#ifndef AGFS_THREAD_H
+#define AGFS_THREAD_H
+
+#include "agfs_arena.h"
+#include <cstddef>
+#include <functional>
+
+#if defined(AGFS_THREADS)
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <pthread.h>
+#include <vector>
+#endif
+
+namespace agfs {
+
+// ThreadPool runs CPU-heavy work (compression, hashing, parallel host reads)
+// on worker threads within a single exported call.
+//
+// Threads are only available when the plugin is built with AGFS_THREADS
+// (`make build-wasi-threads`) and loaded by a runtime that implements
+// wasi-threads. Otherwise, or when no worker could be started, every task runs
+// inline on the calling thread, so code using the pool works in any build.
+//
+// Each worker has its own call_arena(), reset before every task, so arena
+// memory allocated inside a task is only valid until the task returns. Build
+// results for the host on the calling thread.
+class ThreadPool {
+public:
+    // Default worker count; override it with the constructor argument
+    static constexpr size_t kDefaultThreads = 4;
+
+    explicit ThreadPool(size_t threads = kDefaultThreads) {
+#if defined(AGFS_THREADS)
+        for (size_t i = 0; i < threads; i++) {
+            pthread_t tid;
+            if (pthread_create(&tid, nullptr, &ThreadPool::worker_main, this) != 0) {
+                break; // The runtime may not spawn threads; run inline instead
+            }
+            workers_.push_back(tid);
+        }
+#else
+        (void)threads; // unused
+#endif
+    }
+
+    ~ThreadPool() {
+#if defined(AGFS_THREADS)
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stopping_ = true;
+        }
+        work_cv_.notify_all();
+        for (pthread_t tid : workers_) {
+            pthread_join(tid, nullptr);
+        }
+#endif
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of worker threads actually running (0 means tasks run inline)
+    size_t size() const {
+#if defined(AGFS_THREADS)
+        return workers_.size();
+#else
+        return 0;
+#endif
+    }
+
+    // Queue a task; call wait() before using anything it writes
+    void submit(std::function<void()> task) {
+#if defined(AGFS_THREADS)
+        if (!workers_.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                tasks_.push_back(std::move(task));
+                pending_++;
+            }
+            work_cv_.notify_one();
+            return;
+        }
+#endif
+        task();
+    }
+
+    // Block until every submitted task has finished
+    void wait() {
+#if defined(AGFS_THREADS)
+        std::unique_lock<std::mutex> lock(mu_);
+        done_cv_.wait(lock, [this] { return pending_ == 0; });
+#endif
+    }
+
+    // Run fn(i) for every i in [0, n) across the pool and wait for all of them
+    template<typename Fn>
+    void parallel_for(size_t n, Fn&& fn) {
+        if (size() == 0 || n <= 1) {
+            for (size_t i = 0; i < n; i++) {
+                fn(i);
+            }
+            return;
+        }
+        for (size_t i = 0; i < n; i++) {
+            submit([&fn, i] { fn(i); });
+        }
+        wait();
+    }
+
+private:
+#if defined(AGFS_THREADS)
+    static void* worker_main(void* arg) {
+        static_cast<ThreadPool*>(arg)->run();
+        return nullptr;
+    }
+
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                work_cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return; // stopping
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+
+            call_arena().reset();
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                pending_--;
+                if (pending_ == 0) {
+                    done_cv_.notify_all();
+                }
+            }
+        }
+    }
+
+    std::vector<pthread_t> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mu_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    size_t pending_ = 0;
+    bool stopping_ = false;
+#endif
+};
+
+} // namespace agfs
+
+#endif // AGFS_THREAD_H
@@ -1,11 +1,15 @@
 #ifndef AGFS_TYPES_H
 #define AGFS_TYPES_H
 
+#include <chrono>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <optional>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <stdexcept>
 
 namespace agfs {
@@ -13,41 +17,42 @@ namespace agfs {
 // Forward declarations
 class MetaData;
 
-// Error types matching the Rust implementation
+// Error types matching the Rust implementation. The values are the codes
+// failed exports return to the host (see ffi::error_code()).
 enum class ErrorKind {
-    NotFound,
-    PermissionDenied,
-    AlreadyExists,
-    IsDirectory,
-    NotDirectory,
-    ReadOnly,
-    InvalidInput,
-    Io,
-    Other
+    NotFound = 1,
+    PermissionDenied = 2,
+    AlreadyExists = 3,
+    IsDirectory = 4,
+    NotDirectory = 5,
+    ReadOnly = 6,
+    InvalidInput = 7,
+    Io = 8,
+    Unsupported = 9,
+    Other = 10
 };
 
 // Error class
 class Error {
 public:
     ErrorKind kind;
-    std::string message;
+    std::string message; // Empty for the kind's default_message()
 
     Error(ErrorKind k, const std::string& msg = "") : kind(k), message(msg) {}
 
-    static Error not_found() { return Error(ErrorKind::NotFound, "file not found"); }
-    static Error permission_denied() { return Error(ErrorKind::PermissionDenied, "permission denied"); }
-    static Error already_exists() { return Error(ErrorKind::AlreadyExists, "file already exists"); }
-    static Error is_directory() { return Error(ErrorKind::IsDirectory, "is a directory"); }
-    static Error not_directory() { return Error(ErrorKind::NotDirectory, "not a directory"); }
-    static Error read_only() { return Error(ErrorKind::ReadOnly, "read-only filesystem"); }
+    static Error not_found() { return Error(ErrorKind::NotFound); }
+    static Error permission_denied() { return Error(ErrorKind::PermissionDenied); }
+    static Error already_exists() { return Error(ErrorKind::AlreadyExists); }
+    static Error is_directory() { return Error(ErrorKind::IsDirectory); }
+    static Error not_directory() { return Error(ErrorKind::NotDirectory); }
+    static Error read_only() { return Error(ErrorKind::ReadOnly); }
     static Error invalid_input(const std::string& msg) { return Error(ErrorKind::InvalidInput, msg); }
     static Error io(const std::string& msg) { return Error(ErrorKind::Io, msg); }
+    static Error unsupported() { return Error(ErrorKind::Unsupported); }
     static Error other(const std::string& msg) { return Error(ErrorKind::Other, msg); }
 
-    std::string to_string() const {
-        if (!message.empty()) {
-            return message;
-        }
+    // The message used when none was given
+    static const char* default_message(ErrorKind kind) {
         switch (kind) {
             case ErrorKind::NotFound: return "file not found";
             case ErrorKind::PermissionDenied: return "permission denied";
@@ -55,9 +60,22 @@ public:
             case ErrorKind::IsDirectory: return "is a directory";
             case ErrorKind::NotDirectory: return "not a directory";
             case ErrorKind::ReadOnly: return "read-only filesystem";
+            case ErrorKind::Unsupported: return "operation not supported";
             default: return "unknown error";
         }
     }
+
+    // Whether message says more than the kind alone
+    bool has_detail() const {
+        return !message.empty() && message != default_message(kind);
+    }
+
+    std::string to_string() const {
+        if (!message.empty()) {
+            return message;
+        }
+        return default_message(kind);
+    }
 };
 
 // Result type (similar to Rust's Result)
@@ -168,6 +186,112 @@ public:
     }
 };
 
+// Non-owning view over a contiguous buffer (std::span is C++20)
+template<typename T>
+class Span {
+private:
+    T* data_;
+    size_t size_;
+
+public:
+    Span() : data_(nullptr), size_(0) {}
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+
+    // View of a vector's elements
+    template<typename U>
+    Span(std::vector<U>& v) : data_(v.data()), size_(v.size()) {}
+    template<typename U>
+    Span(const std::vector<U>& v) : data_(v.data()), size_(v.size()) {}
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    T& operator[](size_t i) const { return data_[i]; }
+
+    // View of count elements starting at offset, clamped to this span
+    Span subspan(size_t offset, size_t count) const {
+        if (offset > size_) {
+            offset = size_;
+        }
+        if (count > size_ - offset) {
+            count = size_ - offset;
+        }
+        return Span(data_ + offset, count);
+    }
+};
+
+// The window [offset, offset + size) of content, clamped to its bounds; size
+// -1 means to the end. Only a view is returned, so serving a range costs no
+// more than the bytes the caller copies out of it.
+inline Span<const uint8_t> serve_range(Span<const uint8_t> content, int64_t offset, int64_t size) {
+    if (offset < 0 || (uint64_t)offset >= content.size()) {
+        return Span<const uint8_t>();
+    }
+    size_t count = size < 0 ? content.size() : (size_t)size;
+    return content.subspan((size_t)offset, count);
+}
+
+inline Span<const uint8_t> serve_range(const std::string& content, int64_t offset, int64_t size) {
+    return serve_range(Span<const uint8_t>((const uint8_t*)content.data(), content.size()), offset, size);
+}
+
+// The path of name inside directory dir
+inline std::string join_path(const std::string& dir, const std::string& name) {
+    if (!dir.empty() && dir.back() == '/') {
+        return dir + name;
+    }
+    return dir + "/" + name;
+}
+
+// Argument types of the FileSystem interface. Define AGFS_STRING_VIEW_API
+// before including agfs.h to receive paths as std::string_view and write
+// payloads as Span, both pointing straight into the host's arguments;
+// otherwise each call copies them into a std::string and std::vector.
+#if defined(AGFS_STRING_VIEW_API)
+using PathArg = std::string_view;
+using DataArg = Span<const uint8_t>;
+#else
+using PathArg = const std::string&;
+using DataArg = const std::vector<uint8_t>&;
+#endif
+
+// How the host may instantiate a plugin's module, see FileSystem::concurrency()
+enum class Concurrency : uint32_t {
+    Exclusive = 0,      // State lives in the instance; one instance, one call at a time
+    Stateless = 1,      // No state beyond the config; any instance can serve any call
+    SharedHostState = 2 // Mutable state lives on the host, shared by every instance
+};
+
+// Optional operations a plugin implements, reported to the host through the
+// plugin_capabilities export (see plugin_capabilities<T>() in agfs_export.h).
+// stat, readdir, read and read_into are always available.
+enum Capability : uint32_t {
+    CapWrite       = 1 << 0,
+    CapCreate      = 1 << 1,
+    CapMkdir       = 1 << 2,
+    CapRemove      = 1 << 3,
+    CapRemoveAll   = 1 << 4,
+    CapRename      = 1 << 5,
+    CapChmod       = 1 << 6,
+    CapStreaming   = 1 << 7, // open/read_chunk/write_chunk/close
+    CapReadDirPage = 1 << 8,
+    CapSnapshot    = 1 << 9, // snapshot/restore
+    CapCopy        = 1 << 10,
+    CapWarmup      = 1 << 11  // warmup
+};
+
+// Opaque handle for streaming I/O; valid handles are always positive
+using FileHandle = int64_t;
+
+// Flags for FileSystem::open() and HostFS::open()
+enum OpenFlags : uint32_t {
+    OpenRead = 1,
+    OpenWrite = 2
+};
+
 // Metadata structure
 class MetaData {
 public:
@@ -224,6 +348,44 @@ public:
     }
 };
 
+// One read of a HostFS::read_many() batch; size -1 reads to end of file
+struct ReadRequest {
+    std::string path;
+    int64_t offset;
+    int64_t size;
+
+    ReadRequest(const std::string& p, int64_t off = 0, int64_t sz = -1)
+        : path(p), offset(off), size(sz) {}
+};
+
+// An operation started with HostFS::submit_read(); valid tickets are positive
+using Ticket = int64_t;
+
+// The end of a bounded slice of work, such as one FileSystem::warmup() call
+class Deadline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Deadline(std::chrono::microseconds budget) : end_(Clock::now() + budget) {}
+
+    bool expired() const { return Clock::now() >= end_; }
+
+private:
+    Clock::time_point end_;
+};
+
+// Default number of entries per readdir_page() batch
+constexpr size_t kDirPageSize = 1024;
+
+// One batch of a paginated directory listing
+class DirPage {
+public:
+    std::vector<FileInfo> entries;
+    std::string next_cursor; // Opaque; empty once the listing is complete
+
+    bool done() const { return next_cursor.empty(); }
+};
+
 // Configuration class
 class Config {
 public:
@@ -237,10 +399,16 @@ public:
         return nullptr;
     }
 
+    // default_value also stands in for a value that is not an integer; use
+    // ConfigSchema (agfs_config.h) to report those instead
     int64_t get_i64(const char* key, int64_t default_value = 0) const {
         auto it = values.find(key);
-        if (it != values.end()) {
-            return std::stoll(it->second);
+        if (it != values.end() && !it->second.empty()) {
+            char* end = nullptr;
+            long long v = std::strtoll(it->second.c_str(), &end, 10);
+            if (end == it->second.c_str() + it->second.size()) {
+                return v;
+            }
         }
         return default_value;
     }
@@ -0,0 +1,416 @@
+#ifndef AGFS_WIRE_H
+#define AGFS_WIRE_H
+
+#include "agfs_types.h"
+#include <cstring>
+
+namespace agfs {
+namespace wire {
+
+// Binary FileInfo wire format (little-endian), used for stat/readdir results
+// in both directions once ABI version 2 has been negotiated:
+//
+//   header  u32 total_len      size of the whole buffer, header included
+//           u16 version        kFormatVersion
+//           u16 reserved
+//           u32 count          number of records
+//   record  i64 size
+//           i64 mod_time       Unix seconds, 0 if unknown
+//           u32 mode
+//           u32 flags          kFlagDir | kFlagMeta
+//           u32 name_len
+//           u32 meta_len       size of the meta block, 0 without kFlagMeta
+//           name bytes
+//           meta block         u32 len + MetaData.name,
+//                              u32 len + MetaData.type,
+//                              u32 len + MetaData.content (JSON)
+//
+// A readdir page (fs_readdir_page/host_fs_readdir_page) is the same buffer
+// followed by u32 cursor_len + next cursor bytes, with total_len covering only
+// the FileInfo part.
+//
+// Nothing is aligned; integers are assembled byte by byte. The
+// encoder writes into a caller-provided buffer and the decoder produces
+// views into the input, so neither allocates.
+
+constexpr uint16_t kFormatVersion = 1;
+constexpr size_t kHeaderSize = 12;
+constexpr size_t kRecordHeaderSize = 32;
+
+constexpr uint32_t kFlagDir = 1u << 0;
+constexpr uint32_t kFlagMeta = 1u << 1;
+
+inline uint8_t* put_u16(uint8_t* out, uint16_t v) {
+    out[0] = (uint8_t)v;
+    out[1] = (uint8_t)(v >> 8);
+    return out + 2;
+}
+
+inline uint8_t* put_u32(uint8_t* out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(v >> (8 * i));
+    }
+    return out + 4;
+}
+
+inline uint8_t* put_u64(uint8_t* out, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(v >> (8 * i));
+    }
+    return out + 8;
+}
+
+inline uint8_t* put_bytes(uint8_t* out, const void* data, size_t len) {
+    if (len > 0) {
+        std::memcpy(out, data, len);
+    }
+    return out + len;
+}
+
+inline size_t meta_size(const FileInfo& info) {
+    if (!info.meta.has_value()) {
+        return 0;
+    }
+    return 12 + info.meta->name.size() + info.meta->type.size() + info.meta->content.size();
+}
+
+// Encoded size of a single record
+inline size_t record_size(const FileInfo& info) {
+    return kRecordHeaderSize + info.name.size() + meta_size(info);
+}
+
+// Encoded size of a buffer holding one record (stat)
+inline size_t encoded_size(const FileInfo& info) {
+    return kHeaderSize + record_size(info);
+}
+
+// Encoded size of a buffer holding every entry (readdir)
+inline size_t encoded_size(const std::vector<FileInfo>& infos) {
+    size_t total = kHeaderSize;
+    for (const auto& info : infos) {
+        total += record_size(info);
+    }
+    return total;
+}
+
+inline uint8_t* encode_header(uint8_t* out, uint32_t total_len, uint32_t count) {
+    out = put_u32(out, total_len);
+    out = put_u16(out, kFormatVersion);
+    out = put_u16(out, 0);
+    return put_u32(out, count);
+}
+
+// Encode one record at out and return the end of what was written
+inline uint8_t* encode_record(uint8_t* out, const FileInfo& info) {
+    uint32_t flags = (info.is_dir ? kFlagDir : 0) | (info.meta.has_value() ? kFlagMeta : 0);
+    out = put_u64(out, (uint64_t)info.size);
+    out = put_u64(out, (uint64_t)info.mod_time);
+    out = put_u32(out, info.mode);
+    out = put_u32(out, flags);
+    out = put_u32(out, (uint32_t)info.name.size());
+    out = put_u32(out, (uint32_t)meta_size(info));
+    out = put_bytes(out, info.name.data(), info.name.size());
+    if (info.meta.has_value()) {
+        const MetaData& m = *info.meta;
+        out = put_u32(out, (uint32_t)m.name.size());
+        out = put_bytes(out, m.name.data(), m.name.size());
+        out = put_u32(out, (uint32_t)m.type.size());
+        out = put_bytes(out, m.type.data(), m.type.size());
+        out = put_u32(out, (uint32_t)m.content.size());
+        out = put_bytes(out, m.content.data(), m.content.size());
+    }
+    return out;
+}
+
+// Encode a stat result into out, which must hold encoded_size(info) bytes
+inline uint8_t* encode(uint8_t* out, const FileInfo& info) {
+    out = encode_header(out, (uint32_t)encoded_size(info), 1);
+    return encode_record(out, info);
+}
+
+// Encode a readdir result into out, which must hold encoded_size(infos) bytes
+inline uint8_t* encode(uint8_t* out, const std::vector<FileInfo>& infos) {
+    out = encode_header(out, (uint32_t)encoded_size(infos), (uint32_t)infos.size());
+    for (const auto& info : infos) {
+        out = encode_record(out, info);
+    }
+    return out;
+}
+
+// Encoded size of a readdir page
+inline size_t encoded_size(const DirPage& page) {
+    return encoded_size(page.entries) + 4 + page.next_cursor.size();
+}
+
+// Encode a readdir page into out, which must hold encoded_size(page) bytes
+inline uint8_t* encode(uint8_t* out, const DirPage& page) {
+    out = encode(out, page.entries);
+    out = put_u32(out, (uint32_t)page.next_cursor.size());
+    return put_bytes(out, page.next_cursor.data(), page.next_cursor.size());
+}
+
+inline uint32_t get_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) |
+           ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+inline uint64_t get_u64(const uint8_t* in) {
+    return (uint64_t)get_u32(in) | ((uint64_t)get_u32(in + 4) << 32);
+}
+
+// Read the total_len field of a buffer
+inline uint32_t peek_total_len(const uint8_t* buf) {
+    return get_u32(buf);
+}
+
+// Non-owning view of one decoded record; strings point into the input buffer
+struct StringView {
+    const char* data;
+    uint32_t len;
+
+    std::string str() const { return std::string(data, len); }
+};
+
+struct FileInfoView {
+    int64_t size;
+    int64_t mod_time;
+    uint32_t mode;
+    bool is_dir;
+    bool has_meta;
+    StringView name;
+    StringView meta_name;
+    StringView meta_type;
+    StringView meta_content;
+
+    // Materialize an owning FileInfo
+    FileInfo to_fileinfo() const {
+        FileInfo info;
+        info.name = name.str();
+        info.size = size;
+        info.mode = mode;
+        info.mod_time = mod_time;
+        info.is_dir = is_dir;
+        if (has_meta) {
+            info.meta = MetaData(meta_name.str(), meta_type.str(), meta_content.str());
+        }
+        return info;
+    }
+};
+
+// Bounds-checked, allocation-free decoder over an encoded buffer
+class Decoder {
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+    uint32_t count_;
+    uint32_t read_;
+    bool ok_;
+
+    bool need(size_t n) {
+        if (!ok_ || (size_t)(end_ - p_) < n) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t u32() {
+        uint32_t v = get_u32(p_);
+        p_ += 4;
+        return v;
+    }
+
+    uint64_t u64() {
+        uint64_t lo = u32();
+        uint64_t hi = u32();
+        return lo | (hi << 32);
+    }
+
+    bool string(StringView& out) {
+        if (!need(4)) {
+            return false;
+        }
+        uint32_t len = u32();
+        if (!need(len)) {
+            return false;
+        }
+        out.data = reinterpret_cast<const char*>(p_);
+        out.len = len;
+        p_ += len;
+        return true;
+    }
+
+public:
+    // buf must hold at least len bytes; len is normally peek_total_len(buf)
+    Decoder(const uint8_t* buf, size_t len)
+        : p_(buf), end_(buf + len), count_(0), read_(0), ok_(true) {
+        if (!need(kHeaderSize)) {
+            return;
+        }
+        uint32_t total = u32();
+        uint16_t version = (uint16_t)(p_[0] | (p_[1] << 8));
+        p_ += 4; // version + reserved
+        count_ = u32();
+        if (version != kFormatVersion || total > len || total < kHeaderSize) {
+            ok_ = false;
+            return;
+        }
+        end_ = buf + total;
+    }
+
+    bool ok() const { return ok_; }
+    uint32_t count() const { return count_; }
+
+    // Decode the next record. Returns false at the end or on malformed input.
+    bool next(FileInfoView& out) {
+        if (!ok_ || read_ >= count_ || !need(kRecordHeaderSize)) {
+            return false;
+        }
+        out.size = (int64_t)u64();
+        out.mod_time = (int64_t)u64();
+        out.mode = u32();
+        uint32_t flags = u32();
+        out.name.len = u32();
+        uint32_t meta_len = u32();
+        out.is_dir = (flags & kFlagDir) != 0;
+        out.has_meta = (flags & kFlagMeta) != 0;
+        if (!need(out.name.len)) {
+            return false;
+        }
+        out.name.data = reinterpret_cast<const char*>(p_);
+        p_ += out.name.len;
+        if (out.has_meta) {
+            const uint8_t* meta_end = p_ + meta_len;
+            if (!need(meta_len) || !string(out.meta_name) ||
+                !string(out.meta_type) || !string(out.meta_content) || p_ != meta_end) {
+                ok_ = false;
+                return false;
+            }
+        } else {
+            if (!need(meta_len)) {
+                return false;
+            }
+            p_ += meta_len; // skip unknown trailing data
+        }
+        read_++;
+        return true;
+    }
+};
+
+// Decode a readdir page produced by encode(out, DirPage)
+inline DirPage decode_page(const uint8_t* buf) {
+    DirPage page;
+    uint32_t total = peek_total_len(buf);
+    Decoder decoder(buf, total);
+    if (!decoder.ok()) {
+        return page;
+    }
+    page.entries.reserve(decoder.count());
+    FileInfoView view;
+    while (decoder.next(view)) {
+        page.entries.push_back(view.to_fileinfo());
+    }
+    uint32_t cursor_len = get_u32(buf + total);
+    page.next_cursor.assign(reinterpret_cast<const char*>(buf + total + 4), cursor_len);
+    return page;
+}
+
+// Batched host calls (host_fs_batch) share the buffer header, with count
+// giving the number of operations:
+//
+//   request entry   u32 op             kBatchStat | kBatchRead
+//                   u32 path_len
+//                   i64 offset         read only
+//                   i64 size           read only, -1 for the whole file
+//                   path bytes
+//   response entry  u32 op
+//                   u32 status         kBatchOk, or the ErrorKind of the
+//                                      failure (kBatchError before
+//                                      kAbiErrorCodes)
+//                   u32 payload_len
+//                   payload            stat: a FileInfo buffer with one record
+//                                      read: the data
+//                                      error: the message
+//
+// Responses come back in request order.
+
+constexpr uint32_t kBatchStat = 1;
+constexpr uint32_t kBatchRead = 2;
+
+constexpr uint32_t kBatchOk = 0;
+constexpr uint32_t kBatchError = 1;
+
+constexpr size_t kBatchEntryHeaderSize = 24;
+constexpr size_t kBatchResultHeaderSize = 12;
+
+// Encoded size of one request entry
+inline size_t batch_entry_size(std::string_view path) {
+    return kBatchEntryHeaderSize + path.size();
+}
+
+inline uint8_t* encode_batch_entry(uint8_t* out, uint32_t op, std::string_view path,
+                                   int64_t offset, int64_t size) {
+    out = put_u32(out, op);
+    out = put_u32(out, (uint32_t)path.size());
+    out = put_u64(out, (uint64_t)offset);
+    out = put_u64(out, (uint64_t)size);
+    return put_bytes(out, path.data(), path.size());
+}
+
+// One response entry; data points into the response buffer
+struct BatchResultView {
+    uint32_t op;
+    uint32_t status;
+    const uint8_t* data;
+    uint32_t len;
+};
+
+// Bounds-checked decoder over a host_fs_batch response
+class BatchDecoder {
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+    uint32_t count_;
+    uint32_t read_;
+    bool ok_;
+
+public:
+    explicit BatchDecoder(const uint8_t* buf)
+        : p_(buf), end_(buf), count_(0), read_(0), ok_(false) {
+        uint32_t total = peek_total_len(buf);
+        uint16_t version = (uint16_t)(buf[4] | (buf[5] << 8));
+        if (version != kFormatVersion || total < kHeaderSize) {
+            return;
+        }
+        count_ = get_u32(buf + 8);
+        p_ = buf + kHeaderSize;
+        end_ = buf + total;
+        ok_ = true;
+    }
+
+    bool ok() const { return ok_; }
+    uint32_t count() const { return count_; }
+
+    bool next(BatchResultView& out) {
+        if (!ok_ || read_ >= count_ || (size_t)(end_ - p_) < kBatchResultHeaderSize) {
+            return false;
+        }
+        out.op = get_u32(p_);
+        out.status = get_u32(p_ + 4);
+        out.len = get_u32(p_ + 8);
+        p_ += kBatchResultHeaderSize;
+        if ((size_t)(end_ - p_) < out.len) {
+            ok_ = false;
+            return false;
+        }
+        out.data = p_;
+        p_ += out.len;
+        read_++;
+        return true;
+    }
+};
+
+} // namespace wire
+} // namespace agfs
+
+#endif // AGFS_WIRE_H
@@ -0,0 +1,162 @@
+// BenchFS - fixture plugin for `make bench`
+//
+// Serves synthetic files and directories of fixed sizes so the Go benchmarks
+// in pkg/plugin/loader measure the cost of the FFI path itself:
+//   /dir/<n>     a directory of n empty files
+//   /file/<n>    a file of n bytes (1, 65536 and 16777216 are registered)
+//   /sink        accepts and discards writes
+//   /host/*      passes straight through to agfs::HostFS
+
+#define AGFS_STRING_VIEW_API 1
+#include "../agfs-cpp-sdk/agfs.h"
+
+#include <cstdlib>
+
+enum class Route { Root, Dir, File, Sink, Host };
+
+static const int64_t kFileSizes[] = {1, 64 * 1024, 16 * 1024 * 1024};
+
+class BenchFS : public agfs::FileSystem {
+private:
+    agfs::Router<Route> routes;
+    std::map<size_t, std::vector<agfs::FileInfo>> listings; // Built on first use
+
+    static size_t parse_size(std::string_view s) {
+        return (size_t)std::strtoull(std::string(s).c_str(), nullptr, 10);
+    }
+
+    static std::string host_path_of(const agfs::RouteMatch<Route>& m) {
+        return m.rest.empty() ? std::string("/") : std::string(m.rest);
+    }
+
+    bool has_file(size_t size) const {
+        for (int64_t s : kFileSizes) {
+            if ((size_t)s == size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<agfs::FileInfo>& listing(size_t n) {
+        auto it = listings.find(n);
+        if (it == listings.end()) {
+            std::vector<agfs::FileInfo> entries;
+            entries.reserve(n);
+            for (size_t i = 0; i < n; i++) {
+                entries.push_back(agfs::FileInfo::file("f" + std::to_string(i), 0, 0644));
+            }
+            it = listings.emplace(n, std::move(entries)).first;
+        }
+        return it->second;
+    }
+
+public:
+    const char* name() const override {
+        return "benchfs";
+    }
+
+    agfs::Concurrency concurrency() const override {
+        return agfs::Concurrency::Stateless;
+    }
+
+    agfs::Result<void> initialize(const agfs::Config& config) override {
+        (void)config;
+        routes.clear();
+        routes.add("/", Route::Root);
+        routes.add("/dir/:n", Route::Dir);
+        routes.add("/file/:n", Route::File);
+        routes.add("/sink", Route::Sink);
+        routes.add("/host/*", Route::Host);
+        for (int64_t size : kFileSizes) {
+            provide("/file/" + std::to_string(size), size, [](int64_t offset, agfs::Span<uint8_t> out) {
+                (void)offset;
+                std::memset(out.data(), 'x', out.size());
+                return out.size();
+            });
+        }
+        return agfs::Result<void>();
+    }
+
+    agfs::Result<agfs::FileInfo> stat(std::string_view path) override {
+        auto m = routes.match(path);
+        if (!m) {
+            return agfs::Error::not_found();
+        }
+        switch (*m.value) {
+            case Route::Root:
+                return agfs::FileInfo::dir("", 0755);
+            case Route::Dir:
+                return agfs::FileInfo::dir(std::string(m.params[0]), 0755);
+            case Route::File: {
+                size_t size = parse_size(m.params[0]);
+                if (!has_file(size)) {
+                    return agfs::Error::not_found();
+                }
+                return agfs::FileInfo::file(std::string(m.params[0]), (int64_t)size, 0644);
+            }
+            case Route::Sink:
+                return agfs::FileInfo::file("sink", 0, 0644);
+            case Route::Host:
+                return agfs::HostFS::stat(host_path_of(m));
+        }
+        return agfs::Error::not_found();
+    }
+
+    agfs::Result<std::vector<agfs::FileInfo>> readdir(std::string_view path) override {
+        auto m = routes.match(path);
+        if (!m) {
+            return agfs::Error::not_found();
+        }
+        switch (*m.value) {
+            case Route::Dir:
+                return listing(parse_size(m.params[0]));
+            case Route::Host:
+                return agfs::HostFS::readdir(host_path_of(m));
+            case Route::Root: {
+                std::vector<agfs::FileInfo> entries;
+                entries.push_back(agfs::FileInfo::dir("dir", 0755));
+                entries.push_back(agfs::FileInfo::dir("file", 0755));
+                entries.push_back(agfs::FileInfo::file("sink", 0, 0644));
+                entries.push_back(agfs::FileInfo::dir("host", 0755));
+                return entries;
+            }
+            default:
+                return agfs::Error::not_directory();
+        }
+    }
+
+    agfs::Result<std::vector<uint8_t>> read(std::string_view path, int64_t offset, int64_t size) override {
+        auto m = routes.match(path);
+        if (m && *m.value == Route::Host) {
+            return agfs::HostFS::read(host_path_of(m), offset, size);
+        }
+        return agfs::Error::not_found();
+    }
+
+    agfs::Result<size_t> read_into(std::string_view path, int64_t offset,
+                                   agfs::Span<uint8_t> out) override {
+        auto m = routes.match(path);
+        if (m && *m.value == Route::Host) {
+            return agfs::HostFS::read_into(host_path_of(m), offset, out);
+        }
+        return agfs::Error::not_found();
+    }
+
+    agfs::Result<std::vector<uint8_t>> write(std::string_view path,
+                                            agfs::Span<const uint8_t> data) override {
+        auto m = routes.match(path);
+        if (!m) {
+            return agfs::Error::not_found();
+        }
+        if (*m.value == Route::Sink) {
+            return std::vector<uint8_t>();
+        }
+        if (*m.value == Route::Host) {
+            return agfs::HostFS::write(host_path_of(m), data);
+        }
+        return agfs::Error::permission_denied();
+    }
+};
+
+AGFS_EXPORT_PLUGIN(BenchFS)
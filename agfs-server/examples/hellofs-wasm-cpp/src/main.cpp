@@ -4,16 +4,47 @@
 // Returns a single file with "Hello World" content
 // Also demonstrates accessing the host filesystem
 
+// Take paths as std::string_view and write payloads as Span, straight from
+// the host's arguments
+#define AGFS_STRING_VIEW_API 1
 #include "../agfs-cpp-sdk/agfs.h"
 
-class HelloFS : public agfs::FileSystem {
+static const char kHello[] = "Hello World from C++\n";
+
+enum class Route { Host };
+
+// Plugin config, parsed once by schema(); defaults are the initializers
+struct Settings {
+    std::string host_prefix; // Host directory served under /host; empty disables it
+};
+
+// /hello.txt and the /host directory live in a MemTreeFS tree; everything
+// below /host is routed to the host
+class HelloFS : public agfs::MemTreeFS {
 private:
     std::string host_prefix;
+    agfs::CachedHostFS host; // Metadata and data under /host, cached for a short TTL
+    agfs::Router<Route> routes;
+
+    // Config keys of Settings
+    static const agfs::ConfigSchema<Settings>& schema() {
+        static const auto s = agfs::ConfigSchema<Settings>()
+            .field("host_prefix", &Settings::host_prefix);
+        return s;
+    }
+
+    // Host path for a /host route: the prefix plus what "*" matched
+    std::string host_path_of(const agfs::RouteMatch<Route>& m) const {
+        std::string host_path = host_prefix;
+        host_path.append(m.rest.data(), m.rest.size());
+        return host_path;
+    }
 
     // Convert /host/xxx to actual host path, or return empty if not host path
-    std::string get_host_path(const std::string& path) const {
-        if (path.rfind("/host/", 0) == 0 && !host_prefix.empty()) {
-            return host_prefix + path.substr(5);  // Remove "/host", add prefix
+    std::string get_host_path(std::string_view path) const {
+        auto m = routes.match(path);
+        if (m && *m.value == Route::Host && !m.rest.empty()) {
+            return host_path_of(m);
         }
         return "";
     }
@@ -29,116 +60,174 @@ public:
                " - /host/* - Proxies to host filesystem (if configured host_prefix)";
     }
 
+    agfs::Result<void> validate(const agfs::Config& config) override {
+        auto result = schema().validate(config);
+        if (result.is_err()) {
+            return result;
+        }
+        return agfs::CachedHostFS::options_schema().validate(config);
+    }
+
     agfs::Result<void> initialize(const agfs::Config& config) override {
-        // Get optional host_prefix from config
-        const char* prefix = config.get_str("host_prefix");
-        if (prefix != nullptr) {
-            host_prefix = prefix;
+        auto settings = schema().parse(config);
+        if (settings.is_err()) {
+            return settings.unwrap_err();
+        }
+        host_prefix = settings.unwrap().host_prefix;
+        auto configured = host.configure(config);
+        if (configured.is_err()) {
+            return configured;
+        }
+        routes.clear();
+        clear_tree();
+        add_file("/hello.txt", std::string_view(kHello, sizeof(kHello) - 1));
+        if (!host_prefix.empty()) {
+            routes.add("/host/*", Route::Host);
+            add_dir("/host");
         }
         return agfs::Result<void>();
     }
 
-    agfs::Result<std::vector<uint8_t>> read(const std::string& path,
+    agfs::Result<void> shutdown() override {
+        return host.flush();
+    }
+
+    // The CachedHostFS caches (and any buffered writes) are per instance, so
+    // a pooled instance could serve stale /host data after another one wrote.
+    // The server asks before initialize(), so this cannot depend on
+    // host_cache_ttl_ms; keep a single instance.
+    agfs::Concurrency concurrency() const override {
+        return agfs::Concurrency::Exclusive;
+    }
+
+    agfs::Result<std::vector<uint8_t>> read(std::string_view path,
                                            int64_t offset, int64_t size) override {
-        if (path == "/hello.txt") {
-            std::string content = "Hello World from C++\n";
-            std::vector<uint8_t> data(content.begin(), content.end());
-            return data;
-        }
         auto host_path = get_host_path(path);
         if (!host_path.empty()) {
-            return agfs::HostFS::read(host_path, offset, size);
+            return host.read(host_path, offset, size);
         }
-        return agfs::Error::not_found();
+        return agfs::MemTreeFS::read(path, offset, size);
     }
 
-    agfs::Result<agfs::FileInfo> stat(const std::string& path) override {
-        if (path == "/") {
-            return agfs::FileInfo::dir("", 0755);
-        }
-        if (path == "/hello.txt") {
-            return agfs::FileInfo::file("hello.txt", 21, 0644);
+    agfs::Result<size_t> read_into(std::string_view path, int64_t offset,
+                                   agfs::Span<uint8_t> out) override {
+        // Host reads land directly in the caller's buffer
+        auto host_path = get_host_path(path);
+        if (!host_path.empty()) {
+            return host.read_into(host_path, offset, out);
         }
-        if (path == "/host" && !host_prefix.empty()) {
-            return agfs::FileInfo::dir("host", 0755);
+        return agfs::MemTreeFS::read_into(path, offset, out);
+    }
+
+    // Stream /host/* files in chunks; handles come from HostFS once buffered
+    // writes to the file are sent
+    agfs::Result<agfs::FileHandle> open(std::string_view path, uint32_t flags) override {
+        auto host_path = get_host_path(path);
+        if (!host_path.empty()) {
+            return host.open(host_path, flags);
         }
+        return agfs::Error::unsupported();
+    }
+
+    agfs::Result<size_t> read_chunk(agfs::FileHandle handle, agfs::Span<uint8_t> out) override {
+        return agfs::HostFS::read_chunk(handle, out);
+    }
+
+    agfs::Result<size_t> write_chunk(agfs::FileHandle handle,
+                                     agfs::Span<const uint8_t> data) override {
+        return agfs::HostFS::write_chunk(handle, data);
+    }
+
+    agfs::Result<void> close(agfs::FileHandle handle) override {
+        return agfs::HostFS::close(handle);
+    }
+
+    agfs::Result<agfs::FileInfo> stat(std::string_view path) override {
         auto host_path = get_host_path(path);
         if (!host_path.empty()) {
-            return agfs::HostFS::stat(host_path);
+            return host.stat(host_path);
         }
-        return agfs::Error::not_found();
+        return agfs::MemTreeFS::stat(path);
     }
 
-    agfs::Result<std::vector<agfs::FileInfo>> readdir(const std::string& path) override {
-        if (path == "/") {
-            std::vector<agfs::FileInfo> entries;
-            entries.push_back(agfs::FileInfo::file("hello.txt", 21, 0644));
-            if (!host_prefix.empty()) {
-                entries.push_back(agfs::FileInfo::dir("host", 0755));
-            }
-            return entries;
+    agfs::Result<std::vector<agfs::FileInfo>> readdir(std::string_view path) override {
+        auto m = routes.match(path);
+        if (m && *m.value == Route::Host) {
+            return host.readdir(host_path_of(m));
         }
-        if (path == "/host" && !host_prefix.empty()) {
-            return agfs::HostFS::readdir(host_prefix);
+        return agfs::MemTreeFS::readdir(path);
+    }
+
+    // The /host node is empty in the tree; its listing comes from the host
+    const agfs::ffi::EncodedResult* encoded_readdir(std::string_view path) override {
+        auto m = routes.match(path);
+        if (m && *m.value == Route::Host) {
+            return nullptr;
         }
-        auto host_path = get_host_path(path);
-        if (!host_path.empty()) {
-            return agfs::HostFS::readdir(host_path);
+        return agfs::MemTreeFS::encoded_readdir(path);
+    }
+
+    agfs::Result<agfs::DirPage> readdir_page(std::string_view path, std::string_view cursor,
+                                             size_t max_entries) override {
+        // Host listings can be huge, so page them straight through
+        auto m = routes.match(path);
+        if (m && *m.value == Route::Host) {
+            return host.readdir_page(host_path_of(m), cursor, max_entries);
         }
-        return agfs::Error::not_found();
+        return agfs::MemTreeFS::readdir_page(path, cursor, max_entries);
     }
 
-    agfs::Result<std::vector<uint8_t>> write(const std::string& path,
-                                            const std::vector<uint8_t>& data) override {
+    agfs::Result<std::vector<uint8_t>> write(std::string_view path,
+                                            agfs::Span<const uint8_t> data) override {
         auto host_path = get_host_path(path);
         if (!host_path.empty()) {
-            return agfs::HostFS::write(host_path, data);
+            return host.write(host_path, data);
         }
         return agfs::Error::permission_denied();
     }
 
-    agfs::Result<void> create(const std::string& path) override {
+    agfs::Result<void> create(std::string_view path) override {
         auto host_path = get_host_path(path);
         if (!host_path.empty()) {
-            return agfs::HostFS::create(host_path);
+            return host.create(host_path);
         }
         return agfs::Error::permission_denied();
     }
 
-    agfs::Result<void> mkdir(const std::string& path, uint32_t perm) override {
+    agfs::Result<void> mkdir(std::string_view path, uint32_t perm) override {
         auto host_path = get_host_path(path);
         if (!host_path.empty()) {
-            return agfs::HostFS::mkdir(host_path, perm);
+            return host.mkdir(host_path, perm);
         }
         return agfs::Error::permission_denied();
     }
 
-    agfs::Result<void> remove(const std::string& path) override {
+    agfs::Result<void> remove(std::string_view path) override {
         auto host_path = get_host_path(path);
         if (!host_path.empty()) {
-            return agfs::HostFS::remove(host_path);
+            return host.remove(host_path);
         }
         return agfs::Error::permission_denied();
     }
 
-    agfs::Result<void> remove_all(const std::string& path) override {
+    agfs::Result<void> remove_all(std::string_view path) override {
         auto host_path = get_host_path(path);
         if (!host_path.empty()) {
-            return agfs::HostFS::remove_all(host_path);
+            return host.remove_all(host_path);
         }
         return agfs::Error::permission_denied();
     }
 
-    agfs::Result<void> rename(const std::string& old_path, const std::string& new_path) override {
+    agfs::Result<void> rename(std::string_view old_path, std::string_view new_path) override {
         auto host_old = get_host_path(old_path);
         auto host_new = get_host_path(new_path);
         if (!host_old.empty() && !host_new.empty()) {
-            return agfs::HostFS::rename(host_old, host_new);
+            return host.rename(host_old, host_new);
         }
         return agfs::Error::permission_denied();
     }
 
-    agfs::Result<void> chmod(const std::string& path, uint32_t mode) override {
+    agfs::Result<void> chmod(std::string_view path, uint32_t mode) override {
         (void)path; (void)mode;
         return agfs::Result<void>(); // no-op
     }
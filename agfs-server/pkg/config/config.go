@@ -27,6 +27,7 @@ type ExternalPluginsConfig struct {
 	AutoLoad      bool     `yaml:"auto_load"`
 	PluginPaths   []string `yaml:"plugin_paths"`
 	WASIMountPath string   `yaml:"wasi_mount_path"` // Directory to mount for WASI filesystem access
+	WASMCacheDir  string   `yaml:"wasm_cache_dir"`  // Directory for compiled WASM modules and plugin snapshots
 }
 
 // PluginConfig can be either a single plugin or an array of plugin instances
@@ -0,0 +1,87 @@
+package filesystem
+
+import (
+	"io"
+)
+
+// Copier is implemented by file systems that can copy a byte range from one
+// file to another without the caller moving the data
+type Copier interface {
+	// Copy writes size bytes (-1 for the rest of the file) of src starting at
+	// offset to dst, replacing dst, and returns the number of bytes copied
+	Copy(src, dst string, offset, size int64) (int64, error)
+}
+
+// Copy copies a byte range of src to dst within fs, through fs's Copier if it
+// has one and by streaming otherwise
+func Copy(fs FileSystem, src, dst string, offset, size int64) (int64, error) {
+	if NormalizePath(src) == NormalizePath(dst) {
+		return copySelf(fs, src, offset, size)
+	}
+	if copier, ok := fs.(Copier); ok {
+		return copier.Copy(src, dst, offset, size)
+	}
+	return CopyStream(fs, src, dst, offset, size)
+}
+
+// CopyStream copies a byte range of src to dst by streaming from fs.Open to
+// fs.OpenWrite, so the data is never held in memory at once. Copier
+// implementations fall back to it for the cases they cannot shortcut. When
+// both ends are local files io.Copy lets the kernel move the bytes.
+func CopyStream(fs FileSystem, src, dst string, offset, size int64) (int64, error) {
+	if offset < 0 {
+		return 0, NewInvalidArgumentError("offset", offset, "must not be negative")
+	}
+	if NormalizePath(src) == NormalizePath(dst) {
+		return copySelf(fs, src, offset, size)
+	}
+
+	r, err := fs.Open(src)
+	if err != nil {
+		return 0, err
+	}
+	defer r.Close()
+
+	if offset > 0 {
+		if seeker, ok := r.(io.Seeker); ok {
+			_, err = seeker.Seek(offset, io.SeekStart)
+		} else {
+			_, err = io.CopyN(io.Discard, r, offset)
+		}
+		if err != nil && err != io.EOF {
+			return 0, err
+		}
+	}
+
+	w, err := fs.OpenWrite(dst)
+	if err != nil {
+		return 0, err
+	}
+
+	var in io.Reader = r
+	if size >= 0 {
+		in = &io.LimitedReader{R: r, N: size}
+	}
+	n, err := io.Copy(w, in)
+	if closeErr := w.Close(); err == nil {
+		err = closeErr
+	}
+	return n, err
+}
+
+// copySelf handles a copy whose source is also its destination. Opening dst
+// for writing would truncate src before it is read, so copying the whole file
+// onto itself is a no-op that reports its size, and a partial copy is refused.
+func copySelf(fs FileSystem, path string, offset, size int64) (int64, error) {
+	info, err := fs.Stat(path)
+	if err != nil {
+		return 0, err
+	}
+	if info.IsDir {
+		return 0, NewInvalidArgumentError("src", path, "is a directory")
+	}
+	if offset != 0 || (size >= 0 && size < info.Size) {
+		return 0, NewInvalidArgumentError("dst", path, "must differ from src for a partial copy")
+	}
+	return info.Size, nil
+}
@@ -89,6 +89,15 @@ type Streamer interface {
 	OpenStream(path string) (StreamReader, error)
 }
 
+// DirPager is implemented by file systems that can list a directory in
+// bounded batches instead of materializing every entry at once
+type DirPager interface {
+	// ReadDirPage returns at most limit entries starting at cursor
+	// Pass "" as the first cursor; next is "" once the listing is complete
+	// Cursors are opaque and only valid for the same path
+	ReadDirPage(path string, cursor string, limit int) (entries []FileInfo, next string, err error)
+}
+
 // Toucher is implemented by file systems that support efficient touch operations
 // Touch updates the modification time without reading/writing the entire file content
 type Toucher interface {
@@ -706,6 +706,28 @@ func (mfs *MountableFS) Rename(oldPath, newPath string) error {
 	return fmt.Errorf("cannot rename: paths not in same mounted filesystem")
 }
 
+// Copy implements filesystem.Copier. Within one mount the mounted filesystem
+// copies, using its own Copier when it has one; across mounts the data is
+// streamed from one to the other. A copy onto its own source never reaches
+// either: filesystem.Copy and CopyStream short-circuit it.
+func (mfs *MountableFS) Copy(src, dst string, offset, size int64) (int64, error) {
+	mfs.mu.RLock()
+	srcMount, srcRelPath, srcFound := mfs.findMount(src)
+	dstMount, dstRelPath, dstFound := mfs.findMount(dst)
+	mfs.mu.RUnlock()
+
+	if !srcFound {
+		return 0, filesystem.NewNotFoundError("copy", src)
+	}
+	if !dstFound {
+		return 0, filesystem.NewNotFoundError("copy", dst)
+	}
+	if srcMount == dstMount {
+		return filesystem.Copy(srcMount.Plugin.GetFileSystem(), srcRelPath, dstRelPath, offset, size)
+	}
+	return filesystem.CopyStream(mfs, src, dst, offset, size)
+}
+
 func (mfs *MountableFS) Chmod(path string, mode uint32) error {
 	mfs.mu.RLock()
 	mount, relPath, found := mfs.findMount(path)
@@ -0,0 +1,237 @@
+package api
+
+import (
+	"context"
+	"encoding/binary"
+	"fmt"
+	"sync"
+	"time"
+
+	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
+	log "github.com/sirupsen/logrus"
+	wazeroapi "github.com/tetratelabs/wazero/api"
+)
+
+// Asynchronous host operations
+//
+// host_fs_submit takes a request in the host_fs_batch layout and starts every
+// operation in the background, so the latency of slow backends (S3, HTTP)
+// overlaps instead of adding up, without threads in the plugin. Each
+// operation gets a ticket; host_fs_wait_any blocks until one of a set of
+// tickets has completed, and host_fs_take hands over a completed result as a
+// one-entry host_fs_batch response.
+
+const (
+	// maxHostAsyncInFlight bounds how many submitted operations run at once
+	maxHostAsyncInFlight = 32
+	// maxHostAsyncPending bounds operations submitted but not yet taken
+	maxHostAsyncPending = 1024
+)
+
+// HostAsyncTable tracks the operations a plugin submitted. Tickets are
+// positive and never reused while the table is alive.
+type HostAsyncTable struct {
+	mu    sync.Mutex
+	next  int64
+	ops   map[int64]*hostAsyncOp
+	slots chan struct{}
+
+	// changed is closed and replaced whenever an operation completes
+	changed chan struct{}
+}
+
+type hostAsyncOp struct {
+	done   bool
+	result wireBatchResult
+}
+
+// NewHostAsyncTable creates an empty ticket table
+func NewHostAsyncTable() *HostAsyncTable {
+	return &HostAsyncTable{
+		ops:     make(map[int64]*hostAsyncOp),
+		slots:   make(chan struct{}, maxHostAsyncInFlight),
+		changed: make(chan struct{}),
+	}
+}
+
+// submit starts ops and returns the ticket of the first; the rest follow
+// consecutively
+func (t *HostAsyncTable) submit(fs filesystem.FileSystem, ops []wireBatchOp) (int64, error) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+
+	if len(t.ops)+len(ops) > maxHostAsyncPending {
+		return 0, fmt.Errorf("more than %d operations pending", maxHostAsyncPending)
+	}
+
+	first := t.next + 1
+	for _, op := range ops {
+		t.next++
+		pending := &hostAsyncOp{}
+		t.ops[t.next] = pending
+		go t.run(fs, op, pending)
+	}
+	return first, nil
+}
+
+func (t *HostAsyncTable) run(fs filesystem.FileSystem, op wireBatchOp, pending *hostAsyncOp) {
+	t.slots <- struct{}{}
+	result := runBatchOp(fs, op)
+	<-t.slots
+
+	t.mu.Lock()
+	pending.result = result
+	pending.done = true
+	close(t.changed)
+	t.changed = make(chan struct{})
+	t.mu.Unlock()
+}
+
+// waitAny returns the first of tickets to have completed, waiting up to
+// timeout (forever if negative). It returns 0 on timeout.
+func (t *HostAsyncTable) waitAny(ctx context.Context, tickets []int64, timeout time.Duration) (int64, error) {
+	var expired <-chan time.Time
+	if timeout >= 0 {
+		timer := time.NewTimer(timeout)
+		defer timer.Stop()
+		expired = timer.C
+	}
+
+	for {
+		t.mu.Lock()
+		for _, ticket := range tickets {
+			pending, ok := t.ops[ticket]
+			if !ok {
+				t.mu.Unlock()
+				return 0, fmt.Errorf("unknown ticket %d: %w", ticket, filesystem.ErrInvalidArgument)
+			}
+			if pending.done {
+				t.mu.Unlock()
+				return ticket, nil
+			}
+		}
+		changed := t.changed
+		t.mu.Unlock()
+
+		select {
+		case <-changed:
+		case <-expired:
+			return 0, nil
+		case <-ctx.Done():
+			return 0, ctx.Err()
+		}
+	}
+}
+
+// take removes a ticket and returns its result, waiting for it to complete
+func (t *HostAsyncTable) take(ctx context.Context, ticket int64) (wireBatchResult, error) {
+	if _, err := t.waitAny(ctx, []int64{ticket}, -1); err != nil {
+		return wireBatchResult{}, err
+	}
+
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	pending, ok := t.ops[ticket]
+	if !ok {
+		return wireBatchResult{}, fmt.Errorf("unknown ticket %d: %w", ticket, filesystem.ErrInvalidArgument)
+	}
+	delete(t.ops, ticket)
+	return pending.result, nil
+}
+
+// Clear forgets every ticket. Operations still running finish on their own.
+func (t *HostAsyncTable) Clear() {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	t.ops = make(map[int64]*hostAsyncOp)
+}
+
+// HostFSSubmit starts the operations of a host_fs_batch request in the
+// background. Returns the ticket of the first operation, or an error count.
+func HostFSSubmit(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, async *HostAsyncTable, abi *HostABI) []uint64 {
+	reqPtr := uint32(params[0])
+	reqLen := uint32(params[1])
+	failed := hostErrorCount(nil, abi)
+
+	if fs == nil {
+		log.Errorf("host_fs_submit: no host filesystem provided")
+		return []uint64{failed}
+	}
+
+	// Decoding copies every path, so the view may be used directly
+	req, ok := mod.Memory().Read(reqPtr, reqLen)
+	if !ok {
+		log.Errorf("host_fs_submit: failed to read request from memory")
+		return []uint64{failed}
+	}
+
+	ops, err := decodeBatchRequest(req)
+	if err != nil || len(ops) == 0 {
+		log.Errorf("host_fs_submit: invalid request: %v", err)
+		return []uint64{hostErrorCount(filesystem.ErrInvalidArgument, abi)}
+	}
+
+	log.Debugf("host_fs_submit: %d operations", len(ops))
+
+	first, err := async.submit(fs, ops)
+	if err != nil {
+		log.Errorf("host_fs_submit: %v", err)
+		return []uint64{hostErrorCount(err, abi)}
+	}
+
+	return []uint64{uint64(first)}
+}
+
+// HostFSWaitAny waits until one of an array of tickets has completed.
+// Returns that ticket, 0 if timeoutMs (negative waits forever) passed first,
+// or an error count.
+func HostFSWaitAny(ctx context.Context, mod wazeroapi.Module, params []uint64, async *HostAsyncTable, abi *HostABI) []uint64 {
+	ticketsPtr := uint32(params[0])
+	count := uint32(params[1])
+	timeoutMs := int64(params[2])
+	failed := hostErrorCount(nil, abi)
+
+	if count == 0 || count > maxHostAsyncPending {
+		log.Errorf("host_fs_wait_any: invalid ticket count %d", count)
+		return []uint64{hostErrorCount(filesystem.ErrInvalidArgument, abi)}
+	}
+
+	buf, ok := mod.Memory().Read(ticketsPtr, count*8)
+	if !ok {
+		log.Errorf("host_fs_wait_any: failed to read tickets from memory")
+		return []uint64{failed}
+	}
+	tickets := make([]int64, count)
+	for i := range tickets {
+		tickets[i] = int64(binary.LittleEndian.Uint64(buf[i*8:]))
+	}
+
+	ticket, err := async.waitAny(ctx, tickets, time.Duration(timeoutMs)*time.Millisecond)
+	if err != nil {
+		log.Errorf("host_fs_wait_any: %v", err)
+		return []uint64{hostErrorCount(err, abi)}
+	}
+
+	return []uint64{uint64(ticket)}
+}
+
+// HostFSTake returns a ticket's result as a one-entry host_fs_batch response,
+// waiting for it if needed, and forgets the ticket. Returns 0 on error, or
+// the error's code from WASMABIErrorCodes on.
+func HostFSTake(ctx context.Context, mod wazeroapi.Module, params []uint64, async *HostAsyncTable, abi *HostABI) []uint64 {
+	ticket := int64(params[0])
+
+	result, err := async.take(ctx, ticket)
+	if err != nil {
+		log.Errorf("host_fs_take: %v", err)
+		return []uint64{hostErrorCode(err, abi)}
+	}
+
+	ptr, err := writeScratchBytesToMemory(mod, encodeBatchResponse([]wireBatchResult{result}))
+	if err != nil {
+		log.Errorf("host_fs_take: failed to write response to memory: %v", err)
+		return []uint64{hostErrorCode(nil, abi)}
+	}
+
+	return []uint64{uint64(ptr)}
+}
@@ -0,0 +1,189 @@
+package api
+
+import (
+	"context"
+	"encoding/binary"
+	"errors"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
+)
+
+// blockingFS answers Stat once release is closed, recording how many calls
+// were running at once
+type blockingFS struct {
+	filesystem.FileSystem
+	release chan struct{}
+	running atomic.Int32
+	peak    atomic.Int32
+}
+
+func (b *blockingFS) Stat(path string) (*filesystem.FileInfo, error) {
+	n := b.running.Add(1)
+	for {
+		peak := b.peak.Load()
+		if n <= peak || b.peak.CompareAndSwap(peak, n) {
+			break
+		}
+	}
+	<-b.release
+	b.running.Add(-1)
+	return &filesystem.FileInfo{Name: path}, nil
+}
+
+func statOps(n int) []wireBatchOp {
+	ops := make([]wireBatchOp, n)
+	for i := range ops {
+		ops[i] = wireBatchOp{op: wireBatchStat, path: "/a"}
+	}
+	return ops
+}
+
+func TestHostAsyncInFlightLimit(t *testing.T) {
+	fs := &blockingFS{release: make(chan struct{})}
+	async := NewHostAsyncTable()
+	const submitted = maxHostAsyncInFlight + 8
+	first, err := async.submit(fs, statOps(submitted))
+	if err != nil {
+		t.Fatalf("submit: %v", err)
+	}
+
+	deadline := time.Now().Add(5 * time.Second)
+	for fs.running.Load() < maxHostAsyncInFlight && time.Now().Before(deadline) {
+		time.Sleep(time.Millisecond)
+	}
+	time.Sleep(10 * time.Millisecond) // Give any extra operation time to start
+	if got := fs.running.Load(); got != maxHostAsyncInFlight {
+		t.Errorf("%d operations running, want %d", got, maxHostAsyncInFlight)
+	}
+
+	close(fs.release)
+	for ticket := first; ticket < first+submitted; ticket++ {
+		result, err := async.take(context.Background(), ticket)
+		if err != nil || result.status != wireBatchOK {
+			t.Fatalf("take(%d) = %+v, %v", ticket, result, err)
+		}
+	}
+	if peak := fs.peak.Load(); peak > maxHostAsyncInFlight {
+		t.Errorf("%d operations ran at once, limit is %d", peak, maxHostAsyncInFlight)
+	}
+}
+
+func TestHostAsyncPendingLimit(t *testing.T) {
+	fs := &blockingFS{release: make(chan struct{})}
+	close(fs.release)
+	async := NewHostAsyncTable()
+
+	first, err := async.submit(fs, statOps(maxHostAsyncPending))
+	if err != nil {
+		t.Fatalf("submitting %d operations: %v", maxHostAsyncPending, err)
+	}
+	if _, err := async.submit(fs, statOps(1)); err == nil {
+		t.Fatal("submit past the pending limit succeeded")
+	}
+
+	// Completed operations still count until they are taken
+	if _, err := async.take(context.Background(), first); err != nil {
+		t.Fatalf("take: %v", err)
+	}
+	if _, err := async.submit(fs, statOps(2)); err == nil {
+		t.Fatal("submit of two with one slot free succeeded")
+	}
+	if _, err := async.submit(fs, statOps(1)); err != nil {
+		t.Fatalf("submit after a take: %v", err)
+	}
+}
+
+func TestHostAsyncTickets(t *testing.T) {
+	fs := &blockingFS{release: make(chan struct{})}
+	close(fs.release)
+	async := NewHostAsyncTable()
+	ctx := context.Background()
+
+	first, err := async.submit(fs, statOps(2))
+	if err != nil {
+		t.Fatalf("submit: %v", err)
+	}
+	if first <= 0 {
+		t.Fatalf("first ticket %d, want positive", first)
+	}
+	if _, err := async.take(ctx, first); err != nil {
+		t.Fatalf("take: %v", err)
+	}
+
+	tests := []struct {
+		name string
+		call func() error
+	}{
+		{"take spent", func() error { _, err := async.take(ctx, first); return err }},
+		{"take unknown", func() error { _, err := async.take(ctx, first+100); return err }},
+		{"take zero", func() error { _, err := async.take(ctx, 0); return err }},
+		{"wait spent", func() error { _, err := async.waitAny(ctx, []int64{first}, -1); return err }},
+		{"wait unknown", func() error { _, err := async.waitAny(ctx, []int64{-1}, -1); return err }},
+	}
+	for _, tt := range tests {
+		if err := tt.call(); !errors.Is(err, filesystem.ErrInvalidArgument) {
+			t.Errorf("%s: got %v, want an invalid argument error", tt.name, err)
+		}
+	}
+
+	// Tickets are not reused after they are spent or cleared
+	if ticket, err := async.waitAny(ctx, []int64{first + 1}, -1); err != nil || ticket != first+1 {
+		t.Errorf("waitAny = %d, %v, want %d", ticket, err, first+1)
+	}
+	async.Clear()
+	next, err := async.submit(fs, statOps(1))
+	if err != nil || next != first+2 {
+		t.Errorf("submit after Clear = %d, %v, want %d", next, err, first+2)
+	}
+}
+
+func TestHostAsyncWaitTimeout(t *testing.T) {
+	fs := &blockingFS{release: make(chan struct{})}
+	async := NewHostAsyncTable()
+	ticket, err := async.submit(fs, statOps(1))
+	if err != nil {
+		t.Fatalf("submit: %v", err)
+	}
+	if got, err := async.waitAny(context.Background(), []int64{ticket}, 0); err != nil || got != 0 {
+		t.Errorf("poll of a running ticket = %d, %v, want 0", got, err)
+	}
+	ctx, cancel := context.WithCancel(context.Background())
+	cancel()
+	if _, err := async.waitAny(ctx, []int64{ticket}, -1); !errors.Is(err, context.Canceled) {
+		t.Errorf("wait with a cancelled context: %v", err)
+	}
+	close(fs.release)
+	if got, err := async.waitAny(context.Background(), []int64{ticket}, -1); err != nil || got != ticket {
+		t.Errorf("waitAny = %d, %v, want %d", got, err, ticket)
+	}
+}
+
+// Ticket errors reach the plugin as InvalidInput from WASMABIErrorCodes on
+func TestHostAsyncErrorCodes(t *testing.T) {
+	ctx := context.Background()
+	abi := testABI(WASMABIErrorCodes)
+	mod := newTestModule()
+	async := NewHostAsyncTable()
+
+	if got := HostFSTake(ctx, mod, []uint64{42}, async, abi)[0]; got != uint64(WASMErrorInvalidInput) {
+		t.Errorf("take of an unknown ticket = %d, want %d", got, WASMErrorInvalidInput)
+	}
+
+	tickets := binary.LittleEndian.AppendUint64(nil, 42)
+	ptr, err := writeToMemory(mod, "malloc", tickets)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if got := int64(HostFSWaitAny(ctx, mod, []uint64{uint64(ptr), 1, 0}, async, abi)[0]); got != -int64(WASMErrorInvalidInput) {
+		t.Errorf("wait on an unknown ticket = %d, want %d", got, -int64(WASMErrorInvalidInput))
+	}
+	if got := int64(HostFSWaitAny(ctx, mod, []uint64{uint64(ptr), 0, 0}, async, abi)[0]); got != -int64(WASMErrorInvalidInput) {
+		t.Errorf("wait on no tickets = %d, want %d", got, -int64(WASMErrorInvalidInput))
+	}
+	if got := int64(HostFSSubmit(ctx, mod, []uint64{uint64(ptr), 8}, errorFS{}, async, abi)[0]); got != -int64(WASMErrorInvalidInput) {
+		t.Errorf("submit of a malformed request = %d, want %d", got, -int64(WASMErrorInvalidInput))
+	}
+}
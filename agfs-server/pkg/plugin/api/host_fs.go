@@ -3,6 +3,10 @@ package api
 import (
 	"context"
 	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
+	"sync"
 
 	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
 	log "github.com/sirupsen/logrus"
@@ -11,16 +15,27 @@ import (
 
 // Host function implementations for filesystem operations
 // These functions are exported to WASM modules and allow them to access the host filesystem
+//
+// Buffers these functions write into WASM memory (data, JSON, error strings) are
+// owned by the plugin from then on. They come from the plugin's per-call scratch
+// arena when it exports plugin_scratch_alloc, and from malloc otherwise; the
+// plugin is expected to release them once it has copied them out. Errors are
+// reported as described in wasm_errors.go.
+
+var (
+	errNoHostFS   = errors.New("no host filesystem provided")
+	errPathMemory = errors.New("failed to read path from memory")
+)
 
-func HostFSRead(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+func HostFSRead(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
 	pathPtr := uint32(params[0])
 	offset := int64(params[1])
 	size := int64(params[2])
 
-	path, ok := readStringFromMemory(mod, pathPtr)
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
 	if !ok {
 		log.Errorf("host_fs_read: failed to read path from memory")
-		return []uint64{0} // Return 0 to indicate error
+		return []uint64{hostErrorBuffer(errPathMemory, abi)}
 	}
 
 	log.Debugf("host_fs_read: path=%s, offset=%d, size=%d", path, offset, size)
@@ -28,20 +43,20 @@ func HostFSRead(ctx context.Context, mod wazeroapi.Module, params []uint64, fs f
 	// Check if filesystem is provided
 	if fs == nil {
 		log.Errorf("host_fs_read: no host filesystem provided")
-		return []uint64{0}
+		return []uint64{hostErrorBuffer(errNoHostFS, abi)}
 	}
 
 	data, err := fs.Read(path, offset, size)
-	if err != nil {
+	if err != nil && err != io.EOF {
 		log.Errorf("host_fs_read: error reading file: %v", err)
-		return []uint64{0}
+		return []uint64{hostErrorBuffer(err, abi)}
 	}
 
 	// Write data to WASM memory
-	dataPtr, err := writeBytesToMemory(mod, data)
+	dataPtr, err := writeScratchBytesToMemory(mod, data)
 	if err != nil {
 		log.Errorf("host_fs_read: failed to write data to memory: %v", err)
-		return []uint64{0}
+		return []uint64{hostErrorBuffer(nil, abi)}
 	}
 
 	// Pack pointer and size into single u64
@@ -50,41 +65,268 @@ func HostFSRead(ctx context.Context, mod wazeroapi.Module, params []uint64, fs f
 	return []uint64{packed}
 }
 
-func HostFSWrite(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+// HostFSReadInto reads from the host filesystem straight into a buffer the plugin
+// supplies, so the data is written into linear memory exactly once.
+// Returns the number of bytes written, or an error count.
+func HostFSReadInto(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
+	pathPtr := uint32(params[0])
+	offset := int64(params[1])
+	bufPtr := uint32(params[2])
+	bufCap := uint32(params[3])
+	failed := hostErrorCount(nil, abi)
+
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
+	if !ok {
+		log.Errorf("host_fs_read_into: failed to read path from memory")
+		return []uint64{failed}
+	}
+
+	log.Debugf("host_fs_read_into: path=%s, offset=%d, cap=%d", path, offset, bufCap)
+
+	if fs == nil {
+		log.Errorf("host_fs_read_into: no host filesystem provided")
+		return []uint64{failed}
+	}
+
+	data, err := fs.Read(path, offset, int64(bufCap))
+	if err != nil && err != io.EOF {
+		log.Errorf("host_fs_read_into: error reading file: %v", err)
+		return []uint64{hostErrorCount(err, abi)}
+	}
+
+	if len(data) > int(bufCap) {
+		data = data[:bufCap]
+	}
+	if !mod.Memory().Write(bufPtr, data) {
+		log.Errorf("host_fs_read_into: buffer out of range")
+		return []uint64{failed}
+	}
+
+	return []uint64{uint64(len(data))}
+}
+
+// Flags accepted by host_fs_open and fs_open
+const (
+	wasmOpenRead  = 1
+	wasmOpenWrite = 2
+)
+
+// HostFileTable tracks host files a plugin opened for streaming I/O.
+// Handles are positive and never reused while the table is alive.
+type HostFileTable struct {
+	mu    sync.Mutex
+	next  int64
+	files map[int64]io.Closer
+}
+
+// NewHostFileTable creates an empty handle table
+func NewHostFileTable() *HostFileTable {
+	return &HostFileTable{files: make(map[int64]io.Closer)}
+}
+
+func (t *HostFileTable) add(f io.Closer) int64 {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	t.next++
+	t.files[t.next] = f
+	return t.next
+}
+
+func (t *HostFileTable) get(handle int64) (io.Closer, bool) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	f, ok := t.files[handle]
+	return f, ok
+}
+
+func (t *HostFileTable) remove(handle int64) (io.Closer, bool) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	f, ok := t.files[handle]
+	delete(t.files, handle)
+	return f, ok
+}
+
+// CloseAll closes every handle the plugin left open
+func (t *HostFileTable) CloseAll() {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	for handle, f := range t.files {
+		if err := f.Close(); err != nil {
+			log.Warnf("failed to close leaked host file handle %d: %v", handle, err)
+		}
+		delete(t.files, handle)
+	}
+}
+
+// HostFSOpen opens a host file for streaming and returns a positive handle, or an error count
+func HostFSOpen(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, files *HostFileTable, abi *HostABI) []uint64 {
+	pathPtr := uint32(params[0])
+	flags := uint32(params[1])
+	failed := hostErrorCount(nil, abi)
+
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
+	if !ok {
+		log.Errorf("host_fs_open: failed to read path from memory")
+		return []uint64{failed}
+	}
+
+	log.Debugf("host_fs_open: path=%s, flags=%d", path, flags)
+
+	if fs == nil {
+		log.Errorf("host_fs_open: no host filesystem provided")
+		return []uint64{failed}
+	}
+
+	var f io.Closer
+	var err error
+	switch flags {
+	case wasmOpenRead:
+		f, err = fs.Open(path)
+	case wasmOpenWrite:
+		f, err = fs.OpenWrite(path)
+	default:
+		err = filesystem.NewInvalidArgumentError("flags", flags, "must be read or write")
+	}
+	if err != nil {
+		log.Errorf("host_fs_open: error opening file: %v", err)
+		return []uint64{hostErrorCount(err, abi)}
+	}
+
+	return []uint64{uint64(files.add(f))}
+}
+
+// HostFSReadChunk reads the next chunk of a streaming handle straight into the
+// plugin's buffer. Returns the bytes read (0 at end of file), or an error count.
+func HostFSReadChunk(ctx context.Context, mod wazeroapi.Module, params []uint64, files *HostFileTable, abi *HostABI) []uint64 {
+	handle := int64(params[0])
+	bufPtr := uint32(params[1])
+	bufCap := uint32(params[2])
+	failed := hostErrorCount(nil, abi)
+
+	f, ok := files.get(handle)
+	if !ok {
+		log.Errorf("host_fs_read_chunk: invalid handle %d", handle)
+		return []uint64{failed}
+	}
+	r, ok := f.(io.Reader)
+	if !ok {
+		log.Errorf("host_fs_read_chunk: handle %d is not open for reading", handle)
+		return []uint64{failed}
+	}
+
+	// Read writes through this view directly into linear memory
+	buf, ok := mod.Memory().Read(bufPtr, bufCap)
+	if !ok {
+		log.Errorf("host_fs_read_chunk: buffer out of range")
+		return []uint64{failed}
+	}
+
+	n, err := io.ReadAtLeast(r, buf, 1)
+	if err == io.EOF {
+		return []uint64{0}
+	}
+	if err != nil && n == 0 {
+		log.Errorf("host_fs_read_chunk: error reading file: %v", err)
+		return []uint64{hostErrorCount(err, abi)}
+	}
+
+	return []uint64{uint64(n)}
+}
+
+// HostFSWriteChunk appends a chunk to a streaming handle. Returns the bytes
+// written, or an error count.
+func HostFSWriteChunk(ctx context.Context, mod wazeroapi.Module, params []uint64, files *HostFileTable, abi *HostABI) []uint64 {
+	handle := int64(params[0])
+	dataPtr := uint32(params[1])
+	dataLen := uint32(params[2])
+	failed := hostErrorCount(nil, abi)
+
+	f, ok := files.get(handle)
+	if !ok {
+		log.Errorf("host_fs_write_chunk: invalid handle %d", handle)
+		return []uint64{failed}
+	}
+	w, ok := f.(io.Writer)
+	if !ok {
+		log.Errorf("host_fs_write_chunk: handle %d is not open for writing", handle)
+		return []uint64{failed}
+	}
+
+	// io.Writer must not retain the slice, so the view can be passed as is
+	data, ok := mod.Memory().Read(dataPtr, dataLen)
+	if !ok {
+		log.Errorf("host_fs_write_chunk: failed to read data from memory")
+		return []uint64{failed}
+	}
+
+	n, err := w.Write(data)
+	if err != nil {
+		log.Errorf("host_fs_write_chunk: error writing file: %v", err)
+		return []uint64{hostErrorCount(err, abi)}
+	}
+
+	return []uint64{uint64(n)}
+}
+
+// HostFSClose closes a streaming handle. Returns 0 or an error string pointer.
+func HostFSClose(ctx context.Context, mod wazeroapi.Module, params []uint64, files *HostFileTable, abi *HostABI) []uint64 {
+	handle := int64(params[0])
+
+	f, ok := files.remove(handle)
+	if !ok {
+		errPtr, _ := writeHostError(mod, fmt.Errorf("invalid handle %d: %w", handle, filesystem.ErrInvalidArgument), abi)
+		return []uint64{uint64(errPtr)}
+	}
+
+	if err := f.Close(); err != nil {
+		log.Errorf("host_fs_close: error closing file: %v", err)
+		errPtr, _ := writeHostError(mod, err, abi)
+		return []uint64{uint64(errPtr)}
+	}
+
+	return []uint64{0}
+}
+
+func HostFSWrite(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
 	pathPtr := uint32(params[0])
 	dataPtr := uint32(params[1])
 	dataLen := uint32(params[2])
 
-	path, ok := readStringFromMemory(mod, pathPtr)
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
 	if !ok {
 		log.Errorf("host_fs_write: failed to read path from memory")
-		return []uint64{0}
+		return []uint64{hostErrorBuffer(errPathMemory, abi)}
 	}
 
-	data, ok := mod.Memory().Read(dataPtr, dataLen)
+	// Copy the payload out of linear memory: the plugin frees its buffer as
+	// soon as this call returns, and the host filesystem may retain the slice
+	view, ok := mod.Memory().Read(dataPtr, dataLen)
 	if !ok {
 		log.Errorf("host_fs_write: failed to read data from memory")
-		return []uint64{0}
+		return []uint64{hostErrorBuffer(nil, abi)}
 	}
+	data := make([]byte, len(view))
+	copy(data, view)
 
 	log.Debugf("host_fs_write: path=%s, dataLen=%d", path, dataLen)
 
 	if fs == nil {
 		log.Errorf("host_fs_write: no host filesystem provided")
-		return []uint64{0}
+		return []uint64{hostErrorBuffer(errNoHostFS, abi)}
 	}
 
 	response, err := fs.Write(path, data)
 	if err != nil {
 		log.Errorf("host_fs_write: error writing file: %v", err)
-		return []uint64{0}
+		return []uint64{hostErrorBuffer(err, abi)}
 	}
 
 	// Write response to WASM memory
-	responsePtr, err := writeBytesToMemory(mod, response)
+	responsePtr, err := writeScratchBytesToMemory(mod, response)
 	if err != nil {
 		log.Errorf("host_fs_write: failed to write response to memory: %v", err)
-		return []uint64{0}
+		return []uint64{hostErrorBuffer(nil, abi)}
 	}
 
 	// Pack pointer and size
@@ -92,10 +334,10 @@ func HostFSWrite(ctx context.Context, mod wazeroapi.Module, params []uint64, fs
 	return []uint64{packed}
 }
 
-func HostFSStat(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+func HostFSStat(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
 	pathPtr := uint32(params[0])
 
-	path, ok := readStringFromMemory(mod, pathPtr)
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
 	if !ok {
 		log.Errorf("host_fs_stat: failed to read path from memory")
 		return []uint64{0}
@@ -105,7 +347,7 @@ func HostFSStat(ctx context.Context, mod wazeroapi.Module, params []uint64, fs f
 
 	if fs == nil {
 		log.Errorf("host_fs_stat: no host filesystem provided")
-		errPtr, _ := writeStringToMemory(mod, "no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
 		return []uint64{uint64(errPtr) << 32}
 	}
 
@@ -113,14 +355,22 @@ func HostFSStat(ctx context.Context, mod wazeroapi.Module, params []uint64, fs f
 	if err != nil {
 		log.Errorf("host_fs_stat: error stating file: %v", err)
 		// Pack error: upper 32 bits = error pointer
-		errStr := err.Error()
-		errPtr, err := writeStringToMemory(mod, errStr)
+		errPtr, err := writeHostError(mod, err, abi)
 		if err != nil {
 			return []uint64{0}
 		}
 		return []uint64{uint64(errPtr) << 32}
 	}
 
+	if abi.BinaryFileInfo() {
+		ptr, err := writeScratchBytesToMemory(mod, encodeFileInfos([]filesystem.FileInfo{*fileInfo}))
+		if err != nil {
+			log.Errorf("host_fs_stat: failed to write result to memory: %v", err)
+			return []uint64{0}
+		}
+		return []uint64{uint64(ptr)}
+	}
+
 	// Serialize fileInfo to JSON
 	jsonData, err := json.Marshal(fileInfo)
 	if err != nil {
@@ -128,7 +378,7 @@ func HostFSStat(ctx context.Context, mod wazeroapi.Module, params []uint64, fs f
 		return []uint64{0}
 	}
 
-	jsonPtr, err := writeStringToMemory(mod, string(jsonData))
+	jsonPtr, err := writeScratchStringToMemory(mod, string(jsonData), abi.Version())
 	if err != nil {
 		log.Errorf("host_fs_stat: failed to write JSON to memory: %v", err)
 		return []uint64{0}
@@ -138,10 +388,10 @@ func HostFSStat(ctx context.Context, mod wazeroapi.Module, params []uint64, fs f
 	return []uint64{uint64(jsonPtr)}
 }
 
-func HostFSReadDir(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+func HostFSReadDir(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
 	pathPtr := uint32(params[0])
 
-	path, ok := readStringFromMemory(mod, pathPtr)
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
 	if !ok {
 		log.Errorf("host_fs_readdir: failed to read path from memory")
 		return []uint64{0}
@@ -151,21 +401,29 @@ func HostFSReadDir(ctx context.Context, mod wazeroapi.Module, params []uint64, f
 
 	if fs == nil {
 		log.Errorf("host_fs_readdir: no host filesystem provided")
-		errPtr, _ := writeStringToMemory(mod, "no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
 		return []uint64{uint64(errPtr) << 32}
 	}
 
 	fileInfos, err := fs.ReadDir(path)
 	if err != nil {
 		log.Errorf("host_fs_readdir: error reading directory: %v", err)
-		errStr := err.Error()
-		errPtr, err := writeStringToMemory(mod, errStr)
+		errPtr, err := writeHostError(mod, err, abi)
 		if err != nil {
 			return []uint64{0}
 		}
 		return []uint64{uint64(errPtr) << 32}
 	}
 
+	if abi.BinaryFileInfo() {
+		ptr, err := writeScratchBytesToMemory(mod, encodeFileInfos(fileInfos))
+		if err != nil {
+			log.Errorf("host_fs_readdir: failed to write result to memory: %v", err)
+			return []uint64{0}
+		}
+		return []uint64{uint64(ptr)}
+	}
+
 	// Serialize fileInfos to JSON
 	jsonData, err := json.Marshal(fileInfos)
 	if err != nil {
@@ -173,7 +431,7 @@ func HostFSReadDir(ctx context.Context, mod wazeroapi.Module, params []uint64, f
 		return []uint64{0}
 	}
 
-	jsonPtr, err := writeStringToMemory(mod, string(jsonData))
+	jsonPtr, err := writeScratchStringToMemory(mod, string(jsonData), abi.Version())
 	if err != nil {
 		log.Errorf("host_fs_readdir: failed to write JSON to memory: %v", err)
 		return []uint64{0}
@@ -182,164 +440,424 @@ func HostFSReadDir(ctx context.Context, mod wazeroapi.Module, params []uint64, f
 	return []uint64{uint64(jsonPtr)}
 }
 
-func HostFSCreate(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+// HostFSBatch runs a packed batch of stat and read operations in a single
+// crossing; see wire.go for the buffer layout. Each operation succeeds or
+// fails on its own; only a malformed request fails the whole batch.
+func HostFSBatch(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
+	reqPtr := uint32(params[0])
+	reqLen := uint32(params[1])
+
+	if fs == nil {
+		log.Errorf("host_fs_batch: no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
+		return []uint64{uint64(errPtr) << 32}
+	}
+
+	// Decoding copies every path, so the view may be used directly
+	req, ok := mod.Memory().Read(reqPtr, reqLen)
+	if !ok {
+		log.Errorf("host_fs_batch: failed to read request from memory")
+		return []uint64{0}
+	}
+
+	ops, err := decodeBatchRequest(req)
+	if err != nil {
+		log.Errorf("host_fs_batch: %v", err)
+		errPtr, _ := writeHostError(mod, err, abi)
+		return []uint64{uint64(errPtr) << 32}
+	}
+
+	log.Debugf("host_fs_batch: %d operations", len(ops))
+
+	results := make([]wireBatchResult, len(ops))
+	for i, op := range ops {
+		results[i] = runBatchOp(fs, op)
+	}
+
+	ptr, err := writeScratchBytesToMemory(mod, encodeBatchResponse(results))
+	if err != nil {
+		log.Errorf("host_fs_batch: failed to write response to memory: %v", err)
+		return []uint64{0}
+	}
+
+	return []uint64{uint64(ptr)}
+}
+
+func runBatchOp(fs filesystem.FileSystem, op wireBatchOp) wireBatchResult {
+	failed := func(err error) wireBatchResult {
+		return wireBatchResult{op: op.op, status: hostErrorKind(err), payload: []byte(err.Error())}
+	}
+
+	switch op.op {
+	case wireBatchStat:
+		info, err := fs.Stat(op.path)
+		if err != nil {
+			return failed(err)
+		}
+		return wireBatchResult{op: op.op, status: wireBatchOK, payload: encodeFileInfos([]filesystem.FileInfo{*info})}
+	case wireBatchRead:
+		data, err := fs.Read(op.path, op.offset, op.size)
+		if err != nil && err != io.EOF {
+			return failed(err)
+		}
+		return wireBatchResult{op: op.op, status: wireBatchOK, payload: data}
+	default:
+		return failed(fmt.Errorf("unknown batch operation %d: %w", op.op, filesystem.ErrInvalidArgument))
+	}
+}
+
+// maxHostDirListings bounds how many unfinished paged listings a plugin may
+// keep; the oldest is dropped when another one starts
+const maxHostDirListings = 64
+
+// HostDirTable keeps host directory listings a plugin is paging through with
+// host_fs_readdir_page, so each page is a slice of one ReadDir call instead of
+// a fresh listing. A listing is dropped once its last page has been served.
+type HostDirTable struct {
+	mu       sync.Mutex
+	next     uint64
+	listings map[uint64]*hostDirListing
+}
+
+type hostDirListing struct {
+	path    string
+	entries []filesystem.FileInfo
+}
+
+// NewHostDirTable creates an empty listing table
+func NewHostDirTable() *HostDirTable {
+	return &HostDirTable{listings: make(map[uint64]*hostDirListing)}
+}
+
+func (t *HostDirTable) add(path string, entries []filesystem.FileInfo) uint64 {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	if len(t.listings) >= maxHostDirListings {
+		oldest := t.next
+		for id := range t.listings {
+			if id < oldest {
+				oldest = id
+			}
+		}
+		delete(t.listings, oldest)
+	}
+	t.next++
+	t.listings[t.next] = &hostDirListing{path: path, entries: entries}
+	return t.next
+}
+
+func (t *HostDirTable) get(id uint64) (*hostDirListing, bool) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	l, ok := t.listings[id]
+	return l, ok
+}
+
+func (t *HostDirTable) remove(id uint64) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	delete(t.listings, id)
+}
+
+// Clear drops every unfinished listing
+func (t *HostDirTable) Clear() {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	t.listings = make(map[uint64]*hostDirListing)
+}
+
+// page returns the page of entries starting at cursor
+// Cursors have the form "<listing id>:<offset>"
+func (t *HostDirTable) page(fs filesystem.FileSystem, path, cursor string, limit int) ([]filesystem.FileInfo, string, error) {
+	if cursor == "" {
+		entries, err := fs.ReadDir(path)
+		if err != nil {
+			return nil, "", err
+		}
+		if len(entries) <= limit {
+			return entries, "", nil
+		}
+		id := t.add(path, entries)
+		return entries[:limit], fmt.Sprintf("%d:%d", id, limit), nil
+	}
+
+	var id uint64
+	var offset int
+	if _, err := fmt.Sscanf(cursor, "%d:%d", &id, &offset); err != nil {
+		return nil, "", fmt.Errorf("invalid readdir cursor %q", cursor)
+	}
+	l, ok := t.get(id)
+	if !ok || l.path != path || offset < 0 || offset > len(l.entries) {
+		return nil, "", fmt.Errorf("readdir cursor %q expired", cursor)
+	}
+
+	end := offset + limit
+	if end >= len(l.entries) {
+		t.remove(id)
+		return l.entries[offset:], "", nil
+	}
+	return l.entries[offset:end], fmt.Sprintf("%d:%d", id, end), nil
+}
+
+// HostFSReadDirPage lists one page of a host directory for the plugin.
+// File systems implementing filesystem.DirPager page natively; for the rest
+// the listing is read once and paged out of dirs.
+func HostFSReadDirPage(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, dirs *HostDirTable, abi *HostABI) []uint64 {
 	pathPtr := uint32(params[0])
+	cursorPtr := uint32(params[1])
+	limit := int(uint32(params[2]))
+	if limit <= 0 {
+		limit = 1
+	}
 
-	path, ok := readStringFromMemory(mod, pathPtr)
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
+	if !ok {
+		log.Errorf("host_fs_readdir_page: failed to read path from memory")
+		return []uint64{0}
+	}
+	cursor, ok := readStringFromMemory(mod, cursorPtr, abi.Version())
 	if !ok {
-		return []uint64{1} // Error
+		log.Errorf("host_fs_readdir_page: failed to read cursor from memory")
+		return []uint64{0}
+	}
+
+	log.Debugf("host_fs_readdir_page: path=%s, cursor=%q, limit=%d", path, cursor, limit)
+
+	if fs == nil {
+		log.Errorf("host_fs_readdir_page: no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
+		return []uint64{uint64(errPtr) << 32}
+	}
+
+	var entries []filesystem.FileInfo
+	var next string
+	var err error
+	if pager, ok := fs.(filesystem.DirPager); ok {
+		entries, next, err = pager.ReadDirPage(path, cursor, limit)
+	} else {
+		entries, next, err = dirs.page(fs, path, cursor, limit)
+	}
+	if err != nil {
+		log.Errorf("host_fs_readdir_page: error reading directory: %v", err)
+		errPtr, err := writeHostError(mod, err, abi)
+		if err != nil {
+			return []uint64{0}
+		}
+		return []uint64{uint64(errPtr) << 32}
+	}
+
+	ptr, err := writeScratchBytesToMemory(mod, encodeDirPage(entries, next))
+	if err != nil {
+		log.Errorf("host_fs_readdir_page: failed to write result to memory: %v", err)
+		return []uint64{0}
+	}
+
+	return []uint64{uint64(ptr)}
+}
+
+func HostFSCreate(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
+	pathPtr := uint32(params[0])
+
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
+	if !ok {
+		errPtr, _ := writeHostError(mod, errPathMemory, abi)
+		return []uint64{uint64(errPtr)}
 	}
 
 	log.Debugf("host_fs_create: path=%s", path)
 
 	if fs == nil {
 		log.Errorf("host_fs_create: no host filesystem provided")
-		errPtr, _ := writeStringToMemory(mod, "no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	err := fs.Create(path)
 	if err != nil {
 		log.Errorf("host_fs_create: error creating file: %v", err)
-		errPtr, _ := writeStringToMemory(mod, err.Error())
+		errPtr, _ := writeHostError(mod, err, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	return []uint64{0} // Success
 }
 
-func HostFSMkdir(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+func HostFSMkdir(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
 	pathPtr := uint32(params[0])
 	perm := uint32(params[1])
 
-	path, ok := readStringFromMemory(mod, pathPtr)
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
 	if !ok {
-		return []uint64{1}
+		errPtr, _ := writeHostError(mod, errPathMemory, abi)
+		return []uint64{uint64(errPtr)}
 	}
 
 	log.Debugf("host_fs_mkdir: path=%s, perm=%o", path, perm)
 
 	if fs == nil {
 		log.Errorf("host_fs_mkdir: no host filesystem provided")
-		errPtr, _ := writeStringToMemory(mod, "no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	err := fs.Mkdir(path, perm)
 	if err != nil {
 		log.Errorf("host_fs_mkdir: error creating directory: %v", err)
-		errPtr, _ := writeStringToMemory(mod, err.Error())
+		errPtr, _ := writeHostError(mod, err, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	return []uint64{0}
 }
 
-func HostFSRemove(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+func HostFSRemove(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
 	pathPtr := uint32(params[0])
 
-	path, ok := readStringFromMemory(mod, pathPtr)
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
 	if !ok {
-		return []uint64{1}
+		errPtr, _ := writeHostError(mod, errPathMemory, abi)
+		return []uint64{uint64(errPtr)}
 	}
 
 	log.Debugf("host_fs_remove: path=%s", path)
 
 	if fs == nil {
 		log.Errorf("host_fs_remove: no host filesystem provided")
-		errPtr, _ := writeStringToMemory(mod, "no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	err := fs.Remove(path)
 	if err != nil {
 		log.Errorf("host_fs_remove: error removing: %v", err)
-		errPtr, _ := writeStringToMemory(mod, err.Error())
+		errPtr, _ := writeHostError(mod, err, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	return []uint64{0}
 }
 
-func HostFSRemoveAll(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+func HostFSRemoveAll(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
 	pathPtr := uint32(params[0])
 
-	path, ok := readStringFromMemory(mod, pathPtr)
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
 	if !ok {
-		return []uint64{1}
+		errPtr, _ := writeHostError(mod, errPathMemory, abi)
+		return []uint64{uint64(errPtr)}
 	}
 
 	log.Debugf("host_fs_remove_all: path=%s", path)
 
 	if fs == nil {
 		log.Errorf("host_fs_remove_all: no host filesystem provided")
-		errPtr, _ := writeStringToMemory(mod, "no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	err := fs.RemoveAll(path)
 	if err != nil {
 		log.Errorf("host_fs_remove_all: error removing: %v", err)
-		errPtr, _ := writeStringToMemory(mod, err.Error())
+		errPtr, _ := writeHostError(mod, err, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	return []uint64{0}
 }
 
-func HostFSRename(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+func HostFSRename(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
 	oldPathPtr := uint32(params[0])
 	newPathPtr := uint32(params[1])
 
-	oldPath, ok := readStringFromMemory(mod, oldPathPtr)
+	oldPath, ok := readStringFromMemory(mod, oldPathPtr, abi.Version())
 	if !ok {
-		return []uint64{1}
+		errPtr, _ := writeHostError(mod, errPathMemory, abi)
+		return []uint64{uint64(errPtr)}
 	}
 
-	newPath, ok := readStringFromMemory(mod, newPathPtr)
+	newPath, ok := readStringFromMemory(mod, newPathPtr, abi.Version())
 	if !ok {
-		return []uint64{1}
+		errPtr, _ := writeHostError(mod, errPathMemory, abi)
+		return []uint64{uint64(errPtr)}
 	}
 
 	log.Debugf("host_fs_rename: oldPath=%s, newPath=%s", oldPath, newPath)
 
 	if fs == nil {
 		log.Errorf("host_fs_rename: no host filesystem provided")
-		errPtr, _ := writeStringToMemory(mod, "no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	err := fs.Rename(oldPath, newPath)
 	if err != nil {
 		log.Errorf("host_fs_rename: error renaming: %v", err)
-		errPtr, _ := writeStringToMemory(mod, err.Error())
+		errPtr, _ := writeHostError(mod, err, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	return []uint64{0}
 }
 
-func HostFSChmod(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem) []uint64 {
+// HostFSCopy copies a byte range between two host paths, possibly on
+// different mounts, without the data entering the plugin's memory. Returns
+// the bytes copied, or an error count.
+func HostFSCopy(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
+	srcPtr := uint32(params[0])
+	dstPtr := uint32(params[1])
+	offset := int64(params[2])
+	size := int64(params[3])
+	failed := hostErrorCount(nil, abi)
+
+	src, ok := readStringFromMemory(mod, srcPtr, abi.Version())
+	if !ok {
+		log.Errorf("host_fs_copy: failed to read path from memory")
+		return []uint64{failed}
+	}
+
+	dst, ok := readStringFromMemory(mod, dstPtr, abi.Version())
+	if !ok {
+		log.Errorf("host_fs_copy: failed to read path from memory")
+		return []uint64{failed}
+	}
+
+	log.Debugf("host_fs_copy: src=%s, dst=%s, offset=%d, size=%d", src, dst, offset, size)
+
+	if fs == nil {
+		log.Errorf("host_fs_copy: no host filesystem provided")
+		return []uint64{failed}
+	}
+
+	n, err := filesystem.Copy(fs, src, dst, offset, size)
+	if err != nil {
+		log.Errorf("host_fs_copy: error copying: %v", err)
+		return []uint64{hostErrorCount(err, abi)}
+	}
+
+	return []uint64{uint64(n)}
+}
+
+func HostFSChmod(ctx context.Context, mod wazeroapi.Module, params []uint64, fs filesystem.FileSystem, abi *HostABI) []uint64 {
 	pathPtr := uint32(params[0])
 	mode := uint32(params[1])
 
-	path, ok := readStringFromMemory(mod, pathPtr)
+	path, ok := readStringFromMemory(mod, pathPtr, abi.Version())
 	if !ok {
-		return []uint64{1}
+		errPtr, _ := writeHostError(mod, errPathMemory, abi)
+		return []uint64{uint64(errPtr)}
 	}
 
 	log.Debugf("host_fs_chmod: path=%s, mode=%o", path, mode)
 
 	if fs == nil {
 		log.Errorf("host_fs_chmod: no host filesystem provided")
-		errPtr, _ := writeStringToMemory(mod, "no host filesystem provided")
+		errPtr, _ := writeHostError(mod, errNoHostFS, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
 	err := fs.Chmod(path, mode)
 	if err != nil {
 		log.Errorf("host_fs_chmod: error changing mode: %v", err)
-		errPtr, _ := writeStringToMemory(mod, err.Error())
+		errPtr, _ := writeHostError(mod, err, abi)
 		return []uint64{uint64(errPtr)}
 	}
 
@@ -0,0 +1,576 @@
+package api
+
+import (
+	"bytes"
+	"context"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"io/fs"
+	"reflect"
+	"testing"
+
+	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
+	wazeroapi "github.com/tetratelabs/wazero/api"
+)
+
+// testMemory is linear memory backed by a byte slice
+type testMemory struct {
+	wazeroapi.Memory
+	buf []byte
+}
+
+func (m *testMemory) Size() uint32 { return uint32(len(m.buf)) }
+
+func (m *testMemory) Read(offset, count uint32) ([]byte, bool) {
+	if uint64(offset)+uint64(count) > uint64(len(m.buf)) {
+		return nil, false
+	}
+	return m.buf[offset : offset+count], true
+}
+
+func (m *testMemory) ReadUint32Le(offset uint32) (uint32, bool) {
+	b, ok := m.Read(offset, 4)
+	if !ok {
+		return 0, false
+	}
+	return binary.LittleEndian.Uint32(b), true
+}
+
+func (m *testMemory) Write(offset uint32, v []byte) bool {
+	if uint64(offset)+uint64(len(v)) > uint64(len(m.buf)) {
+		return false
+	}
+	copy(m.buf[offset:], v)
+	return true
+}
+
+// testAlloc is a bump allocator standing in for malloc and
+// plugin_scratch_alloc
+type testAlloc struct {
+	wazeroapi.Function
+	mem  *testMemory
+	next uint32
+}
+
+func (a *testAlloc) Call(ctx context.Context, params ...uint64) ([]uint64, error) {
+	size := uint32(params[0])
+	if uint64(a.next)+uint64(size) > uint64(len(a.mem.buf)) {
+		return []uint64{0}, nil
+	}
+	ptr := a.next
+	a.next += (size + 7) &^ 7
+	return []uint64{uint64(ptr)}, nil
+}
+
+// testFunc is an export implemented in Go
+type testFunc struct {
+	wazeroapi.Function
+	fn func(params []uint64) ([]uint64, error)
+}
+
+func (f *testFunc) Call(ctx context.Context, params ...uint64) ([]uint64, error) {
+	return f.fn(params)
+}
+
+// testModule is a plugin instance with memory, an allocator and whatever
+// exports a test adds
+type testModule struct {
+	wazeroapi.Module
+	mem     *testMemory
+	alloc   *testAlloc
+	exports map[string]wazeroapi.Function
+}
+
+func newTestModule() *testModule {
+	mem := &testMemory{buf: make([]byte, 1<<16)}
+	return &testModule{mem: mem, alloc: &testAlloc{mem: mem, next: 8}, exports: map[string]wazeroapi.Function{}}
+}
+
+func (m *testModule) Memory() wazeroapi.Memory { return m.mem }
+
+func (m *testModule) ExportedFunction(name string) wazeroapi.Function {
+	if name == "malloc" || name == "plugin_scratch_alloc" {
+		return m.alloc
+	}
+	if f, ok := m.exports[name]; ok {
+		return f
+	}
+	return nil
+}
+
+// export adds an export returning results
+func (m *testModule) export(name string, results ...uint64) {
+	m.exports[name] = &testFunc{fn: func([]uint64) ([]uint64, error) { return results, nil }}
+}
+
+// putString writes s the way the plugin passes strings to the host and
+// returns its pointer
+func (m *testModule) putString(t *testing.T, s string) uint32 {
+	t.Helper()
+	ptr, err := writeToMemory(m, "malloc", lengthPrefixed(s))
+	if err != nil {
+		t.Fatalf("writing %q: %v", s, err)
+	}
+	return ptr + 4
+}
+
+// errorFS fails every call with err
+type errorFS struct {
+	filesystem.FileSystem
+	err error
+}
+
+func (e errorFS) Stat(string) (*filesystem.FileInfo, error)     { return nil, e.err }
+func (e errorFS) Read(string, int64, int64) ([]byte, error)     { return nil, e.err }
+func (e errorFS) ReadDir(string) ([]filesystem.FileInfo, error) { return nil, e.err }
+func (e errorFS) Create(string) error                           { return e.err }
+func (e errorFS) Open(string) (io.ReadCloser, error)            { return nil, e.err }
+func (e errorFS) OpenWrite(string) (io.WriteCloser, error)      { return nil, e.err }
+
+func testABI(version uint32) *HostABI {
+	abi := &HostABI{}
+	abi.Set(version)
+	return abi
+}
+
+func TestHostErrorKind(t *testing.T) {
+	tests := []struct {
+		err  error
+		want uint32
+	}{
+		{nil, WASMErrorOther},
+		{filesystem.NewNotFoundError("stat", "/a"), WASMErrorNotFound},
+		{fmt.Errorf("wrapped: %w", filesystem.ErrNotFound), WASMErrorNotFound},
+		{fs.ErrNotExist, WASMErrorNotFound},
+		{filesystem.NewPermissionDeniedError("write", "/a", "read-only"), WASMErrorPermissionDenied},
+		{fs.ErrPermission, WASMErrorPermissionDenied},
+		{filesystem.NewAlreadyExistsError("file", "/a"), WASMErrorAlreadyExists},
+		{fs.ErrExist, WASMErrorAlreadyExists},
+		{filesystem.NewNotDirectoryError("/a"), WASMErrorNotDirectory},
+		{filesystem.NewInvalidArgumentError("size", -2, "negative"), WASMErrorInvalidInput},
+		{&WASMError{Kind: WASMErrorReadOnly, Op: "write"}, WASMErrorReadOnly},
+		{errors.New("disk on fire"), WASMErrorOther},
+	}
+	for _, tt := range tests {
+		if got := hostErrorKind(tt.err); got != tt.want {
+			t.Errorf("hostErrorKind(%v) = %d, want %d", tt.err, got, tt.want)
+		}
+	}
+}
+
+// wantHostError checks the error message at ptr and, from WASMABIErrorCodes
+// on, the code ahead of it
+func wantHostError(t *testing.T, mod *testModule, ptr uint32, version uint32, err error) {
+	t.Helper()
+	if ptr == 0 {
+		t.Fatal("no error message")
+	}
+	msg, ok := readStringFromMemory(mod, ptr, version)
+	if !ok || msg != err.Error() {
+		t.Errorf("message = %q, want %q", msg, err.Error())
+	}
+	if version < WASMABIErrorCodes {
+		return
+	}
+	if kind, _ := mod.mem.ReadUint32Le(ptr - 8); kind != hostErrorKind(err) {
+		t.Errorf("kind = %d, want %d", kind, hostErrorKind(err))
+	}
+}
+
+// A missing host path must reach the plugin as NotFound, whichever way the
+// host function reports errors
+func TestHostFSErrorKinds(t *testing.T) {
+	notFound := filesystem.NewNotFoundError("stat", "/host/missing")
+	for _, version := range []uint32{WASMABIStringLength, WASMABIErrorCodes} {
+		abi := testABI(version)
+		codes := version >= WASMABIErrorCodes
+		t.Run(fmt.Sprintf("abi %d", version), func(t *testing.T) {
+			hostFS := errorFS{err: notFound}
+
+			t.Run("stat", func(t *testing.T) {
+				mod := newTestModule()
+				res := HostFSStat(context.Background(), mod, []uint64{uint64(mod.putString(t, "/host/missing"))}, hostFS, abi)
+				if uint32(res[0]) != 0 {
+					t.Fatalf("result pointer %#x on error", uint32(res[0]))
+				}
+				wantHostError(t, mod, uint32(res[0]>>32), version, notFound)
+			})
+
+			t.Run("readdir", func(t *testing.T) {
+				mod := newTestModule()
+				res := HostFSReadDir(context.Background(), mod, []uint64{uint64(mod.putString(t, "/host/missing"))}, hostFS, abi)
+				wantHostError(t, mod, uint32(res[0]>>32), version, notFound)
+			})
+
+			t.Run("create", func(t *testing.T) {
+				mod := newTestModule()
+				res := HostFSCreate(context.Background(), mod, []uint64{uint64(mod.putString(t, "/host/missing"))}, hostFS, abi)
+				wantHostError(t, mod, uint32(res[0]), version, notFound)
+			})
+
+			t.Run("read", func(t *testing.T) {
+				mod := newTestModule()
+				res := HostFSRead(context.Background(), mod, []uint64{uint64(mod.putString(t, "/host/missing")), 0, ^uint64(0)}, hostFS, abi)
+				want := uint64(0)
+				if codes {
+					want = uint64(WASMErrorNotFound) << 32
+				}
+				if res[0] != want {
+					t.Errorf("result = %#x, want %#x", res[0], want)
+				}
+			})
+
+			t.Run("read_into", func(t *testing.T) {
+				mod := newTestModule()
+				res := HostFSReadInto(context.Background(), mod, []uint64{uint64(mod.putString(t, "/host/missing")), 0, 1024, 64}, hostFS, abi)
+				want := int64(-1)
+				if codes {
+					want = -int64(WASMErrorNotFound)
+				}
+				if int64(res[0]) != want {
+					t.Errorf("result = %d, want %d", int64(res[0]), want)
+				}
+			})
+
+			t.Run("open", func(t *testing.T) {
+				mod := newTestModule()
+				files := NewHostFileTable()
+				res := HostFSOpen(context.Background(), mod, []uint64{uint64(mod.putString(t, "/host/missing")), wasmOpenRead}, hostFS, files, abi)
+				want := int64(-1)
+				if codes {
+					want = -int64(WASMErrorNotFound)
+				}
+				if int64(res[0]) != want {
+					t.Errorf("result = %d, want %d", int64(res[0]), want)
+				}
+			})
+
+			t.Run("batch", func(t *testing.T) {
+				mod := newTestModule()
+				req := encodeTestBatchRequest([]wireBatchOp{{op: wireBatchStat, path: "/host/missing"}})
+				reqPtr, err := writeToMemory(mod, "malloc", req)
+				if err != nil {
+					t.Fatal(err)
+				}
+				res := HostFSBatch(context.Background(), mod, []uint64{uint64(reqPtr), uint64(len(req))}, hostFS, abi)
+				respPtr := uint32(res[0])
+				if respPtr == 0 || res[0]>>32 != 0 {
+					t.Fatalf("batch failed: %#x", res[0])
+				}
+				size, _ := mod.mem.ReadUint32Le(respPtr)
+				resp, _ := mod.mem.Read(respPtr, size)
+				results := decodeTestBatchResponse(t, resp)
+				if len(results) != 1 || results[0].status != WASMErrorNotFound {
+					t.Errorf("results = %+v, want one with status NotFound", results)
+				}
+			})
+		})
+	}
+}
+
+// memFS is a flat in-memory filesystem: files, and directories with fixed
+// listings
+type memFS struct {
+	filesystem.FileSystem
+	files  map[string][]byte
+	dirs   map[string][]filesystem.FileInfo
+	writes int // OpenWrite calls
+}
+
+func newMemFS() *memFS {
+	return &memFS{
+		files: map[string][]byte{"/a": []byte("hello")},
+		dirs:  map[string][]filesystem.FileInfo{"/dir": nil},
+	}
+}
+
+func (m *memFS) Stat(path string) (*filesystem.FileInfo, error) {
+	path = filesystem.NormalizePath(path)
+	if data, ok := m.files[path]; ok {
+		return &filesystem.FileInfo{Name: path[1:], Size: int64(len(data)), Mode: 0644}, nil
+	}
+	if _, ok := m.dirs[path]; ok {
+		return &filesystem.FileInfo{Name: path[1:], Mode: 0755, IsDir: true}, nil
+	}
+	return nil, filesystem.NewNotFoundError("stat", path)
+}
+
+func (m *memFS) Read(path string, offset, size int64) ([]byte, error) {
+	data, ok := m.files[filesystem.NormalizePath(path)]
+	if !ok {
+		return nil, filesystem.NewNotFoundError("read", path)
+	}
+	if offset > int64(len(data)) {
+		offset = int64(len(data))
+	}
+	data = data[offset:]
+	if size >= 0 && size < int64(len(data)) {
+		data = data[:size]
+	}
+	return data, nil
+}
+
+func (m *memFS) ReadDir(path string) ([]filesystem.FileInfo, error) {
+	entries, ok := m.dirs[filesystem.NormalizePath(path)]
+	if !ok {
+		return nil, filesystem.NewNotFoundError("readdir", path)
+	}
+	return entries, nil
+}
+
+func (m *memFS) Open(path string) (io.ReadCloser, error) {
+	data, ok := m.files[filesystem.NormalizePath(path)]
+	if !ok {
+		return nil, filesystem.NewNotFoundError("open", path)
+	}
+	return io.NopCloser(bytes.NewReader(data)), nil
+}
+
+// memWriter replaces its file when closed
+type memWriter struct {
+	bytes.Buffer
+	fs   *memFS
+	path string
+}
+
+func (w *memWriter) Close() error {
+	w.fs.files[w.path] = w.Bytes()
+	return nil
+}
+
+func (m *memFS) OpenWrite(path string) (io.WriteCloser, error) {
+	m.writes++
+	path = filesystem.NormalizePath(path)
+	m.files[path] = nil // Truncates, like a real file opened for writing
+	return &memWriter{fs: m, path: path}, nil
+}
+
+func TestHostFSCopy(t *testing.T) {
+	tests := []struct {
+		name         string
+		src, dst     string
+		offset, size int64
+		want         int64 // Bytes copied, or the negated error code
+		writes       int
+	}{
+		{"onto itself", "/a", "/a", 0, -1, 5, 0},
+		{"onto itself, other spelling", "/a", "/./a", 0, -1, 5, 0},
+		{"onto itself, size past end", "/a", "a", 0, 100, 5, 0},
+		{"onto itself at offset", "/a", "/a", 1, -1, -int64(WASMErrorInvalidInput), 0},
+		{"onto itself, part", "/a", "/a", 0, 2, -int64(WASMErrorInvalidInput), 0},
+		{"directory onto itself", "/dir", "/dir", 0, -1, -int64(WASMErrorInvalidInput), 0},
+		{"missing onto itself", "/missing", "/missing", 0, -1, -int64(WASMErrorNotFound), 0},
+		{"to another file", "/a", "/b", 0, -1, 5, 1},
+		{"range to another file", "/a", "/b", 1, 3, 3, 1},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			fs := newMemFS()
+			mod := newTestModule()
+			params := []uint64{uint64(mod.putString(t, tt.src)), uint64(mod.putString(t, tt.dst)), uint64(tt.offset), uint64(tt.size)}
+			if got := int64(HostFSCopy(context.Background(), mod, params, fs, testABI(WASMABIErrorCodes))[0]); got != tt.want {
+				t.Errorf("copied %d, want %d", got, tt.want)
+			}
+			if fs.writes != tt.writes {
+				t.Errorf("%d OpenWrite calls, want %d", fs.writes, tt.writes)
+			}
+			if string(fs.files["/a"]) != "hello" {
+				t.Errorf("source is now %q", fs.files["/a"])
+			}
+		})
+	}
+}
+
+func testEntries(n int) []filesystem.FileInfo {
+	entries := make([]filesystem.FileInfo, n)
+	for i := range entries {
+		entries[i] = filesystem.FileInfo{Name: fmt.Sprintf("f%02d", i), Size: int64(i)}
+	}
+	return entries
+}
+
+func TestHostDirTablePages(t *testing.T) {
+	for _, n := range []int{0, 1, 10} {
+		for _, limit := range []int{1, 3, 10, 20} {
+			t.Run(fmt.Sprintf("%d entries by %d", n, limit), func(t *testing.T) {
+				fs := newMemFS()
+				fs.dirs["/dir"] = testEntries(n)
+				dirs := NewHostDirTable()
+
+				var got []filesystem.FileInfo
+				cursor := ""
+				for pages := 0; ; pages++ {
+					if pages > n+1 {
+						t.Fatal("listing never ends")
+					}
+					entries, next, err := dirs.page(fs, "/dir", cursor, limit)
+					if err != nil {
+						t.Fatalf("page at %q: %v", cursor, err)
+					}
+					if len(entries) > limit {
+						t.Fatalf("page of %d entries, limit %d", len(entries), limit)
+					}
+					got = append(got, entries...)
+					if next == "" {
+						break
+					}
+					cursor = next
+				}
+				if !reflect.DeepEqual(normalizeInfos(got), normalizeInfos(fs.dirs["/dir"])) {
+					t.Errorf("listed %+v", got)
+				}
+				if len(dirs.listings) != 0 {
+					t.Errorf("%d listings kept after the last page", len(dirs.listings))
+				}
+				// A finished listing's cursors are spent
+				if cursor != "" {
+					if _, _, err := dirs.page(fs, "/dir", cursor, limit); err == nil {
+						t.Errorf("cursor %q still works after the last page", cursor)
+					}
+				}
+			})
+		}
+	}
+}
+
+func TestHostDirTableCursors(t *testing.T) {
+	fs := newMemFS()
+	fs.dirs["/dir"] = testEntries(10)
+	fs.dirs["/other"] = testEntries(10)
+	dirs := NewHostDirTable()
+	_, cursor, err := dirs.page(fs, "/dir", "", 3)
+	if err != nil || cursor == "" {
+		t.Fatalf("first page: %q, %v", cursor, err)
+	}
+
+	var id uint64
+	var offset int
+	fmt.Sscanf(cursor, "%d:%d", &id, &offset)
+	tests := []struct {
+		name   string
+		path   string
+		cursor string
+	}{
+		{"garbage", "/dir", "garbage"},
+		{"other path", "/other", cursor},
+		{"unknown listing", "/dir", fmt.Sprintf("%d:%d", id+1, offset)},
+		{"negative offset", "/dir", fmt.Sprintf("%d:-1", id)},
+		{"offset past end", "/dir", fmt.Sprintf("%d:11", id)},
+	}
+	for _, tt := range tests {
+		if _, _, err := dirs.page(fs, tt.path, tt.cursor, 3); err == nil {
+			t.Errorf("%s: cursor %q accepted", tt.name, tt.cursor)
+		}
+	}
+	if _, _, err := dirs.page(fs, "/dir", cursor, 3); err != nil {
+		t.Errorf("valid cursor rejected after bad ones: %v", err)
+	}
+
+	// Starting more listings than the table keeps drops the oldest
+	for i := 0; i < maxHostDirListings; i++ {
+		if _, _, err := dirs.page(fs, "/other", "", 3); err != nil {
+			t.Fatal(err)
+		}
+	}
+	if len(dirs.listings) != maxHostDirListings {
+		t.Errorf("%d listings kept, want %d", len(dirs.listings), maxHostDirListings)
+	}
+	if _, _, err := dirs.page(fs, "/dir", cursor, 3); err == nil {
+		t.Error("cursor of the oldest listing still works")
+	}
+}
+
+func TestHostFSReadDirPage(t *testing.T) {
+	fs := newMemFS()
+	fs.dirs["/dir"] = testEntries(5)
+	dirs := NewHostDirTable()
+	abi := testABI(WASMABIErrorCodes)
+
+	var got []filesystem.FileInfo
+	cursor := ""
+	for {
+		mod := newTestModule()
+		params := []uint64{uint64(mod.putString(t, "/dir")), uint64(mod.putString(t, cursor)), 2}
+		res := HostFSReadDirPage(context.Background(), mod, params, fs, dirs, abi)
+		if res[0]>>32 != 0 || uint32(res[0]) == 0 {
+			t.Fatalf("readdir_page at %q = %#x", cursor, res[0])
+		}
+		// The entries' size prefix, then the cursor behind them
+		ptr := uint32(res[0])
+		total, _ := mod.mem.ReadUint32Le(ptr)
+		cursorLen, _ := mod.mem.ReadUint32Le(ptr + total)
+		buf, _ := mod.mem.Read(ptr, total+4+cursorLen)
+		entries, next, err := decodeDirPage(buf)
+		if err != nil {
+			t.Fatalf("decodeDirPage: %v", err)
+		}
+		got = append(got, entries...)
+		if next == "" {
+			break
+		}
+		cursor = next
+	}
+	if !reflect.DeepEqual(got, fs.dirs["/dir"]) {
+		t.Errorf("listed %+v", got)
+	}
+}
+
+func TestHostFSBatch(t *testing.T) {
+	fs := newMemFS()
+	abi := testABI(WASMABIErrorCodes)
+	ops := []wireBatchOp{
+		{op: wireBatchStat, path: "/a"},
+		{op: wireBatchStat, path: "/missing"},
+		{op: wireBatchRead, path: "/a", offset: 0, size: -1},
+		{op: wireBatchRead, path: "/a", offset: 1, size: 3},
+		{op: wireBatchRead, path: "/missing", size: -1},
+		{op: 99, path: "/a"},
+	}
+	want := []struct {
+		status  uint32
+		payload []byte // nil: not checked
+	}{
+		{wireBatchOK, encodeFileInfos([]filesystem.FileInfo{{Name: "a", Size: 5, Mode: 0644}})},
+		{WASMErrorNotFound, nil},
+		{wireBatchOK, []byte("hello")},
+		{wireBatchOK, []byte("ell")},
+		{WASMErrorNotFound, nil},
+		{WASMErrorInvalidInput, nil},
+	}
+
+	mod := newTestModule()
+	req := encodeTestBatchRequest(ops)
+	reqPtr, err := writeToMemory(mod, "malloc", req)
+	if err != nil {
+		t.Fatal(err)
+	}
+	res := HostFSBatch(context.Background(), mod, []uint64{uint64(reqPtr), uint64(len(req))}, fs, abi)
+	if res[0]>>32 != 0 || uint32(res[0]) == 0 {
+		t.Fatalf("batch failed: %#x", res[0])
+	}
+	size, _ := mod.mem.ReadUint32Le(uint32(res[0]))
+	resp, _ := mod.mem.Read(uint32(res[0]), size)
+	results := decodeTestBatchResponse(t, resp)
+	if len(results) != len(ops) {
+		t.Fatalf("%d results, want %d", len(results), len(ops))
+	}
+	for i, r := range results {
+		if r.op != ops[i].op || r.status != want[i].status {
+			t.Errorf("result %d: op %d status %d, want op %d status %d", i, r.op, r.status, ops[i].op, want[i].status)
+		}
+		if want[i].payload != nil && !bytes.Equal(r.payload, want[i].payload) {
+			t.Errorf("result %d: payload %q, want %q", i, r.payload, want[i].payload)
+		}
+		if r.status != wireBatchOK && len(r.payload) == 0 {
+			t.Errorf("result %d: error without a message", i)
+		}
+	}
+
+	// A malformed request fails the whole batch
+	res = HostFSBatch(context.Background(), mod, []uint64{uint64(reqPtr), 4}, fs, abi)
+	if uint32(res[0]) != 0 || res[0]>>32 == 0 {
+		t.Errorf("malformed batch = %#x, want an error message", res[0])
+	}
+}
@@ -0,0 +1,210 @@
+package api
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io/fs"
+
+	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
+	wazeroapi "github.com/tetratelabs/wazero/api"
+)
+
+// Error codes returned by fs_* exports from WASMABIErrorCodes on, shared with
+// ErrorKind in agfs-cpp-sdk/agfs_types.h. A code with wasmErrorHasMessage set
+// has a message the host fetches through the plugin_last_error export.
+const (
+	WASMErrorNotFound         uint32 = 1
+	WASMErrorPermissionDenied uint32 = 2
+	WASMErrorAlreadyExists    uint32 = 3
+	WASMErrorIsDirectory      uint32 = 4
+	WASMErrorNotDirectory     uint32 = 5
+	WASMErrorReadOnly         uint32 = 6
+	WASMErrorInvalidInput     uint32 = 7
+	WASMErrorIo               uint32 = 8
+	WASMErrorUnsupported      uint32 = 9
+	WASMErrorOther            uint32 = 10
+
+	wasmErrorHasMessage uint32 = 0x80
+	wasmErrorCodeLimit  uint32 = 0x100
+)
+
+// WASMError is an error a plugin reported by code. It matches the standard
+// filesystem errors with errors.Is, so handlers map it to the right status.
+type WASMError struct {
+	Kind    uint32
+	Op      string
+	Path    string
+	Message string // Empty unless the plugin said more than the kind
+}
+
+func (e *WASMError) Error() string {
+	msg := e.Message
+	if msg == "" {
+		msg = wasmErrorText(e.Kind)
+	}
+	if e.Path != "" {
+		return fmt.Sprintf("%s: %s: %s", e.Op, e.Path, msg)
+	}
+	return fmt.Sprintf("%s: %s", e.Op, msg)
+}
+
+func (e *WASMError) Is(target error) bool {
+	switch e.Kind {
+	case WASMErrorNotFound:
+		return target == filesystem.ErrNotFound
+	case WASMErrorPermissionDenied, WASMErrorReadOnly:
+		return target == filesystem.ErrPermissionDenied
+	case WASMErrorAlreadyExists:
+		return target == filesystem.ErrAlreadyExists
+	case WASMErrorNotDirectory:
+		return target == filesystem.ErrNotDirectory
+	case WASMErrorInvalidInput:
+		return target == filesystem.ErrInvalidArgument
+	}
+	return false
+}
+
+func wasmErrorText(kind uint32) string {
+	switch kind {
+	case WASMErrorNotFound:
+		return "file not found"
+	case WASMErrorPermissionDenied:
+		return "permission denied"
+	case WASMErrorAlreadyExists:
+		return "file already exists"
+	case WASMErrorIsDirectory:
+		return "is a directory"
+	case WASMErrorNotDirectory:
+		return "not a directory"
+	case WASMErrorReadOnly:
+		return "read-only filesystem"
+	case WASMErrorUnsupported:
+		return "operation not supported"
+	default:
+		return "unknown error"
+	}
+}
+
+// errorFromCode builds the error for code, fetching its message from the
+// plugin only when the code says there is one. Callers hold wfs.mu, so the
+// message still belongs to the call that just failed.
+func (wfs *WASMFileSystem) errorFromCode(code uint32, op, path string) error {
+	e := &WASMError{Kind: code &^ wasmErrorHasMessage, Op: op, Path: path}
+	if code&wasmErrorHasMessage != 0 {
+		if lastErrorFunc := wfs.module.ExportedFunction("plugin_last_error"); lastErrorFunc != nil {
+			if results, err := lastErrorFunc.Call(wfs.ctx); err == nil && len(results) > 0 {
+				if msg, ok := takeStringFromMemory(wfs.module, uint32(results[0]), wfs.abiVersion); ok {
+					e.Message = msg
+				}
+			}
+		}
+	}
+	return e
+}
+
+// resultError decodes the error an export returned in place of a message
+// pointer. Plugins before WASMABIErrorCodes return the message itself.
+func (wfs *WASMFileSystem) resultError(result uint32, op, path string) error {
+	if wfs.abiVersion >= WASMABIErrorCodes && result < wasmErrorCodeLimit {
+		return wfs.errorFromCode(result, op, path)
+	}
+	if errMsg, ok := takeStringFromMemory(wfs.module, result, wfs.abiVersion); ok {
+		return fmt.Errorf("%s", errMsg)
+	}
+	return fmt.Errorf("%s failed", op)
+}
+
+// countError decodes the error of an export returning a negative count or
+// handle
+func (wfs *WASMFileSystem) countError(n int64, op, path string) error {
+	if wfs.abiVersion >= WASMABIErrorCodes && n < 0 && -n < int64(wasmErrorCodeLimit) {
+		return wfs.errorFromCode(uint32(-n), op, path)
+	}
+	return fmt.Errorf("%s failed", op)
+}
+
+// bufferError decodes the error of an export returning a (ptr, len) buffer
+// with a null ptr, which carries the code in len
+func (wfs *WASMFileSystem) bufferError(code uint32, op, path string) error {
+	if wfs.abiVersion >= WASMABIErrorCodes && code != 0 && code < wasmErrorCodeLimit {
+		return wfs.errorFromCode(code, op, path)
+	}
+	return fmt.Errorf("%s failed", op)
+}
+
+// Errors of host_fs_* functions
+//
+// From WASMABIErrorCodes on host functions report the same codes back to the
+// plugin. An error message they return carries the code in the u32 ahead of
+// its length prefix; a count or handle is the negated code, a (ptr, len)
+// buffer has the code in len with ptr 0, and a result pointer that fails
+// without a message is the code itself. Plugins before WASMABIErrorCodes get
+// the message, -1 or 0 alone.
+
+// hostErrorKind maps a host filesystem error to its code. nil, and errors
+// the standard ones do not cover, are WASMErrorOther.
+func hostErrorKind(err error) uint32 {
+	var werr *WASMError
+	switch {
+	case err == nil:
+		return WASMErrorOther
+	case errors.As(err, &werr):
+		return werr.Kind
+	case errors.Is(err, filesystem.ErrNotFound), errors.Is(err, fs.ErrNotExist):
+		return WASMErrorNotFound
+	case errors.Is(err, filesystem.ErrPermissionDenied), errors.Is(err, fs.ErrPermission):
+		return WASMErrorPermissionDenied
+	case errors.Is(err, filesystem.ErrAlreadyExists), errors.Is(err, fs.ErrExist):
+		return WASMErrorAlreadyExists
+	case errors.Is(err, filesystem.ErrNotDirectory):
+		return WASMErrorNotDirectory
+	case errors.Is(err, filesystem.ErrInvalidArgument), errors.Is(err, fs.ErrInvalid):
+		return WASMErrorInvalidInput
+	}
+	return WASMErrorOther
+}
+
+// hostErrorCode is the result of a host function returning a result pointer
+// that failed with err
+func hostErrorCode(err error, abi *HostABI) uint64 {
+	if abi.Version() < WASMABIErrorCodes {
+		return 0
+	}
+	return uint64(hostErrorKind(err))
+}
+
+// hostErrorCount is the result of a host function returning a count or
+// handle that failed with err (nil when no filesystem error is behind it)
+func hostErrorCount(err error, abi *HostABI) uint64 {
+	if abi.Version() < WASMABIErrorCodes {
+		return ^uint64(0) // -1 as int64
+	}
+	return uint64(-int64(hostErrorKind(err)))
+}
+
+// hostErrorBuffer is the result of a host function returning a (ptr, len)
+// buffer that failed with err
+func hostErrorBuffer(err error, abi *HostABI) uint64 {
+	if abi.Version() < WASMABIErrorCodes {
+		return 0
+	}
+	return uint64(hostErrorKind(err)) << 32
+}
+
+// writeHostError writes the message of err into the plugin's scratch arena for
+// a host function's error result, with its code ahead of the length prefix
+func writeHostError(module wazeroapi.Module, err error, abi *HostABI) (uint32, error) {
+	version := abi.Version()
+	if version < WASMABIErrorCodes {
+		return writeScratchStringToMemory(module, err.Error(), version)
+	}
+	buf := make([]byte, 4, 4+4+len(err.Error())+1)
+	binary.LittleEndian.PutUint32(buf, hostErrorKind(err))
+	buf = append(buf, lengthPrefixed(err.Error())...)
+	ptr, werr := writeToMemory(module, scratchAllocator(module), buf)
+	if werr != nil {
+		return 0, werr
+	}
+	return ptr + 8, nil
+}
@@ -0,0 +1,117 @@
+package api
+
+import (
+	"errors"
+	"testing"
+
+	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
+	wazeroapi "github.com/tetratelabs/wazero/api"
+)
+
+// noExportsModule is a module without memory or exports: plugin_last_error
+// and plugin_free_result are missing and message pointers read as nothing
+type noExportsModule struct {
+	wazeroapi.Module
+}
+
+func (noExportsModule) ExportedFunction(string) wazeroapi.Function { return nil }
+func (noExportsModule) Memory() wazeroapi.Memory                   { return nil }
+
+func TestWASMErrorIs(t *testing.T) {
+	targets := []error{
+		filesystem.ErrNotFound,
+		filesystem.ErrPermissionDenied,
+		filesystem.ErrAlreadyExists,
+		filesystem.ErrNotDirectory,
+		filesystem.ErrInvalidArgument,
+	}
+	tests := []struct {
+		kind uint32
+		want error // nil matches none of targets
+	}{
+		{WASMErrorNotFound, filesystem.ErrNotFound},
+		{WASMErrorPermissionDenied, filesystem.ErrPermissionDenied},
+		{WASMErrorAlreadyExists, filesystem.ErrAlreadyExists},
+		{WASMErrorIsDirectory, nil},
+		{WASMErrorNotDirectory, filesystem.ErrNotDirectory},
+		{WASMErrorReadOnly, filesystem.ErrPermissionDenied},
+		{WASMErrorInvalidInput, filesystem.ErrInvalidArgument},
+		{WASMErrorIo, nil},
+		{WASMErrorUnsupported, nil},
+		{WASMErrorOther, nil},
+		{wasmErrorCodeLimit - 1, nil},
+	}
+	for _, tt := range tests {
+		err := error(&WASMError{Kind: tt.kind, Op: "stat", Path: "/a"})
+		for _, target := range targets {
+			if got := errors.Is(err, target); got != (target == tt.want) {
+				t.Errorf("kind %d: errors.Is(%v) = %v", tt.kind, target, got)
+			}
+		}
+	}
+}
+
+func TestWASMErrorMessage(t *testing.T) {
+	tests := []struct {
+		err  WASMError
+		want string
+	}{
+		{WASMError{Kind: WASMErrorNotFound, Op: "stat", Path: "/a"}, "stat: /a: file not found"},
+		{WASMError{Kind: WASMErrorIo, Op: "read", Path: "/a", Message: "disk on fire"}, "read: /a: disk on fire"},
+		{WASMError{Kind: WASMErrorOther, Op: "rename"}, "rename: unknown error"},
+	}
+	for _, tt := range tests {
+		if got := tt.err.Error(); got != tt.want {
+			t.Errorf("Error() = %q, want %q", got, tt.want)
+		}
+	}
+}
+
+// wantWASMError checks that err is a WASMError of kind, or a plain error
+// when kind is 0
+func wantWASMError(t *testing.T, err error, kind uint32) {
+	t.Helper()
+	var werr *WASMError
+	if kind == 0 {
+		if err == nil || errors.As(err, &werr) {
+			t.Errorf("got %v, want a plain error", err)
+		}
+		return
+	}
+	if !errors.As(err, &werr) {
+		t.Fatalf("got %v, want a WASMError", err)
+	}
+	if werr.Kind != kind || werr.Op != "op" || werr.Path != "/p" || werr.Message != "" {
+		t.Errorf("got %+v, want kind %d", werr, kind)
+	}
+}
+
+func TestErrorCodeThresholds(t *testing.T) {
+	tests := []struct {
+		name  string
+		abi   uint32
+		value uint32 // Code, or the count negated
+		want  uint32 // Decoded kind, 0 for a plain error
+	}{
+		{"code", WASMABIErrorCodes, WASMErrorNotFound, WASMErrorNotFound},
+		{"code with message", WASMABIErrorCodes, WASMErrorIo | wasmErrorHasMessage, WASMErrorIo},
+		{"largest code", WASMABIErrorCodes, wasmErrorCodeLimit - 1, (wasmErrorCodeLimit - 1) &^ wasmErrorHasMessage},
+		{"at limit", WASMABIErrorCodes, wasmErrorCodeLimit, 0},
+		{"pointer", WASMABIErrorCodes, 0x10000, 0},
+		{"before error codes", WASMABIStringLength, WASMErrorNotFound, 0},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			wfs := &WASMFileSystem{module: noExportsModule{}, abiVersion: tt.abi}
+			wantWASMError(t, wfs.resultError(tt.value, "op", "/p"), tt.want)
+			wantWASMError(t, wfs.countError(-int64(tt.value), "op", "/p"), tt.want)
+			wantWASMError(t, wfs.bufferError(tt.value, "op", "/p"), tt.want)
+		})
+	}
+
+	// Zero is not an error code, and counts are only errors when negative
+	wfs := &WASMFileSystem{module: noExportsModule{}, abiVersion: WASMABIErrorCodes}
+	wantWASMError(t, wfs.bufferError(0, "op", "/p"), 0)
+	wantWASMError(t, wfs.countError(0, "op", "/p"), 0)
+	wantWASMError(t, wfs.countError(int64(WASMErrorNotFound), "op", "/p"), 0)
+}
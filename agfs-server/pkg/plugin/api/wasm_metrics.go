@@ -0,0 +1,146 @@
+package api
+
+import (
+	"encoding/json"
+	"fmt"
+	"sync"
+)
+
+// WASMOpMetrics are the counters a plugin built with AGFS_METRICS keeps for
+// one export, or for all of its HostFS calls. LatencyUsLog2[0] counts calls
+// under 1us and LatencyUsLog2[i] those in [2^(i-1), 2^i) us.
+type WASMOpMetrics struct {
+	Calls         uint64   `json:"calls"`
+	Errors        uint64   `json:"errors"`
+	BytesIn       uint64   `json:"bytes_in"`
+	BytesOut      uint64   `json:"bytes_out"`
+	TotalNs       uint64   `json:"total_ns"`
+	LatencyUsLog2 []uint64 `json:"latency_us_log2"`
+}
+
+func (m *WASMOpMetrics) add(o *WASMOpMetrics) {
+	if o == nil {
+		return
+	}
+	m.Calls += o.Calls
+	m.Errors += o.Errors
+	m.BytesIn += o.BytesIn
+	m.BytesOut += o.BytesOut
+	m.TotalNs += o.TotalNs
+	for i, n := range o.LatencyUsLog2 {
+		if i >= len(m.LatencyUsLog2) {
+			m.LatencyUsLog2 = append(m.LatencyUsLog2, 0)
+		}
+		m.LatencyUsLog2[i] += n
+	}
+}
+
+// WASMPluginMetrics is a plugin_metrics snapshot, summed over the instances
+// of a pooled plugin
+type WASMPluginMetrics struct {
+	Name           string                    `json:"name"`
+	Instances      int                       `json:"instances"`
+	Ops            map[string]*WASMOpMetrics `json:"ops"`
+	HostFS         WASMOpMetrics             `json:"hostfs"`
+	ArenaHighWater uint64                    `json:"arena_high_water"`
+	MemoryBytes    uint64                    `json:"memory_bytes"`
+}
+
+func (m *WASMPluginMetrics) add(o *WASMPluginMetrics) {
+	for name, op := range o.Ops {
+		if m.Ops[name] == nil {
+			m.Ops[name] = &WASMOpMetrics{}
+		}
+		m.Ops[name].add(op)
+	}
+	m.HostFS.add(&o.HostFS)
+	if o.ArenaHighWater > m.ArenaHighWater {
+		m.ArenaHighWater = o.ArenaHighWater
+	}
+	m.MemoryBytes += o.MemoryBytes
+}
+
+// Metrics returns the plugin's counters, or false if it was built without
+// AGFS_METRICS and has no plugin_metrics export
+func (wp *WASMPlugin) Metrics() (*WASMPluginMetrics, bool) {
+	if wp.module.ExportedFunction("plugin_metrics") == nil {
+		return nil, false
+	}
+
+	total := &WASMPluginMetrics{Name: wp.name, Ops: make(map[string]*WASMOpMetrics)}
+	for _, inst := range wp.instances {
+		m, err := inst.metrics()
+		if err != nil {
+			continue
+		}
+		total.add(m)
+		total.Instances++
+	}
+	return total, true
+}
+
+func (wfs *WASMFileSystem) metrics() (*WASMPluginMetrics, error) {
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
+	results, err := wfs.module.ExportedFunction("plugin_metrics").Call(wfs.ctx)
+	if err != nil {
+		return nil, fmt.Errorf("plugin_metrics call failed: %w", err)
+	}
+	if len(results) == 0 || results[0] == 0 {
+		return nil, fmt.Errorf("plugin_metrics returned nothing")
+	}
+	data, ok := takeStringFromMemory(wfs.module, uint32(results[0]), wfs.abiVersion)
+	if !ok {
+		return nil, fmt.Errorf("failed to read plugin_metrics result")
+	}
+
+	var m WASMPluginMetrics
+	if err := json.Unmarshal([]byte(data), &m); err != nil {
+		return nil, fmt.Errorf("failed to parse plugin_metrics result: %w", err)
+	}
+	return &m, nil
+}
+
+// Plugins whose metrics CollectWASMMetrics reports, keyed by the path they
+// were loaded from
+var wasmMetricsRegistry = struct {
+	mu      sync.Mutex
+	plugins map[string]*WASMPlugin
+}{plugins: make(map[string]*WASMPlugin)}
+
+// TrackWASMPlugin makes CollectWASMMetrics report wp under key until
+// UntrackWASMPlugin is called with the same key
+func TrackWASMPlugin(key string, wp *WASMPlugin) {
+	wasmMetricsRegistry.mu.Lock()
+	defer wasmMetricsRegistry.mu.Unlock()
+	wasmMetricsRegistry.plugins[key] = wp
+}
+
+// UntrackWASMPlugin stops reporting the plugin tracked under key
+func UntrackWASMPlugin(key string) {
+	wasmMetricsRegistry.mu.Lock()
+	defer wasmMetricsRegistry.mu.Unlock()
+	delete(wasmMetricsRegistry.plugins, key)
+}
+
+// CollectWASMMetrics snapshots every tracked plugin that exports metrics,
+// keyed as it was tracked
+func CollectWASMMetrics() map[string]*WASMPluginMetrics {
+	wasmMetricsRegistry.mu.Lock()
+	plugins := make(map[string]*WASMPlugin, len(wasmMetricsRegistry.plugins))
+	for key, wp := range wasmMetricsRegistry.plugins {
+		plugins[key] = wp
+	}
+	wasmMetricsRegistry.mu.Unlock()
+
+	// Plugins are called outside the registry lock; each call waits for the
+	// instance it samples to finish its current request
+	out := make(map[string]*WASMPluginMetrics)
+	for key, wp := range plugins {
+		if m, ok := wp.Metrics(); ok {
+			out[key] = m
+		}
+	}
+	return out
+}
@@ -1,10 +1,16 @@
 package api
 
 import (
+	"bytes"
 	"context"
+	"encoding/binary"
 	"encoding/json"
+	"errors"
 	"fmt"
 	"io"
+	"math"
+	"strconv"
+	"sync"
 
 	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
 	log "github.com/sirupsen/logrus"
@@ -13,20 +19,71 @@ import (
 
 // WASMPlugin represents a plugin loaded from a WASM module
 type WASMPlugin struct {
-	ctx        context.Context
-	module     wazeroapi.Module
-	name       string
-	fileSystem *WASMFileSystem
+	ctx         context.Context
+	module      wazeroapi.Module
+	name        string
+	abiVersion  uint32
+	concurrency uint32
+	fileSystem  *WASMFileSystem
+
+	// Every instance of the module, fileSystem first; see AddInstance
+	instances []*WASMFileSystem
+	pool      *wasmPool
+
+	// Where Initialize keeps startup snapshots; see SetSnapshotDir
+	snapshotDir string
+	moduleKey   string
+
+	// Background warm-up started by Initialize; see startWarmup
+	warmupStop chan struct{}
+	warmupDone sync.WaitGroup
 }
 
 // WASMFileSystem implements filesystem.FileSystem by delegating to WASM functions
 type WASMFileSystem struct {
-	ctx    context.Context
-	module wazeroapi.Module
+	ctx          context.Context
+	module       wazeroapi.Module
+	abiVersion   uint32
+	capabilities uint32
+
+	// mu serializes calls into the module; a module instance is not reentrant
+	mu sync.Mutex
 }
 
 // NewWASMPlugin creates a new WASM plugin wrapper
 func NewWASMPlugin(ctx context.Context, module wazeroapi.Module) (*WASMPlugin, error) {
+	fileSystem, err := newWASMInstance(ctx, module)
+	if err != nil {
+		return nil, err
+	}
+
+	// Get plugin name
+	name := "wasm-plugin"
+	if nameFunc := module.ExportedFunction("plugin_name"); nameFunc != nil {
+		if nameResults, err := nameFunc.Call(ctx); err == nil && len(nameResults) > 0 {
+			// Read string from memory
+			if nameStr, ok := takeStringFromMemory(module, uint32(nameResults[0]), fileSystem.abiVersion); ok {
+				name = nameStr
+			}
+		}
+	}
+
+	wp := &WASMPlugin{
+		ctx:         ctx,
+		module:      module,
+		name:        name,
+		abiVersion:  fileSystem.abiVersion,
+		concurrency: queryConcurrency(ctx, module),
+		fileSystem:  fileSystem,
+		instances:   []*WASMFileSystem{fileSystem},
+	}
+
+	return wp, nil
+}
+
+// newWASMInstance runs plugin_new on a freshly instantiated module and
+// negotiates its ABI version
+func newWASMInstance(ctx context.Context, module wazeroapi.Module) (*WASMFileSystem, error) {
 	// Verify required functions exist
 	if module.ExportedFunction("plugin_new") == nil {
 		return nil, fmt.Errorf("WASM module missing required function: plugin_new")
@@ -42,28 +99,115 @@ func NewWASMPlugin(ctx context.Context, module wazeroapi.Module) (*WASMPlugin, e
 		return nil, fmt.Errorf("plugin_new returned no results")
 	}
 
-	// Get plugin name
-	name := "wasm-plugin"
-	if nameFunc := module.ExportedFunction("plugin_name"); nameFunc != nil {
-		if nameResults, err := nameFunc.Call(ctx); err == nil && len(nameResults) > 0 {
-			// Read string from memory
-			if nameStr, ok := readStringFromMemory(module, uint32(nameResults[0])); ok {
-				name = nameStr
-			}
-		}
+	return &WASMFileSystem{
+		ctx:          ctx,
+		module:       module,
+		abiVersion:   negotiateABIVersion(ctx, module),
+		capabilities: queryCapabilities(ctx, module),
+	}, nil
+}
+
+// Optional operations reported by the plugin_capabilities export, shared with
+// Capability in agfs-cpp-sdk/agfs_types.h. Plugins that do not export it are
+// assumed to implement every operation they export.
+const (
+	WASMCapWrite       uint32 = 1 << 0
+	WASMCapCreate      uint32 = 1 << 1
+	WASMCapMkdir       uint32 = 1 << 2
+	WASMCapRemove      uint32 = 1 << 3
+	WASMCapRemoveAll   uint32 = 1 << 4
+	WASMCapRename      uint32 = 1 << 5
+	WASMCapChmod       uint32 = 1 << 6
+	WASMCapStreaming   uint32 = 1 << 7
+	WASMCapReadDirPage uint32 = 1 << 8
+	WASMCapSnapshot    uint32 = 1 << 9 // plugin_snapshot/plugin_restore
+	WASMCapCopy        uint32 = 1 << 10
+	WASMCapWarmup      uint32 = 1 << 11 // plugin_warmup
+	WASMCapAll         uint32 = 1<<12 - 1
+)
+
+// queryCapabilities asks the plugin which optional operations it implements
+func queryCapabilities(ctx context.Context, module wazeroapi.Module) uint32 {
+	capsFunc := module.ExportedFunction("plugin_capabilities")
+	if capsFunc == nil {
+		return WASMCapAll
 	}
 
-	wp := &WASMPlugin{
-		ctx:    ctx,
-		module: module,
-		name:   name,
-		fileSystem: &WASMFileSystem{
-			ctx:    ctx,
-			module: module,
-		},
+	results, err := capsFunc.Call(ctx)
+	if err != nil || len(results) == 0 {
+		return WASMCapAll
 	}
+	return uint32(results[0])
+}
 
-	return wp, nil
+// optionalExport returns the export serving an optional operation, or nil if
+// the plugin does not implement it. Callers check it before taking the lock
+// or writing any argument into linear memory.
+func (wfs *WASMFileSystem) optionalExport(name string, capability uint32) wazeroapi.Function {
+	if wfs.capabilities&capability == 0 {
+		return nil
+	}
+	return wfs.module.ExportedFunction(name)
+}
+
+// negotiateABIVersion offers WASMABIVersion to the plugin and returns the
+// version both sides will use. Plugins without plugin_abi_version speak JSON.
+func negotiateABIVersion(ctx context.Context, module wazeroapi.Module) uint32 {
+	abiFunc := module.ExportedFunction("plugin_abi_version")
+	if abiFunc == nil {
+		return WASMABIJSON
+	}
+
+	results, err := abiFunc.Call(ctx, uint64(WASMABIVersion))
+	if err != nil || len(results) == 0 {
+		log.Warnf("plugin_abi_version failed, falling back to JSON ABI: %v", err)
+		return WASMABIJSON
+	}
+
+	version := uint32(results[0])
+	if version < WASMABIJSON {
+		return WASMABIJSON
+	}
+	if version > WASMABIVersion {
+		return WASMABIVersion
+	}
+	return version
+}
+
+// ABIVersion returns the ABI version negotiated with the plugin
+func (wp *WASMPlugin) ABIVersion() uint32 {
+	return wp.abiVersion
+}
+
+// Poolable reports whether the plugin declared that several instances of its
+// module may serve one mount
+func (wp *WASMPlugin) Poolable() bool {
+	return wp.concurrency != WASMConcurrencyExclusive
+}
+
+// AddInstance adds another instance of the same compiled module to the pool.
+// It must be called before Initialize, which configures every instance.
+func (wp *WASMPlugin) AddInstance(module wazeroapi.Module) error {
+	if !wp.Poolable() {
+		return fmt.Errorf("plugin %s does not support instance pooling", wp.name)
+	}
+
+	inst, err := newWASMInstance(wp.ctx, module)
+	if err != nil {
+		return err
+	}
+	if inst.abiVersion != wp.abiVersion {
+		return fmt.Errorf("instance negotiated ABI version %d, expected %d", inst.abiVersion, wp.abiVersion)
+	}
+
+	wp.instances = append(wp.instances, inst)
+	wp.pool = newWASMPool(wp.instances)
+	return nil
+}
+
+// InstanceCount returns how many module instances serve the plugin
+func (wp *WASMPlugin) InstanceCount() int {
+	return len(wp.instances)
 }
 
 // Name returns the plugin name
@@ -73,6 +217,10 @@ func (wp *WASMPlugin) Name() string {
 
 // Validate validates the plugin configuration
 func (wp *WASMPlugin) Validate(config map[string]interface{}) error {
+	// Every instance runs the same code, so validating once is enough
+	wp.fileSystem.mu.Lock()
+	defer wp.fileSystem.mu.Unlock()
+
 	validateFunc := wp.module.ExportedFunction("plugin_validate")
 	if validateFunc == nil {
 		// If validate function is not exported, assume validation passes
@@ -90,6 +238,7 @@ func (wp *WASMPlugin) Validate(config map[string]interface{}) error {
 	if err != nil {
 		return fmt.Errorf("failed to write config to memory: %w", err)
 	}
+	defer freeStringMemory(wp.module, configPtr)
 
 	// Call validate function
 	results, err := validateFunc.Call(wp.ctx, uint64(configPtr))
@@ -99,7 +248,7 @@ func (wp *WASMPlugin) Validate(config map[string]interface{}) error {
 
 	// Check for error return (non-zero means error)
 	if len(results) > 0 && results[0] != 0 {
-		if errMsg, ok := readStringFromMemory(wp.module, uint32(results[0])); ok {
+		if errMsg, ok := takeStringFromMemory(wp.module, uint32(results[0]), wp.abiVersion); ok {
 			return fmt.Errorf("validation failed: %s", errMsg)
 		}
 		return fmt.Errorf("validation failed")
@@ -109,9 +258,9 @@ func (wp *WASMPlugin) Validate(config map[string]interface{}) error {
 }
 
 // Initialize initializes the plugin with configuration
+// Pooled plugins initialize every instance with the same configuration.
 func (wp *WASMPlugin) Initialize(config map[string]interface{}) error {
-	initFunc := wp.module.ExportedFunction("plugin_initialize")
-	if initFunc == nil {
+	if wp.module.ExportedFunction("plugin_initialize") == nil {
 		// If initialize function is not exported, assume initialization succeeds
 		return nil
 	}
@@ -122,21 +271,61 @@ func (wp *WASMPlugin) Initialize(config map[string]interface{}) error {
 		return fmt.Errorf("failed to marshal config: %w", err)
 	}
 
+	// Instances restore from a stored snapshot if there is one, else the
+	// first initializes and the rest restore from its snapshot
+	snapshot := wp.loadSnapshot(configJSON)
+	stored := snapshot != nil
+	for _, inst := range wp.instances {
+		if snapshot != nil {
+			err := inst.restore(configJSON, snapshot)
+			if err == nil {
+				continue
+			}
+			log.Warnf("WASM plugin %s: %v; initializing instead", wp.name, err)
+			snapshot, stored = nil, false
+		}
+
+		if err := inst.initialize(configJSON); err != nil {
+			return err
+		}
+
+		data, ok, err := inst.snapshot()
+		if err != nil {
+			log.Warnf("WASM plugin %s: %v", wp.name, err)
+		} else if ok {
+			snapshot = data
+		}
+	}
+	if snapshot != nil && !stored {
+		wp.storeSnapshot(configJSON, snapshot)
+	}
+
+	wp.startWarmup()
+	return nil
+}
+
+func (wfs *WASMFileSystem) initialize(configJSON []byte) error {
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
+	initFunc := wfs.module.ExportedFunction("plugin_initialize")
+
 	// Write config to WASM memory
-	configPtr, err := writeStringToMemory(wp.module, string(configJSON))
+	configPtr, err := writeStringToMemory(wfs.module, string(configJSON))
 	if err != nil {
 		return fmt.Errorf("failed to write config to memory: %w", err)
 	}
+	defer freeStringMemory(wfs.module, configPtr)
 
 	// Call initialize function
-	results, err := initFunc.Call(wp.ctx, uint64(configPtr))
+	results, err := initFunc.Call(wfs.ctx, uint64(configPtr))
 	if err != nil {
 		return fmt.Errorf("initialize call failed: %w", err)
 	}
 
 	// Check for error return
 	if len(results) > 0 && results[0] != 0 {
-		if errMsg, ok := readStringFromMemory(wp.module, uint32(results[0])); ok {
+		if errMsg, ok := takeStringFromMemory(wfs.module, uint32(results[0]), wfs.abiVersion); ok {
 			return fmt.Errorf("initialization failed: %s", errMsg)
 		}
 		return fmt.Errorf("initialization failed")
@@ -147,11 +336,17 @@ func (wp *WASMPlugin) Initialize(config map[string]interface{}) error {
 
 // GetFileSystem returns the file system implementation
 func (wp *WASMPlugin) GetFileSystem() filesystem.FileSystem {
+	if wp.pool != nil {
+		return wp.pool
+	}
 	return wp.fileSystem
 }
 
 // GetReadme returns the plugin README
 func (wp *WASMPlugin) GetReadme() string {
+	wp.fileSystem.mu.Lock()
+	defer wp.fileSystem.mu.Unlock()
+
 	readmeFunc := wp.module.ExportedFunction("plugin_get_readme")
 	if readmeFunc == nil {
 		return ""
@@ -164,7 +359,7 @@ func (wp *WASMPlugin) GetReadme() string {
 	}
 
 	if len(results) > 0 {
-		if readme, ok := readStringFromMemory(wp.module, uint32(results[0])); ok {
+		if readme, ok := takeStringFromMemory(wp.module, uint32(results[0]), wp.abiVersion); ok {
 			return readme
 		}
 	}
@@ -172,21 +367,34 @@ func (wp *WASMPlugin) GetReadme() string {
 	return ""
 }
 
-// Shutdown shuts down the plugin
+// Shutdown shuts down the plugin, every instance of it when pooled
 func (wp *WASMPlugin) Shutdown() error {
-	shutdownFunc := wp.module.ExportedFunction("plugin_shutdown")
-	if shutdownFunc == nil {
+	wp.stopWarmup()
+	if wp.module.ExportedFunction("plugin_shutdown") == nil {
 		return nil
 	}
 
-	results, err := shutdownFunc.Call(wp.ctx)
+	var firstErr error
+	for _, inst := range wp.instances {
+		if err := inst.shutdown(); err != nil && firstErr == nil {
+			firstErr = err
+		}
+	}
+	return firstErr
+}
+
+func (wfs *WASMFileSystem) shutdown() error {
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
+	results, err := wfs.module.ExportedFunction("plugin_shutdown").Call(wfs.ctx)
 	if err != nil {
 		return fmt.Errorf("shutdown call failed: %w", err)
 	}
 
 	// Check for error return
 	if len(results) > 0 && results[0] != 0 {
-		if errMsg, ok := readStringFromMemory(wp.module, uint32(results[0])); ok {
+		if errMsg, ok := takeStringFromMemory(wfs.module, uint32(results[0]), wfs.abiVersion); ok {
 			return fmt.Errorf("shutdown failed: %s", errMsg)
 		}
 		return fmt.Errorf("shutdown failed")
@@ -198,15 +406,19 @@ func (wp *WASMPlugin) Shutdown() error {
 // WASMFileSystem implementations
 
 func (wfs *WASMFileSystem) Create(path string) error {
-	createFunc := wfs.module.ExportedFunction("fs_create")
+	createFunc := wfs.optionalExport("fs_create", WASMCapCreate)
 	if createFunc == nil {
 		return fmt.Errorf("fs_create not implemented")
 	}
 
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
 	pathPtr, err := writeStringToMemory(wfs.module, path)
 	if err != nil {
 		return err
 	}
+	defer freeStringMemory(wfs.module, pathPtr)
 
 	results, err := createFunc.Call(wfs.ctx, uint64(pathPtr))
 	if err != nil {
@@ -214,25 +426,26 @@ func (wfs *WASMFileSystem) Create(path string) error {
 	}
 
 	if len(results) > 0 && results[0] != 0 {
-		if errMsg, ok := readStringFromMemory(wfs.module, uint32(results[0])); ok {
-			return fmt.Errorf("%s", errMsg)
-		}
-		return fmt.Errorf("create failed")
+		return wfs.resultError(uint32(results[0]), "create", path)
 	}
 
 	return nil
 }
 
 func (wfs *WASMFileSystem) Mkdir(path string, perm uint32) error {
-	mkdirFunc := wfs.module.ExportedFunction("fs_mkdir")
+	mkdirFunc := wfs.optionalExport("fs_mkdir", WASMCapMkdir)
 	if mkdirFunc == nil {
 		return fmt.Errorf("fs_mkdir not implemented")
 	}
 
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
 	pathPtr, err := writeStringToMemory(wfs.module, path)
 	if err != nil {
 		return err
 	}
+	defer freeStringMemory(wfs.module, pathPtr)
 
 	results, err := mkdirFunc.Call(wfs.ctx, uint64(pathPtr), uint64(perm))
 	if err != nil {
@@ -240,25 +453,26 @@ func (wfs *WASMFileSystem) Mkdir(path string, perm uint32) error {
 	}
 
 	if len(results) > 0 && results[0] != 0 {
-		if errMsg, ok := readStringFromMemory(wfs.module, uint32(results[0])); ok {
-			return fmt.Errorf("%s", errMsg)
-		}
-		return fmt.Errorf("mkdir failed")
+		return wfs.resultError(uint32(results[0]), "mkdir", path)
 	}
 
 	return nil
 }
 
 func (wfs *WASMFileSystem) Remove(path string) error {
-	removeFunc := wfs.module.ExportedFunction("fs_remove")
+	removeFunc := wfs.optionalExport("fs_remove", WASMCapRemove)
 	if removeFunc == nil {
 		return fmt.Errorf("fs_remove not implemented")
 	}
 
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
 	pathPtr, err := writeStringToMemory(wfs.module, path)
 	if err != nil {
 		return err
 	}
+	defer freeStringMemory(wfs.module, pathPtr)
 
 	results, err := removeFunc.Call(wfs.ctx, uint64(pathPtr))
 	if err != nil {
@@ -266,26 +480,27 @@ func (wfs *WASMFileSystem) Remove(path string) error {
 	}
 
 	if len(results) > 0 && results[0] != 0 {
-		if errMsg, ok := readStringFromMemory(wfs.module, uint32(results[0])); ok {
-			return fmt.Errorf("%s", errMsg)
-		}
-		return fmt.Errorf("remove failed")
+		return wfs.resultError(uint32(results[0]), "remove", path)
 	}
 
 	return nil
 }
 
 func (wfs *WASMFileSystem) RemoveAll(path string) error {
-	removeAllFunc := wfs.module.ExportedFunction("fs_remove_all")
+	removeAllFunc := wfs.optionalExport("fs_remove_all", WASMCapRemoveAll)
 	if removeAllFunc == nil {
 		// Fall back to Remove if RemoveAll not implemented
 		return wfs.Remove(path)
 	}
 
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
 	pathPtr, err := writeStringToMemory(wfs.module, path)
 	if err != nil {
 		return err
 	}
+	defer freeStringMemory(wfs.module, pathPtr)
 
 	results, err := removeAllFunc.Call(wfs.ctx, uint64(pathPtr))
 	if err != nil {
@@ -293,16 +508,32 @@ func (wfs *WASMFileSystem) RemoveAll(path string) error {
 	}
 
 	if len(results) > 0 && results[0] != 0 {
-		if errMsg, ok := readStringFromMemory(wfs.module, uint32(results[0])); ok {
-			return fmt.Errorf("%s", errMsg)
-		}
-		return fmt.Errorf("remove_all failed")
+		return wfs.resultError(uint32(results[0]), "remove_all", path)
 	}
 
 	return nil
 }
 
+// WASMReadIntoMaxBuffer is the largest buffer Read allocates in the module
+// for fs_read_into. The size comes from the request, not the file, and linear
+// memory never shrinks, so larger reads go through fs_read, which allocates
+// only the bytes the plugin returns.
+const WASMReadIntoMaxBuffer = 4 << 20
+
 func (wfs *WASMFileSystem) Read(path string, offset int64, size int64) ([]byte, error) {
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
+	// Prefer the zero-copy export for bounded reads: the plugin writes
+	// straight into a buffer the host allocated
+	if size > 0 && size <= WASMReadIntoMaxBuffer {
+		if readIntoFunc := wfs.module.ExportedFunction("fs_read_into"); readIntoFunc != nil {
+			if data, handled, err := wfs.readInto(readIntoFunc, path, offset, uint32(size)); handled {
+				return data, err
+			}
+		}
+	}
+
 	readFunc := wfs.module.ExportedFunction("fs_read")
 	if readFunc == nil {
 		return nil, fmt.Errorf("fs_read not implemented")
@@ -312,6 +543,7 @@ func (wfs *WASMFileSystem) Read(path string, offset int64, size int64) ([]byte,
 	if err != nil {
 		return nil, err
 	}
+	defer freeStringMemory(wfs.module, pathPtr)
 
 	results, err := readFunc.Call(wfs.ctx, uint64(pathPtr), uint64(offset), uint64(size))
 	if err != nil {
@@ -328,10 +560,10 @@ func (wfs *WASMFileSystem) Read(path string, offset int64, size int64) ([]byte,
 	dataSize := uint32((packed >> 32) & 0xFFFFFFFF)
 
 	if dataPtr == 0 {
-		return nil, fmt.Errorf("read failed")
+		return nil, wfs.bufferError(dataSize, "read", path)
 	}
 
-	data, ok := wfs.module.Memory().Read(dataPtr, dataSize)
+	data, ok := takeBytesFromMemory(wfs.module, dataPtr, dataSize)
 	if !ok {
 		return nil, fmt.Errorf("failed to read data from memory")
 	}
@@ -339,21 +571,68 @@ func (wfs *WASMFileSystem) Read(path string, offset int64, size int64) ([]byte,
 	return data, nil
 }
 
+// readInto calls fs_read_into with a host-allocated buffer of size bytes.
+// handled is false, and nothing was called, when the buffer could not be
+// allocated; the caller then falls back to fs_read.
+func (wfs *WASMFileSystem) readInto(readIntoFunc wazeroapi.Function, path string, offset int64, size uint32) (data []byte, handled bool, err error) {
+	bufPtr, err := allocMemory(wfs.module, "malloc", size)
+	if err != nil {
+		log.Debugf("fs_read_into buffer of %d bytes unavailable, using fs_read: %v", size, err)
+		return nil, false, nil
+	}
+	defer freeMemory(wfs.module, bufPtr)
+
+	pathPtr, err := writeStringToMemory(wfs.module, path)
+	if err != nil {
+		return nil, true, err
+	}
+	defer freeStringMemory(wfs.module, pathPtr)
+
+	results, err := readIntoFunc.Call(wfs.ctx, uint64(pathPtr), uint64(offset), uint64(bufPtr), uint64(size))
+	if err != nil {
+		return nil, true, fmt.Errorf("fs_read_into failed: %w", err)
+	}
+
+	if len(results) < 1 {
+		return nil, true, fmt.Errorf("fs_read_into returned invalid results")
+	}
+
+	n := int64(results[0])
+	if n < 0 {
+		return nil, true, wfs.countError(n, "read", path)
+	}
+	if n > int64(size) {
+		return nil, true, fmt.Errorf("fs_read_into overran its buffer")
+	}
+
+	data, ok := readBytesFromMemory(wfs.module, bufPtr, uint32(n))
+	if !ok {
+		return nil, true, fmt.Errorf("failed to read data from memory")
+	}
+
+	return data, true, nil
+}
+
 func (wfs *WASMFileSystem) Write(path string, data []byte) ([]byte, error) {
-	writeFunc := wfs.module.ExportedFunction("fs_write")
+	writeFunc := wfs.optionalExport("fs_write", WASMCapWrite)
 	if writeFunc == nil {
 		return nil, fmt.Errorf("fs_write not implemented")
 	}
 
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
 	pathPtr, err := writeStringToMemory(wfs.module, path)
 	if err != nil {
 		return nil, err
 	}
+	defer freeStringMemory(wfs.module, pathPtr)
 
 	dataPtr, err := writeBytesToMemory(wfs.module, data)
 	if err != nil {
 		return nil, err
 	}
+	defer freeMemory(wfs.module, dataPtr)
 
 	results, err := writeFunc.Call(wfs.ctx, uint64(pathPtr), uint64(dataPtr), uint64(len(data)))
 	if err != nil {
@@ -370,11 +649,11 @@ func (wfs *WASMFileSystem) Write(path string, data []byte) ([]byte, error) {
 	responseSize := uint32((packed >> 32) & 0xFFFFFFFF)
 
 	if responsePtr == 0 {
-		return nil, fmt.Errorf("write failed")
+		return nil, wfs.bufferError(responseSize, "write", path)
 	}
 
 	// Read response data from memory
-	response, ok := wfs.module.Memory().Read(responsePtr, responseSize)
+	response, ok := takeBytesFromMemory(wfs.module, responsePtr, responseSize)
 	if !ok {
 		return nil, fmt.Errorf("failed to read response data from memory")
 	}
@@ -383,6 +662,9 @@ func (wfs *WASMFileSystem) Write(path string, data []byte) ([]byte, error) {
 }
 
 func (wfs *WASMFileSystem) ReadDir(path string) ([]filesystem.FileInfo, error) {
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
 	readDirFunc := wfs.module.ExportedFunction("fs_readdir")
 	if readDirFunc == nil {
 		return nil, fmt.Errorf("fs_readdir not implemented")
@@ -392,6 +674,7 @@ func (wfs *WASMFileSystem) ReadDir(path string) ([]filesystem.FileInfo, error) {
 	if err != nil {
 		return nil, err
 	}
+	defer freeStringMemory(wfs.module, pathPtr)
 
 	results, err := readDirFunc.Call(wfs.ctx, uint64(pathPtr))
 	if err != nil {
@@ -402,37 +685,130 @@ func (wfs *WASMFileSystem) ReadDir(path string) ([]filesystem.FileInfo, error) {
 		return nil, fmt.Errorf("fs_readdir returned invalid results")
 	}
 
-	// Unpack u64: lower 32 bits = json pointer, upper 32 bits = error pointer
+	// Unpack u64: lower 32 bits = result pointer, upper 32 bits = error pointer
 	packed := results[0]
 	jsonPtr := uint32(packed & 0xFFFFFFFF)
 	errPtr := uint32((packed >> 32) & 0xFFFFFFFF)
 
 	// Check for error
 	if errPtr != 0 {
-		if errMsg, ok := readStringFromMemory(wfs.module, errPtr); ok {
-			return nil, fmt.Errorf("%s", errMsg)
-		}
-		return nil, fmt.Errorf("readdir failed")
+		return nil, wfs.resultError(errPtr, "readdir", path)
 	}
 
 	if jsonPtr == 0 {
 		return []filesystem.FileInfo{}, nil
 	}
 
-	jsonStr, ok := readStringFromMemory(wfs.module, jsonPtr)
+	if wfs.abiVersion >= WASMABIBinaryFileInfo {
+		fileInfos, err := readFileInfosFromMemory(wfs.module, jsonPtr)
+		if err != nil {
+			return nil, fmt.Errorf("failed to decode readdir result: %w", err)
+		}
+		return fileInfos, nil
+	}
+
+	jsonStr, ok := takeStringFromMemory(wfs.module, jsonPtr, wfs.abiVersion)
 	if !ok {
 		return nil, fmt.Errorf("failed to read readdir result")
 	}
 
-	var fileInfos []filesystem.FileInfo
-	if err := json.Unmarshal([]byte(jsonStr), &fileInfos); err != nil {
+	fileInfos, err := decodeJSONFileInfos([]byte(jsonStr))
+	if err != nil {
 		return nil, fmt.Errorf("failed to unmarshal readdir result: %w", err)
 	}
 
 	return fileInfos, nil
 }
 
+// ReadDirPage implements filesystem.DirPager through fs_readdir_page
+// Plugins without it (or without the binary ABI) are paged over ReadDir.
+func (wfs *WASMFileSystem) ReadDirPage(path string, cursor string, limit int) ([]filesystem.FileInfo, string, error) {
+	if limit <= 0 {
+		limit = 1
+	}
+	if limit > math.MaxUint32 {
+		limit = math.MaxUint32
+	}
+
+	pageFunc := wfs.optionalExport("fs_readdir_page", WASMCapReadDirPage)
+	if pageFunc == nil || wfs.abiVersion < WASMABIBinaryFileInfo {
+		return readDirPageByOffset(wfs, path, cursor, limit)
+	}
+
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
+	pathPtr, err := writeStringToMemory(wfs.module, path)
+	if err != nil {
+		return nil, "", err
+	}
+	defer freeStringMemory(wfs.module, pathPtr)
+
+	cursorPtr, err := writeStringToMemory(wfs.module, cursor)
+	if err != nil {
+		return nil, "", err
+	}
+	defer freeStringMemory(wfs.module, cursorPtr)
+
+	results, err := pageFunc.Call(wfs.ctx, uint64(pathPtr), uint64(cursorPtr), uint64(limit))
+	if err != nil {
+		return nil, "", fmt.Errorf("fs_readdir_page failed: %w", err)
+	}
+
+	if len(results) < 1 {
+		return nil, "", fmt.Errorf("fs_readdir_page returned invalid results")
+	}
+
+	// Unpack u64: lower 32 bits = page pointer, upper 32 bits = error pointer
+	packed := results[0]
+	pagePtr := uint32(packed & 0xFFFFFFFF)
+	errPtr := uint32((packed >> 32) & 0xFFFFFFFF)
+
+	if errPtr != 0 {
+		return nil, "", wfs.resultError(errPtr, "readdir page", path)
+	}
+
+	if pagePtr == 0 {
+		return []filesystem.FileInfo{}, "", nil
+	}
+
+	fileInfos, next, err := readDirPageFromMemory(wfs.module, pagePtr)
+	if err != nil {
+		return nil, "", fmt.Errorf("failed to decode readdir page: %w", err)
+	}
+	return fileInfos, next, nil
+}
+
+// readDirPageByOffset pages over a full ReadDir with a numeric offset cursor
+func readDirPageByOffset(fs filesystem.FileSystem, path, cursor string, limit int) ([]filesystem.FileInfo, string, error) {
+	offset := 0
+	if cursor != "" {
+		n, err := strconv.Atoi(cursor)
+		if err != nil || n < 0 {
+			return nil, "", fmt.Errorf("invalid readdir cursor %q", cursor)
+		}
+		offset = n
+	}
+
+	entries, err := fs.ReadDir(path)
+	if err != nil {
+		return nil, "", err
+	}
+	if offset >= len(entries) {
+		return []filesystem.FileInfo{}, "", nil
+	}
+
+	end := offset + limit
+	if end >= len(entries) {
+		return entries[offset:], "", nil
+	}
+	return entries[offset:end], strconv.Itoa(end), nil
+}
+
 func (wfs *WASMFileSystem) Stat(path string) (*filesystem.FileInfo, error) {
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
 	log.Debugf("WASM Stat called with path: %s", path)
 	statFunc := wfs.module.ExportedFunction("fs_stat")
 	if statFunc == nil {
@@ -444,6 +820,7 @@ func (wfs *WASMFileSystem) Stat(path string) (*filesystem.FileInfo, error) {
 		log.Errorf("Failed to write path to memory: %v", err)
 		return nil, err
 	}
+	defer freeStringMemory(wfs.module, pathPtr)
 
 	log.Debugf("Calling fs_stat WASM function with pathPtr=%d", pathPtr)
 	results, err := statFunc.Call(wfs.ctx, uint64(pathPtr))
@@ -457,51 +834,64 @@ func (wfs *WASMFileSystem) Stat(path string) (*filesystem.FileInfo, error) {
 		return nil, fmt.Errorf("fs_stat returned invalid results")
 	}
 
-	// Unpack u64: lower 32 bits = json pointer, upper 32 bits = error pointer
+	// Unpack u64: lower 32 bits = result pointer, upper 32 bits = error pointer
 	packed := results[0]
 	jsonPtr := uint32(packed & 0xFFFFFFFF)
 	errPtr := uint32((packed >> 32) & 0xFFFFFFFF)
 
 	// Check for error
 	if errPtr != 0 {
-		if errMsg, ok := readStringFromMemory(wfs.module, errPtr); ok {
-			return nil, fmt.Errorf("%s", errMsg)
-		}
-		return nil, fmt.Errorf("stat failed")
+		return nil, wfs.resultError(errPtr, "stat", path)
 	}
 
 	if jsonPtr == 0 {
 		return nil, fmt.Errorf("stat returned null")
 	}
 
-	jsonStr, ok := readStringFromMemory(wfs.module, jsonPtr)
+	if wfs.abiVersion >= WASMABIBinaryFileInfo {
+		fileInfos, err := readFileInfosFromMemory(wfs.module, jsonPtr)
+		if err != nil {
+			return nil, fmt.Errorf("failed to decode stat result: %w", err)
+		}
+		if len(fileInfos) != 1 {
+			return nil, fmt.Errorf("stat returned %d entries", len(fileInfos))
+		}
+		return &fileInfos[0], nil
+	}
+
+	jsonStr, ok := takeStringFromMemory(wfs.module, jsonPtr, wfs.abiVersion)
 	if !ok {
 		return nil, fmt.Errorf("failed to read stat result")
 	}
 
-	var fileInfo filesystem.FileInfo
-	if err := json.Unmarshal([]byte(jsonStr), &fileInfo); err != nil {
+	fileInfo, err := decodeJSONFileInfo([]byte(jsonStr))
+	if err != nil {
 		return nil, fmt.Errorf("failed to unmarshal stat result: %w", err)
 	}
 
-	return &fileInfo, nil
+	return fileInfo, nil
 }
 
 func (wfs *WASMFileSystem) Rename(oldPath, newPath string) error {
-	renameFunc := wfs.module.ExportedFunction("fs_rename")
+	renameFunc := wfs.optionalExport("fs_rename", WASMCapRename)
 	if renameFunc == nil {
 		return fmt.Errorf("fs_rename not implemented")
 	}
 
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
 	oldPathPtr, err := writeStringToMemory(wfs.module, oldPath)
 	if err != nil {
 		return err
 	}
+	defer freeStringMemory(wfs.module, oldPathPtr)
 
 	newPathPtr, err := writeStringToMemory(wfs.module, newPath)
 	if err != nil {
 		return err
 	}
+	defer freeStringMemory(wfs.module, newPathPtr)
 
 	results, err := renameFunc.Call(wfs.ctx, uint64(oldPathPtr), uint64(newPathPtr))
 	if err != nil {
@@ -509,26 +899,74 @@ func (wfs *WASMFileSystem) Rename(oldPath, newPath string) error {
 	}
 
 	if len(results) > 0 && results[0] != 0 {
-		if errMsg, ok := readStringFromMemory(wfs.module, uint32(results[0])); ok {
-			return fmt.Errorf("%s", errMsg)
-		}
-		return fmt.Errorf("rename failed")
+		return wfs.resultError(uint32(results[0]), "rename", oldPath)
 	}
 
 	return nil
 }
 
+// Copy implements filesystem.Copier through fs_copy. Plugins without it, or
+// that report the copy unsupported, are copied by streaming.
+func (wfs *WASMFileSystem) Copy(src, dst string, offset, size int64) (int64, error) {
+	copyFunc := wfs.optionalExport("fs_copy", WASMCapCopy)
+	if copyFunc == nil {
+		return filesystem.CopyStream(wfs, src, dst, offset, size)
+	}
+
+	n, err := wfs.copy(copyFunc, src, dst, offset, size)
+	var wasmErr *WASMError
+	if errors.As(err, &wasmErr) && wasmErr.Kind == WASMErrorUnsupported {
+		return filesystem.CopyStream(wfs, src, dst, offset, size)
+	}
+	return n, err
+}
+
+func (wfs *WASMFileSystem) copy(copyFunc wazeroapi.Function, src, dst string, offset, size int64) (int64, error) {
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
+	srcPtr, err := writeStringToMemory(wfs.module, src)
+	if err != nil {
+		return 0, err
+	}
+	defer freeStringMemory(wfs.module, srcPtr)
+
+	dstPtr, err := writeStringToMemory(wfs.module, dst)
+	if err != nil {
+		return 0, err
+	}
+	defer freeStringMemory(wfs.module, dstPtr)
+
+	results, err := copyFunc.Call(wfs.ctx, uint64(srcPtr), uint64(dstPtr), uint64(offset), uint64(size))
+	if err != nil {
+		return 0, fmt.Errorf("fs_copy failed: %w", err)
+	}
+	if len(results) == 0 {
+		return 0, fmt.Errorf("fs_copy returned no results")
+	}
+
+	n := int64(results[0])
+	if n < 0 {
+		return 0, wfs.countError(n, "copy", src)
+	}
+	return n, nil
+}
+
 func (wfs *WASMFileSystem) Chmod(path string, mode uint32) error {
-	chmodFunc := wfs.module.ExportedFunction("fs_chmod")
+	chmodFunc := wfs.optionalExport("fs_chmod", WASMCapChmod)
 	if chmodFunc == nil {
 		// Chmod is optional, silently ignore if not implemented
 		return nil
 	}
 
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
 	pathPtr, err := writeStringToMemory(wfs.module, path)
 	if err != nil {
 		return err
 	}
+	defer freeStringMemory(wfs.module, pathPtr)
 
 	results, err := chmodFunc.Call(wfs.ctx, uint64(pathPtr), uint64(mode))
 	if err != nil {
@@ -536,19 +974,25 @@ func (wfs *WASMFileSystem) Chmod(path string, mode uint32) error {
 	}
 
 	if len(results) > 0 && results[0] != 0 {
-		if errMsg, ok := readStringFromMemory(wfs.module, uint32(results[0])); ok {
-			return fmt.Errorf("%s", errMsg)
-		}
-		return fmt.Errorf("chmod failed")
+		return wfs.resultError(uint32(results[0]), "chmod", path)
 	}
 
 	return nil
 }
 
 func (wfs *WASMFileSystem) Open(path string) (io.ReadCloser, error) {
-	// For WASM plugins, we can implement Open by reading the entire file
-	// This is a simple implementation; more sophisticated implementations
-	// could use streaming or chunked reads
+	// Stream through fs_open/fs_read_chunk when the plugin supports it
+	wfs.mu.Lock()
+	stream, err := wfs.openStream(path, wasmOpenRead)
+	wfs.mu.Unlock()
+	if err != nil {
+		return nil, err
+	}
+	if stream != nil {
+		return stream, nil
+	}
+
+	// Otherwise fall back to reading the entire file
 	data, err := wfs.Read(path, 0, -1)
 	if err != nil {
 		return nil, err
@@ -557,7 +1001,22 @@ func (wfs *WASMFileSystem) Open(path string) (io.ReadCloser, error) {
 }
 
 func (wfs *WASMFileSystem) OpenWrite(path string) (io.WriteCloser, error) {
-	// For WASM plugins, we return a WriteCloser that buffers writes
+	if wfs.capabilities&(WASMCapStreaming|WASMCapWrite) == 0 {
+		return nil, fmt.Errorf("fs_write not implemented")
+	}
+
+	// Stream through fs_open/fs_write_chunk when the plugin supports it
+	wfs.mu.Lock()
+	stream, err := wfs.openStream(path, wasmOpenWrite)
+	wfs.mu.Unlock()
+	if err != nil {
+		return nil, err
+	}
+	if stream != nil {
+		return stream, nil
+	}
+
+	// Otherwise return a WriteCloser that buffers writes
 	// and flushes on close
 	return &wasmWriteCloser{
 		fs:   wfs,
@@ -584,9 +1043,192 @@ func (w *wasmWriteCloser) Close() error {
 	return err
 }
 
+// wasmStreamChunkSize bounds the linear memory a streaming handle uses
+const wasmStreamChunkSize = 64 * 1024
+
+// wasmStream moves a file through the plugin's fs_read_chunk/fs_write_chunk
+// exports one chunk at a time, using a single buffer in linear memory.
+// A stream stays on the instance that opened it.
+type wasmStream struct {
+	fs     *WASMFileSystem
+	handle int64
+	bufPtr uint32
+	closed bool
+}
+
+// openStream opens path through fs_open. It returns a nil stream without error
+// when the plugin does not export fs_open or reports it as unsupported.
+func (wfs *WASMFileSystem) openStream(path string, flags uint32) (*wasmStream, error) {
+	openFunc := wfs.optionalExport("fs_open", WASMCapStreaming)
+	if openFunc == nil {
+		return nil, nil
+	}
+
+	pathPtr, err := writeStringToMemory(wfs.module, path)
+	if err != nil {
+		return nil, err
+	}
+	defer freeStringMemory(wfs.module, pathPtr)
+
+	results, err := openFunc.Call(wfs.ctx, uint64(pathPtr), uint64(flags))
+	if err != nil {
+		return nil, fmt.Errorf("fs_open failed: %w", err)
+	}
+
+	if len(results) < 1 {
+		return nil, fmt.Errorf("fs_open returned invalid results")
+	}
+
+	handle := int64(results[0])
+	if handle == 0 {
+		return nil, nil
+	}
+	if handle < 0 {
+		return nil, wfs.countError(handle, "open", path)
+	}
+
+	bufPtr, err := allocMemory(wfs.module, "malloc", wasmStreamChunkSize)
+	if err != nil {
+		wfs.closeHandle(handle)
+		return nil, err
+	}
+
+	return &wasmStream{fs: wfs, handle: handle, bufPtr: bufPtr}, nil
+}
+
+func (s *wasmStream) Read(p []byte) (int, error) {
+	if s.closed {
+		return 0, fmt.Errorf("read on closed stream")
+	}
+	if len(p) == 0 {
+		return 0, nil
+	}
+
+	s.fs.mu.Lock()
+	defer s.fs.mu.Unlock()
+
+	readChunkFunc := s.fs.module.ExportedFunction("fs_read_chunk")
+	if readChunkFunc == nil {
+		return 0, fmt.Errorf("fs_read_chunk not implemented")
+	}
+
+	size := uint32(wasmStreamChunkSize)
+	if len(p) < wasmStreamChunkSize {
+		size = uint32(len(p))
+	}
+
+	results, err := readChunkFunc.Call(s.fs.ctx, uint64(s.handle), uint64(s.bufPtr), uint64(size))
+	if err != nil {
+		return 0, fmt.Errorf("fs_read_chunk failed: %w", err)
+	}
+
+	if len(results) < 1 {
+		return 0, fmt.Errorf("fs_read_chunk returned invalid results")
+	}
+
+	n := int64(results[0])
+	if n < 0 {
+		return 0, s.fs.countError(n, "read", "")
+	}
+	if n == 0 {
+		return 0, io.EOF
+	}
+	if n > int64(size) {
+		return 0, fmt.Errorf("fs_read_chunk overran its buffer")
+	}
+
+	chunk, ok := s.fs.module.Memory().Read(s.bufPtr, uint32(n))
+	if !ok {
+		return 0, fmt.Errorf("failed to read data from memory")
+	}
+
+	return copy(p, chunk), nil
+}
+
+func (s *wasmStream) Write(p []byte) (int, error) {
+	if s.closed {
+		return 0, fmt.Errorf("write on closed stream")
+	}
+
+	s.fs.mu.Lock()
+	defer s.fs.mu.Unlock()
+
+	writeChunkFunc := s.fs.module.ExportedFunction("fs_write_chunk")
+	if writeChunkFunc == nil {
+		return 0, fmt.Errorf("fs_write_chunk not implemented")
+	}
+
+	written := 0
+	for written < len(p) {
+		chunk := p[written:]
+		if len(chunk) > wasmStreamChunkSize {
+			chunk = chunk[:wasmStreamChunkSize]
+		}
+
+		if !s.fs.module.Memory().Write(s.bufPtr, chunk) {
+			return written, fmt.Errorf("failed to write data to memory")
+		}
+
+		results, err := writeChunkFunc.Call(s.fs.ctx, uint64(s.handle), uint64(s.bufPtr), uint64(len(chunk)))
+		if err != nil {
+			return written, fmt.Errorf("fs_write_chunk failed: %w", err)
+		}
+
+		if len(results) < 1 {
+			return written, fmt.Errorf("fs_write_chunk returned invalid results")
+		}
+
+		n := int64(results[0])
+		if n < 0 {
+			return written, s.fs.countError(n, "write", "")
+		}
+		if n == 0 || n > int64(len(chunk)) {
+			return written, fmt.Errorf("write failed")
+		}
+		written += int(n)
+	}
+
+	return written, nil
+}
+
+func (s *wasmStream) Close() error {
+	if s.closed {
+		return nil
+	}
+	s.closed = true
+
+	s.fs.mu.Lock()
+	defer s.fs.mu.Unlock()
+
+	freeMemory(s.fs.module, s.bufPtr)
+	return s.fs.closeHandle(s.handle)
+}
+
+// closeHandle releases a streaming handle through fs_close
+func (wfs *WASMFileSystem) closeHandle(handle int64) error {
+	closeFunc := wfs.module.ExportedFunction("fs_close")
+	if closeFunc == nil {
+		return fmt.Errorf("fs_close not implemented")
+	}
+
+	results, err := closeFunc.Call(wfs.ctx, uint64(handle))
+	if err != nil {
+		return fmt.Errorf("fs_close failed: %w", err)
+	}
+
+	if len(results) > 0 && results[0] != 0 {
+		return wfs.resultError(uint32(results[0]), "close", "")
+	}
+
+	return nil
+}
+
 // Helper functions for memory management
 
-func readStringFromMemory(module wazeroapi.Module, ptr uint32) (string, bool) {
+// readStringFromMemory reads a string the plugin handed to the host. From
+// WASMABIStringLength on, its length sits in the four bytes before ptr;
+// older plugins only NUL-terminate it.
+func readStringFromMemory(module wazeroapi.Module, ptr uint32, version uint32) (string, bool) {
 	if ptr == 0 {
 		return "", false
 	}
@@ -596,91 +1238,177 @@ func readStringFromMemory(module wazeroapi.Module, ptr uint32) (string, bool) {
 		return "", false
 	}
 
-	// Read until null terminator
-	var length uint32
-	for {
-		b, ok := mem.ReadByte(ptr + length)
+	if version >= WASMABIStringLength {
+		if ptr < 4 {
+			return "", false
+		}
+		length, ok := mem.ReadUint32Le(ptr - 4)
 		if !ok {
 			return "", false
 		}
-		if b == 0 {
-			break
+		data, ok := mem.Read(ptr, length)
+		if !ok {
+			return "", false
 		}
-		length++
+		return string(data), true
 	}
 
-	if length == 0 {
-		return "", true
+	// Find the NUL terminator in a view of the rest of memory
+	rest, ok := mem.Read(ptr, mem.Size()-ptr)
+	if !ok {
+		return "", false
 	}
+	length := bytes.IndexByte(rest, 0)
+	if length < 0 {
+		return "", false
+	}
+	return string(rest[:length]), true
+}
 
-	data, ok := mem.Read(ptr, length)
+// takeStringFromMemory reads a string the plugin handed to the host and
+// releases the buffer back to the plugin
+func takeStringFromMemory(module wazeroapi.Module, ptr uint32, version uint32) (string, bool) {
+	s, ok := readStringFromMemory(module, ptr, version)
+	freeMemory(module, ptr)
+	return s, ok
+}
+
+// takeBytesFromMemory copies a buffer the plugin handed to the host out of
+// linear memory and releases it back to the plugin. Memory().Read returns a
+// view into linear memory, so the data must be copied before the plugin is
+// allowed to reuse it.
+func takeBytesFromMemory(module wazeroapi.Module, ptr, size uint32) ([]byte, bool) {
+	data, ok := readBytesFromMemory(module, ptr, size)
+	freeMemory(module, ptr)
+	return data, ok
+}
+
+// readBytesFromMemory copies size bytes at ptr out of linear memory
+func readBytesFromMemory(module wazeroapi.Module, ptr, size uint32) ([]byte, bool) {
+	view, ok := module.Memory().Read(ptr, size)
 	if !ok {
-		return "", false
+		return nil, false
 	}
+	data := make([]byte, len(view))
+	copy(data, view)
+	return data, true
+}
 
-	return string(data), true
+// freeMemory releases a buffer in the plugin's linear memory through the
+// plugin_free_result export. This covers both results returned by the plugin
+// and arguments the host allocated with malloc. Modules that do not export
+// plugin_free_result keep the legacy behavior and never get buffers back.
+func freeMemory(module wazeroapi.Module, ptr uint32) {
+	if ptr == 0 {
+		return
+	}
+	freeFunc := module.ExportedFunction("plugin_free_result")
+	if freeFunc == nil {
+		return
+	}
+	if _, err := freeFunc.Call(context.Background(), uint64(ptr)); err != nil {
+		log.Warnf("plugin_free_result failed: %v", err)
+	}
 }
 
+// writeStringToMemory copies s into a malloc'd buffer laid out as u32 length,
+// bytes, NUL and returns a pointer to the bytes, so plugins can read it either
+// way. Release it with freeStringMemory.
 func writeStringToMemory(module wazeroapi.Module, s string) (uint32, error) {
-	// Allocate memory in WASM module
-	allocFunc := module.ExportedFunction("malloc")
-	if allocFunc == nil {
-		return 0, fmt.Errorf("malloc function not found in WASM module")
+	ptr, err := writeToMemory(module, "malloc", lengthPrefixed(s))
+	if err != nil {
+		return 0, err
 	}
+	return ptr + 4, nil
+}
 
-	size := uint32(len(s) + 1) // +1 for null terminator
-	results, err := allocFunc.Call(context.Background(), uint64(size))
+// freeStringMemory releases a buffer written by writeStringToMemory
+func freeStringMemory(module wazeroapi.Module, ptr uint32) {
+	if ptr != 0 {
+		freeMemory(module, ptr-4)
+	}
+}
+
+// lengthPrefixed lays s out as u32 length, bytes, NUL
+func lengthPrefixed(s string) []byte {
+	buf := make([]byte, 4+len(s)+1)
+	binary.LittleEndian.PutUint32(buf, uint32(len(s)))
+	copy(buf[4:], s)
+	return buf
+}
+
+func writeBytesToMemory(module wazeroapi.Module, data []byte) (uint32, error) {
+	return writeToMemory(module, "malloc", data)
+}
+
+// writeScratchStringToMemory writes a string into the plugin's per-call scratch
+// arena when it exports plugin_scratch_alloc, and falls back to malloc otherwise.
+// Scratch buffers are only valid until the export currently running returns, so
+// this is meant for results returned from host functions.
+//
+// From WASMABIStringLength on the string carries its length, like
+// writeStringToMemory; older plugins get a plain NUL-terminated string.
+func writeScratchStringToMemory(module wazeroapi.Module, s string, version uint32) (uint32, error) {
+	if version < WASMABIStringLength {
+		return writeToMemory(module, scratchAllocator(module), append([]byte(s), 0))
+	}
+	ptr, err := writeToMemory(module, scratchAllocator(module), lengthPrefixed(s))
 	if err != nil {
-		return 0, fmt.Errorf("malloc failed: %w", err)
+		return 0, err
 	}
+	return ptr + 4, nil
+}
 
-	if len(results) == 0 {
-		return 0, fmt.Errorf("malloc returned no results")
+// writeScratchBytesToMemory is the byte-slice variant of writeScratchStringToMemory
+func writeScratchBytesToMemory(module wazeroapi.Module, data []byte) (uint32, error) {
+	return writeToMemory(module, scratchAllocator(module), data)
+}
+
+func scratchAllocator(module wazeroapi.Module) string {
+	if module.ExportedFunction("plugin_scratch_alloc") != nil {
+		return "plugin_scratch_alloc"
 	}
+	return "malloc"
+}
 
-	ptr := uint32(results[0])
-	if ptr == 0 {
-		return 0, fmt.Errorf("malloc returned null pointer")
+// writeToMemory allocates len(data) bytes with the named allocator export and
+// copies data into them
+func writeToMemory(module wazeroapi.Module, allocName string, data []byte) (uint32, error) {
+	ptr, err := allocMemory(module, allocName, uint32(len(data)))
+	if err != nil {
+		return 0, err
 	}
 
-	// Write string to memory
+	// Write data to memory
 	mem := module.Memory()
-	data := append([]byte(s), 0) // Add null terminator
 	if !mem.Write(ptr, data) {
-		return 0, fmt.Errorf("failed to write string to memory")
+		return 0, fmt.Errorf("failed to write data to memory")
 	}
 
 	return ptr, nil
 }
 
-func writeBytesToMemory(module wazeroapi.Module, data []byte) (uint32, error) {
+// allocMemory allocates size bytes with the named allocator export
+func allocMemory(module wazeroapi.Module, allocName string, size uint32) (uint32, error) {
 	// Allocate memory in WASM module
-	allocFunc := module.ExportedFunction("malloc")
+	allocFunc := module.ExportedFunction(allocName)
 	if allocFunc == nil {
-		return 0, fmt.Errorf("malloc function not found in WASM module")
+		return 0, fmt.Errorf("%s function not found in WASM module", allocName)
 	}
 
-	size := uint32(len(data))
 	results, err := allocFunc.Call(context.Background(), uint64(size))
 	if err != nil {
-		return 0, fmt.Errorf("malloc failed: %w", err)
+		return 0, fmt.Errorf("%s failed: %w", allocName, err)
 	}
 
 	if len(results) == 0 {
-		return 0, fmt.Errorf("malloc returned no results")
+		return 0, fmt.Errorf("%s returned no results", allocName)
 	}
 
 	ptr := uint32(results[0])
 	if ptr == 0 {
-		return 0, fmt.Errorf("malloc returned null pointer")
-	}
-
-	// Write data to memory
-	mem := module.Memory()
-	if !mem.Write(ptr, data) {
-		return 0, fmt.Errorf("failed to write bytes to memory")
+		return 0, fmt.Errorf("%s returned null pointer", allocName)
 	}
 
 	return ptr, nil
 }
-
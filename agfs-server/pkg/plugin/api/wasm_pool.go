@@ -0,0 +1,175 @@
+package api
+
+import (
+	"context"
+	"io"
+	"sync/atomic"
+
+	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
+	wazeroapi "github.com/tetratelabs/wazero/api"
+)
+
+// Concurrency modes reported by the plugin_concurrency export.
+// Plugins that do not export it are WASMConcurrencyExclusive.
+const (
+	// WASMConcurrencyExclusive plugins keep state in their module instance,
+	// so all calls go to a single instance one at a time
+	WASMConcurrencyExclusive uint32 = 0
+	// WASMConcurrencyStateless plugins keep no state beyond their configuration
+	WASMConcurrencyStateless uint32 = 1
+	// WASMConcurrencySharedHost plugins keep their mutable state on the host,
+	// so every instance sees the same data
+	WASMConcurrencySharedHost uint32 = 2
+)
+
+// queryConcurrency asks the plugin how its module may be instantiated
+func queryConcurrency(ctx context.Context, module wazeroapi.Module) uint32 {
+	concurrencyFunc := module.ExportedFunction("plugin_concurrency")
+	if concurrencyFunc == nil {
+		return WASMConcurrencyExclusive
+	}
+
+	results, err := concurrencyFunc.Call(ctx)
+	if err != nil || len(results) == 0 {
+		return WASMConcurrencyExclusive
+	}
+
+	switch mode := uint32(results[0]); mode {
+	case WASMConcurrencyStateless, WASMConcurrencySharedHost:
+		return mode
+	default:
+		return WASMConcurrencyExclusive
+	}
+}
+
+// wasmPool implements filesystem.FileSystem over several instances of one
+// module, sending each call to the least busy instance. Each instance still
+// runs one call at a time.
+type wasmPool struct {
+	instances []*pooledInstance
+	next      atomic.Uint32
+}
+
+type pooledInstance struct {
+	fs   *WASMFileSystem
+	busy atomic.Int32
+}
+
+func newWASMPool(instances []*WASMFileSystem) *wasmPool {
+	p := &wasmPool{instances: make([]*pooledInstance, len(instances))}
+	for i, fs := range instances {
+		p.instances[i] = &pooledInstance{fs: fs}
+	}
+	return p
+}
+
+// acquire picks an instance, starting the scan at a rotating offset so ties
+// are spread out; release must be called when the call returns
+func (p *wasmPool) acquire() *pooledInstance {
+	n := uint32(len(p.instances))
+	start := p.next.Add(1) % n
+	best := p.instances[start]
+	for i := uint32(1); i < n && best.busy.Load() > 0; i++ {
+		inst := p.instances[(start+i)%n]
+		if inst.busy.Load() < best.busy.Load() {
+			best = inst
+		}
+	}
+	best.busy.Add(1)
+	return best
+}
+
+func (p *wasmPool) release(inst *pooledInstance) {
+	inst.busy.Add(-1)
+}
+
+func (p *wasmPool) Create(path string) error {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Create(path)
+}
+
+func (p *wasmPool) Mkdir(path string, perm uint32) error {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Mkdir(path, perm)
+}
+
+func (p *wasmPool) Remove(path string) error {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Remove(path)
+}
+
+func (p *wasmPool) RemoveAll(path string) error {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.RemoveAll(path)
+}
+
+func (p *wasmPool) Read(path string, offset int64, size int64) ([]byte, error) {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Read(path, offset, size)
+}
+
+func (p *wasmPool) Write(path string, data []byte) ([]byte, error) {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Write(path, data)
+}
+
+func (p *wasmPool) ReadDir(path string) ([]filesystem.FileInfo, error) {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.ReadDir(path)
+}
+
+// ReadDirPage implements filesystem.DirPager. Cursors must not depend on
+// instance state, which holds for pool-safe plugins.
+func (p *wasmPool) ReadDirPage(path string, cursor string, limit int) ([]filesystem.FileInfo, string, error) {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.ReadDirPage(path, cursor, limit)
+}
+
+func (p *wasmPool) Stat(path string) (*filesystem.FileInfo, error) {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Stat(path)
+}
+
+func (p *wasmPool) Rename(oldPath, newPath string) error {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Rename(oldPath, newPath)
+}
+
+// Copy implements filesystem.Copier; a streamed fallback stays on the one
+// instance, like Open
+func (p *wasmPool) Copy(src, dst string, offset, size int64) (int64, error) {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Copy(src, dst, offset, size)
+}
+
+func (p *wasmPool) Chmod(path string, mode uint32) error {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Chmod(path, mode)
+}
+
+// Open returns a reader bound to one instance; streaming handles live in that
+// instance's memory, so every chunk goes back to it
+func (p *wasmPool) Open(path string) (io.ReadCloser, error) {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.Open(path)
+}
+
+// OpenWrite returns a writer bound to one instance, like Open
+func (p *wasmPool) OpenWrite(path string) (io.WriteCloser, error) {
+	inst := p.acquire()
+	defer p.release(inst)
+	return inst.fs.OpenWrite(path)
+}
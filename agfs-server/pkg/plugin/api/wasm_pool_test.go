@@ -0,0 +1,157 @@
+package api
+
+import (
+	"context"
+	"errors"
+	"sync"
+	"testing"
+)
+
+// newTestPlugin is a module whose plugin_new succeeds and whose
+// plugin_concurrency, when mode is not nil, reports *mode
+func newTestPlugin(mode *uint64) *testModule {
+	mod := newTestModule()
+	mod.export("plugin_new", 1)
+	if mode != nil {
+		mod.export("plugin_concurrency", *mode)
+	}
+	return mod
+}
+
+func TestConcurrencyModes(t *testing.T) {
+	mode := func(v uint64) *uint64 { return &v }
+	tests := []struct {
+		name     string
+		mode     *uint64
+		failing  bool // plugin_concurrency traps
+		want     uint32
+		poolable bool
+	}{
+		{"no export", nil, false, WASMConcurrencyExclusive, false},
+		{"exclusive", mode(0), false, WASMConcurrencyExclusive, false},
+		{"stateless", mode(1), false, WASMConcurrencyStateless, true},
+		{"shared host state", mode(2), false, WASMConcurrencySharedHost, true},
+		{"unknown mode", mode(7), false, WASMConcurrencyExclusive, false},
+		{"trap", nil, true, WASMConcurrencyExclusive, false},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			newModule := func() *testModule {
+				mod := newTestPlugin(tt.mode)
+				if tt.failing {
+					mod.exports["plugin_concurrency"] = &testFunc{fn: func([]uint64) ([]uint64, error) {
+						return nil, errors.New("unreachable")
+					}}
+				}
+				return mod
+			}
+
+			mod := newModule()
+			if got := queryConcurrency(context.Background(), mod); got != tt.want {
+				t.Errorf("queryConcurrency = %d, want %d", got, tt.want)
+			}
+			wp, err := NewWASMPlugin(context.Background(), mod)
+			if err != nil {
+				t.Fatalf("NewWASMPlugin: %v", err)
+			}
+			if wp.Poolable() != tt.poolable {
+				t.Errorf("Poolable = %v, want %v", wp.Poolable(), tt.poolable)
+			}
+
+			err = wp.AddInstance(newModule())
+			if tt.poolable {
+				if err != nil {
+					t.Fatalf("AddInstance: %v", err)
+				}
+				if wp.InstanceCount() != 2 || wp.pool == nil || len(wp.pool.instances) != 2 {
+					t.Errorf("%d instances, pool %v", wp.InstanceCount(), wp.pool)
+				}
+			} else if err == nil || wp.InstanceCount() != 1 || wp.pool != nil {
+				t.Errorf("AddInstance on an exclusive plugin: err %v, %d instances", err, wp.InstanceCount())
+			}
+		})
+	}
+}
+
+func newTestPool(n int) *wasmPool {
+	instances := make([]*WASMFileSystem, n)
+	for i := range instances {
+		instances[i] = &WASMFileSystem{}
+	}
+	return newWASMPool(instances)
+}
+
+func poolBusy(p *wasmPool) []int32 {
+	busy := make([]int32, len(p.instances))
+	for i, inst := range p.instances {
+		busy[i] = inst.busy.Load()
+	}
+	return busy
+}
+
+func TestPoolCheckout(t *testing.T) {
+	for _, n := range []int{1, 2, 4} {
+		p := newTestPool(n)
+
+		// Every instance is checked out once before any is checked out twice
+		var held []*pooledInstance
+		seen := map[*pooledInstance]bool{}
+		for i := 0; i < n; i++ {
+			inst := p.acquire()
+			if seen[inst] {
+				t.Fatalf("%d instances: instance checked out twice while %v", n, poolBusy(p))
+			}
+			seen[inst] = true
+			held = append(held, inst)
+		}
+		extra := p.acquire()
+		if extra.busy.Load() != 2 {
+			t.Errorf("%d instances: extra checkout busy = %d, want 2", n, extra.busy.Load())
+		}
+		held = append(held, extra)
+
+		// An instance that is returned idle is the one the next call gets
+		if n > 1 {
+			idle := held[0]
+			if idle == extra {
+				idle = held[1]
+			}
+			p.release(idle)
+			if got := p.acquire(); got != idle {
+				t.Errorf("%d instances: checkout after return got a busy instance: %v", n, poolBusy(p))
+			}
+		}
+		for _, inst := range held {
+			p.release(inst)
+		}
+		for i, busy := range poolBusy(p) {
+			if busy != 0 {
+				t.Errorf("%d instances: instance %d busy = %d after every return", n, i, busy)
+			}
+		}
+	}
+}
+
+func TestPoolConcurrentCheckout(t *testing.T) {
+	p := newTestPool(3)
+	var wg sync.WaitGroup
+	for g := 0; g < 8; g++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for i := 0; i < 1000; i++ {
+				inst := p.acquire()
+				if inst.busy.Load() < 1 {
+					t.Error("checked out instance is not busy")
+				}
+				p.release(inst)
+			}
+		}()
+	}
+	wg.Wait()
+	for i, busy := range poolBusy(p) {
+		if busy != 0 {
+			t.Errorf("instance %d busy = %d after every return", i, busy)
+		}
+	}
+}
@@ -0,0 +1,161 @@
+package api
+
+import (
+	"crypto/sha256"
+	"encoding/hex"
+	"fmt"
+	"os"
+	"path/filepath"
+
+	log "github.com/sirupsen/logrus"
+)
+
+// Startup snapshots let a plugin skip expensive initialization. A plugin with
+// WASMCapSnapshot exports plugin_snapshot, which serializes the state its
+// initialize built, and plugin_restore, which rebuilds that state from the
+// bytes. Initialize restores pooled instances from the first one's
+// snapshot, and with SetSnapshotDir the snapshot is kept on disk for later
+// loads of the same module with the same config.
+
+// SetSnapshotDir makes Initialize keep snapshots in dir. moduleKey identifies
+// the module's code (callers pass a hash of the wasm binary) so a rebuilt
+// plugin never restores a snapshot taken by another build.
+func (wp *WASMPlugin) SetSnapshotDir(dir, moduleKey string) {
+	wp.snapshotDir = dir
+	wp.moduleKey = moduleKey
+}
+
+// snapshotPath is where the snapshot for configJSON lives, or "" without a
+// snapshot directory. encoding/json sorts map keys, so equal configs give
+// equal paths.
+func (wp *WASMPlugin) snapshotPath(configJSON []byte) string {
+	if wp.snapshotDir == "" {
+		return ""
+	}
+	h := sha256.New()
+	h.Write([]byte(wp.moduleKey))
+	h.Write([]byte{0})
+	h.Write(configJSON)
+	return filepath.Join(wp.snapshotDir, hex.EncodeToString(h.Sum(nil))+".snap")
+}
+
+// loadSnapshot returns the stored snapshot for configJSON, if any
+func (wp *WASMPlugin) loadSnapshot(configJSON []byte) []byte {
+	path := wp.snapshotPath(configJSON)
+	if path == "" {
+		return nil
+	}
+	data, err := os.ReadFile(path)
+	if err != nil {
+		if !os.IsNotExist(err) {
+			log.Warnf("Failed to read snapshot of WASM plugin %s: %v", wp.name, err)
+		}
+		return nil
+	}
+	return data
+}
+
+// storeSnapshot writes data for configJSON, replacing the file atomically so
+// a concurrent load never sees half a snapshot
+func (wp *WASMPlugin) storeSnapshot(configJSON, data []byte) {
+	path := wp.snapshotPath(configJSON)
+	if path == "" {
+		return
+	}
+	if err := writeFileAtomic(path, data); err != nil {
+		log.Warnf("Failed to store snapshot of WASM plugin %s: %v", wp.name, err)
+		return
+	}
+	log.Debugf("Stored %d-byte snapshot of WASM plugin %s at %s", len(data), wp.name, path)
+}
+
+func writeFileAtomic(path string, data []byte) error {
+	if err := os.MkdirAll(filepath.Dir(path), 0755); err != nil {
+		return err
+	}
+	tmp, err := os.CreateTemp(filepath.Dir(path), ".snap-*")
+	if err != nil {
+		return err
+	}
+	defer os.Remove(tmp.Name())
+	if _, err := tmp.Write(data); err != nil {
+		tmp.Close()
+		return err
+	}
+	if err := tmp.Close(); err != nil {
+		return err
+	}
+	return os.Rename(tmp.Name(), path)
+}
+
+// snapshot asks the instance to serialize its initialized state. ok is false
+// if the plugin cannot snapshot or produced nothing.
+func (wfs *WASMFileSystem) snapshot() (data []byte, ok bool, err error) {
+	snapshotFunc := wfs.optionalExport("plugin_snapshot", WASMCapSnapshot)
+	if snapshotFunc == nil {
+		return nil, false, nil
+	}
+
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
+	results, err := snapshotFunc.Call(wfs.ctx)
+	if err != nil {
+		return nil, false, fmt.Errorf("plugin_snapshot failed: %w", err)
+	}
+	if len(results) < 1 {
+		return nil, false, fmt.Errorf("plugin_snapshot returned invalid results")
+	}
+
+	// Unpack u64: lower 32 bits = pointer, upper 32 bits = size
+	ptr := uint32(results[0] & 0xFFFFFFFF)
+	size := uint32((results[0] >> 32) & 0xFFFFFFFF)
+	if ptr == 0 {
+		if size != 0 {
+			return nil, false, wfs.bufferError(size, "snapshot", "")
+		}
+		return nil, false, nil
+	}
+
+	data, ok = takeBytesFromMemory(wfs.module, ptr, size)
+	if !ok {
+		return nil, false, fmt.Errorf("failed to read snapshot from memory")
+	}
+	return data, true, nil
+}
+
+// restore rebuilds the instance's state from a snapshot taken under the same
+// config, in place of initialize
+func (wfs *WASMFileSystem) restore(configJSON, data []byte) error {
+	restoreFunc := wfs.optionalExport("plugin_restore", WASMCapSnapshot)
+	if restoreFunc == nil {
+		return fmt.Errorf("plugin_restore not implemented")
+	}
+
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
+	configPtr, err := writeStringToMemory(wfs.module, string(configJSON))
+	if err != nil {
+		return fmt.Errorf("failed to write config to memory: %w", err)
+	}
+	defer freeStringMemory(wfs.module, configPtr)
+
+	dataPtr, err := writeBytesToMemory(wfs.module, data)
+	if err != nil {
+		return fmt.Errorf("failed to write snapshot to memory: %w", err)
+	}
+	defer freeMemory(wfs.module, dataPtr)
+
+	results, err := restoreFunc.Call(wfs.ctx, uint64(configPtr), uint64(dataPtr), uint64(len(data)))
+	if err != nil {
+		return fmt.Errorf("restore call failed: %w", err)
+	}
+	if len(results) > 0 && results[0] != 0 {
+		if errMsg, ok := takeStringFromMemory(wfs.module, uint32(results[0]), wfs.abiVersion); ok {
+			return fmt.Errorf("restore failed: %s", errMsg)
+		}
+		return fmt.Errorf("restore failed")
+	}
+	return nil
+}
@@ -0,0 +1,111 @@
+package api
+
+import (
+	"fmt"
+	"time"
+
+	log "github.com/sirupsen/logrus"
+	wazeroapi "github.com/tetratelabs/wazero/api"
+)
+
+// Background warm-up lets a plugin return from initialize quickly and build
+// expensive state, such as an index over a host directory, while the mount
+// already serves. A plugin with WASMCapWarmup exports plugin_warmup, which
+// does one bounded slice of that work and reports whether more remains.
+// Initialize starts a goroutine per instance that calls it until it is
+// done; until then the plugin answers from whatever it has built, falling
+// back to direct host calls.
+
+const (
+	// WASMWarmupSlice is the time budget passed to each plugin_warmup call
+	WASMWarmupSlice = 2 * time.Millisecond
+	// WASMWarmupPause separates slices, so calls queued on the instance lock
+	// take it before the next slice does
+	WASMWarmupPause = 500 * time.Microsecond
+)
+
+// startWarmup drives plugin_warmup on every instance in the background
+func (wp *WASMPlugin) startWarmup() {
+	if wp.fileSystem.optionalExport("plugin_warmup", WASMCapWarmup) == nil || wp.warmupStop != nil {
+		return
+	}
+
+	wp.warmupStop = make(chan struct{})
+	for i, inst := range wp.instances {
+		wp.warmupDone.Add(1)
+		go func(i int, inst *WASMFileSystem) {
+			defer wp.warmupDone.Done()
+			start := time.Now()
+			slices, err := inst.runWarmup(wp.warmupStop)
+			if err != nil {
+				log.Warnf("WASM plugin %s instance %d: %v; serving without it", wp.name, i, err)
+				return
+			}
+			log.Debugf("WASM plugin %s instance %d warmed up in %v (%d slices)", wp.name, i, time.Since(start), slices)
+		}(i, inst)
+	}
+}
+
+// stopWarmup stops the warm-up goroutines and waits for them to return
+func (wp *WASMPlugin) stopWarmup() {
+	if wp.warmupStop == nil {
+		return
+	}
+	close(wp.warmupStop)
+	wp.warmupDone.Wait()
+	wp.warmupStop = nil
+}
+
+// WaitWarmup blocks until every instance has finished warming up, or the
+// warm-up was stopped
+func (wp *WASMPlugin) WaitWarmup() {
+	wp.warmupDone.Wait()
+}
+
+// runWarmup calls plugin_warmup until the plugin reports it is done or stop
+// is closed, and returns how many slices ran
+func (wfs *WASMFileSystem) runWarmup(stop <-chan struct{}) (int, error) {
+	warmupFunc := wfs.optionalExport("plugin_warmup", WASMCapWarmup)
+	if warmupFunc == nil {
+		return 0, nil
+	}
+
+	budget := uint64(WASMWarmupSlice / time.Microsecond)
+	for slices := 1; ; slices++ {
+		more, err := wfs.warmupSlice(warmupFunc, budget)
+		if err != nil || !more {
+			return slices, err
+		}
+
+		select {
+		case <-stop:
+			return slices, nil
+		case <-time.After(WASMWarmupPause):
+		}
+	}
+}
+
+// warmupSlice runs one plugin_warmup call under the instance lock
+func (wfs *WASMFileSystem) warmupSlice(warmupFunc wazeroapi.Function, budget uint64) (bool, error) {
+	wfs.mu.Lock()
+	defer wfs.mu.Unlock()
+
+	results, err := warmupFunc.Call(wfs.ctx, budget)
+	if err != nil {
+		return false, fmt.Errorf("plugin_warmup failed: %w", err)
+	}
+	if len(results) < 1 {
+		return false, fmt.Errorf("plugin_warmup returned invalid results")
+	}
+
+	// Unpack u64: lower 32 bits = 1 while work remains, upper 32 bits = error
+	more := uint32(results[0] & 0xFFFFFFFF)
+	errPtr := uint32((results[0] >> 32) & 0xFFFFFFFF)
+	if errPtr != 0 {
+		if errMsg, ok := takeStringFromMemory(wfs.module, errPtr, wfs.abiVersion); ok {
+			return false, fmt.Errorf("warm-up failed: %s", errMsg)
+		}
+		return false, fmt.Errorf("warm-up failed")
+	}
+	return more != 0, nil
+}
@@ -0,0 +1,461 @@
+package api
+
+import (
+	"encoding/binary"
+	"encoding/json"
+	"fmt"
+	"sync/atomic"
+	"time"
+
+	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
+	wazeroapi "github.com/tetratelabs/wazero/api"
+)
+
+// ABI versions negotiated through the plugin_abi_version export.
+// Plugins that do not export it speak WASMABIJSON.
+const (
+	// WASMABIJSON passes FileInfo as JSON
+	WASMABIJSON uint32 = 1
+	// WASMABIBinaryFileInfo passes FileInfo in the binary wire format below
+	WASMABIBinaryFileInfo uint32 = 2
+	// WASMABIStringLength strings carry their length in the four bytes before
+	// the pointer (u32 length, bytes, NUL), so neither side scans for the NUL
+	WASMABIStringLength uint32 = 3
+	// WASMABIErrorCodes failed fs_* exports return an error code rather than
+	// a message string, see wasm_errors.go
+	WASMABIErrorCodes uint32 = 4
+	// WASMABIVersion is the highest version this host supports
+	WASMABIVersion = WASMABIErrorCodes
+)
+
+// Binary FileInfo wire format, shared with agfs-cpp-sdk/agfs_wire.h.
+// All integers are little-endian and nothing is aligned:
+//
+//	header  u32 total_len, u16 version, u16 reserved, u32 count
+//	record  i64 size, i64 mod_time (Unix seconds, 0 if unknown), u32 mode,
+//	        u32 flags, u32 name_len, u32 meta_len, name,
+//	        meta (u32 len + name, u32 len + type, u32 len + content JSON)
+//
+// A readdir page is the same buffer followed by u32 cursor_len + next cursor,
+// with total_len covering only the FileInfo part.
+//
+// host_fs_batch requests and responses use the same header, with count
+// giving the number of operations:
+//
+//	request entry   u32 op, u32 path_len, i64 offset, i64 size, path
+//	response entry  u32 op, u32 status, u32 payload_len, payload
+//
+// status is wireBatchOK or the error's code (see hostErrorKind). A successful
+// stat payload is a FileInfo buffer with one record, a read payload is the
+// data, and an error payload is the message.
+const (
+	wireFormatVersion    = 1
+	wireHeaderSize       = 12
+	wireRecordHeaderSize = 32
+	wireFlagDir          = 1 << 0
+	wireFlagMeta         = 1 << 1
+
+	wireBatchStat             = 1
+	wireBatchRead             = 2
+	wireBatchOK               = 0
+	wireBatchEntryHeaderSize  = 24
+	wireBatchResultHeaderSize = 12
+)
+
+// HostABI carries the ABI version negotiated with a plugin to the host
+// functions serving it
+type HostABI struct {
+	version atomic.Uint32
+}
+
+// Set records the negotiated ABI version
+func (a *HostABI) Set(version uint32) {
+	a.version.Store(version)
+}
+
+// Version returns the negotiated ABI version
+func (a *HostABI) Version() uint32 {
+	if a == nil {
+		return WASMABIJSON
+	}
+	if v := a.version.Load(); v != 0 {
+		return v
+	}
+	return WASMABIJSON
+}
+
+// BinaryFileInfo reports whether FileInfo travels in the binary wire format
+func (a *HostABI) BinaryFileInfo() bool {
+	return a != nil && a.version.Load() >= WASMABIBinaryFileInfo
+}
+
+func hasWireMeta(m filesystem.MetaData) bool {
+	return m.Name != "" || m.Type != "" || len(m.Content) > 0
+}
+
+// encodeFileInfos encodes infos into a single wire buffer
+func encodeFileInfos(infos []filesystem.FileInfo) []byte {
+	metaContents := make([][]byte, len(infos))
+	total := wireHeaderSize
+	for i, info := range infos {
+		total += wireRecordHeaderSize + len(info.Name)
+		if hasWireMeta(info.Meta) {
+			content := []byte("{}")
+			if len(info.Meta.Content) > 0 {
+				if data, err := json.Marshal(info.Meta.Content); err == nil {
+					content = data
+				}
+			}
+			metaContents[i] = content
+			total += 12 + len(info.Meta.Name) + len(info.Meta.Type) + len(content)
+		}
+	}
+
+	buf := make([]byte, 0, total)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(total))
+	buf = binary.LittleEndian.AppendUint16(buf, wireFormatVersion)
+	buf = binary.LittleEndian.AppendUint16(buf, 0)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(len(infos)))
+
+	for i, info := range infos {
+		var modTime int64
+		if !info.ModTime.IsZero() {
+			modTime = info.ModTime.Unix()
+		}
+		var flags uint32
+		if info.IsDir {
+			flags |= wireFlagDir
+		}
+		metaLen := 0
+		if metaContents[i] != nil {
+			flags |= wireFlagMeta
+			metaLen = 12 + len(info.Meta.Name) + len(info.Meta.Type) + len(metaContents[i])
+		}
+
+		buf = binary.LittleEndian.AppendUint64(buf, uint64(info.Size))
+		buf = binary.LittleEndian.AppendUint64(buf, uint64(modTime))
+		buf = binary.LittleEndian.AppendUint32(buf, info.Mode)
+		buf = binary.LittleEndian.AppendUint32(buf, flags)
+		buf = binary.LittleEndian.AppendUint32(buf, uint32(len(info.Name)))
+		buf = binary.LittleEndian.AppendUint32(buf, uint32(metaLen))
+		buf = append(buf, info.Name...)
+		if metaContents[i] != nil {
+			buf = appendWireString(buf, []byte(info.Meta.Name))
+			buf = appendWireString(buf, []byte(info.Meta.Type))
+			buf = appendWireString(buf, metaContents[i])
+		}
+	}
+
+	return buf
+}
+
+// encodeDirPage encodes one readdir page and the cursor of the next one
+func encodeDirPage(infos []filesystem.FileInfo, next string) []byte {
+	return appendWireString(encodeFileInfos(infos), []byte(next))
+}
+
+func appendWireString(buf, s []byte) []byte {
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(len(s)))
+	return append(buf, s...)
+}
+
+// decodeFileInfos decodes a wire buffer produced by encodeFileInfos or the C++ SDK
+func decodeFileInfos(buf []byte) ([]filesystem.FileInfo, error) {
+	if len(buf) < wireHeaderSize {
+		return nil, fmt.Errorf("wire buffer too short")
+	}
+	total := binary.LittleEndian.Uint32(buf[0:])
+	version := binary.LittleEndian.Uint16(buf[4:])
+	count := binary.LittleEndian.Uint32(buf[8:])
+	if version != wireFormatVersion {
+		return nil, fmt.Errorf("unsupported wire format version %d", version)
+	}
+	if total < wireHeaderSize || int(total) > len(buf) {
+		return nil, fmt.Errorf("invalid wire buffer length %d", total)
+	}
+	buf = buf[wireHeaderSize:total]
+
+	// Every record takes at least a header, which bounds a corrupt count
+	if uint64(count)*wireRecordHeaderSize > uint64(len(buf)) {
+		return nil, fmt.Errorf("invalid wire record count %d", count)
+	}
+
+	infos := make([]filesystem.FileInfo, 0, count)
+	for i := uint32(0); i < count; i++ {
+		if len(buf) < wireRecordHeaderSize {
+			return nil, fmt.Errorf("truncated wire record %d", i)
+		}
+		size := int64(binary.LittleEndian.Uint64(buf[0:]))
+		modTime := int64(binary.LittleEndian.Uint64(buf[8:]))
+		mode := binary.LittleEndian.Uint32(buf[16:])
+		flags := binary.LittleEndian.Uint32(buf[20:])
+		nameLen := binary.LittleEndian.Uint32(buf[24:])
+		metaLen := binary.LittleEndian.Uint32(buf[28:])
+		buf = buf[wireRecordHeaderSize:]
+
+		if uint64(nameLen)+uint64(metaLen) > uint64(len(buf)) {
+			return nil, fmt.Errorf("truncated wire record %d", i)
+		}
+
+		info := filesystem.FileInfo{
+			Name:  string(buf[:nameLen]),
+			Size:  size,
+			Mode:  mode,
+			IsDir: flags&wireFlagDir != 0,
+		}
+		if modTime != 0 {
+			info.ModTime = time.Unix(modTime, 0)
+		}
+
+		meta := buf[nameLen : nameLen+metaLen]
+		buf = buf[nameLen+metaLen:]
+		if flags&wireFlagMeta != 0 {
+			m, err := decodeWireMeta(meta)
+			if err != nil {
+				return nil, fmt.Errorf("wire record %d: %w", i, err)
+			}
+			info.Meta = m
+		}
+
+		infos = append(infos, info)
+	}
+
+	return infos, nil
+}
+
+func decodeWireMeta(buf []byte) (filesystem.MetaData, error) {
+	var fields [3][]byte
+	for i := range fields {
+		if len(buf) < 4 {
+			return filesystem.MetaData{}, fmt.Errorf("truncated meta")
+		}
+		n := binary.LittleEndian.Uint32(buf)
+		buf = buf[4:]
+		if uint64(n) > uint64(len(buf)) {
+			return filesystem.MetaData{}, fmt.Errorf("truncated meta")
+		}
+		fields[i] = buf[:n]
+		buf = buf[n:]
+	}
+
+	m := filesystem.MetaData{
+		Name: string(fields[0]),
+		Type: string(fields[1]),
+	}
+	if len(fields[2]) > 0 {
+		m.Content = decodeMetaContent(fields[2])
+	}
+	return m, nil
+}
+
+// decodeMetaContent parses a plugin's meta content JSON leniently: string
+// values are kept as is and anything else is kept as its JSON text
+func decodeMetaContent(data []byte) map[string]string {
+	var raw map[string]json.RawMessage
+	if err := json.Unmarshal(data, &raw); err != nil || len(raw) == 0 {
+		return nil
+	}
+	content := make(map[string]string, len(raw))
+	for k, v := range raw {
+		var s string
+		if err := json.Unmarshal(v, &s); err == nil {
+			content[k] = s
+		} else {
+			content[k] = string(v)
+		}
+	}
+	return content
+}
+
+// jsonFileInfo is FileInfo as a WASMABIJSON plugin encodes it. Meta content
+// is decoded with decodeMetaContent so non-string values do not fail the
+// whole result.
+type jsonFileInfo struct {
+	Name    string
+	Size    int64
+	Mode    uint32
+	ModTime time.Time
+	IsDir   bool
+	Meta    struct {
+		Name    string
+		Type    string
+		Content json.RawMessage
+	}
+}
+
+func (j *jsonFileInfo) fileInfo() filesystem.FileInfo {
+	info := filesystem.FileInfo{
+		Name:    j.Name,
+		Size:    j.Size,
+		Mode:    j.Mode,
+		ModTime: j.ModTime,
+		IsDir:   j.IsDir,
+		Meta:    filesystem.MetaData{Name: j.Meta.Name, Type: j.Meta.Type},
+	}
+	if len(j.Meta.Content) > 0 {
+		info.Meta.Content = decodeMetaContent(j.Meta.Content)
+	}
+	return info
+}
+
+// decodeJSONFileInfo parses a WASMABIJSON stat result
+func decodeJSONFileInfo(data []byte) (*filesystem.FileInfo, error) {
+	var j jsonFileInfo
+	if err := json.Unmarshal(data, &j); err != nil {
+		return nil, err
+	}
+	info := j.fileInfo()
+	return &info, nil
+}
+
+// decodeJSONFileInfos parses a WASMABIJSON readdir result
+func decodeJSONFileInfos(data []byte) ([]filesystem.FileInfo, error) {
+	var js []jsonFileInfo
+	if err := json.Unmarshal(data, &js); err != nil {
+		return nil, err
+	}
+	infos := make([]filesystem.FileInfo, len(js))
+	for i := range js {
+		infos[i] = js[i].fileInfo()
+	}
+	return infos, nil
+}
+
+// readFileInfosFromMemory decodes a wire buffer the plugin returned and
+// releases it back to the plugin
+func readFileInfosFromMemory(module wazeroapi.Module, ptr uint32) ([]filesystem.FileInfo, error) {
+	defer freeMemory(module, ptr)
+
+	total, ok := module.Memory().ReadUint32Le(ptr)
+	if !ok {
+		return nil, fmt.Errorf("failed to read wire header from memory")
+	}
+
+	// Decoding copies every string, so the view may be used directly
+	buf, ok := module.Memory().Read(ptr, total)
+	if !ok {
+		return nil, fmt.Errorf("failed to read wire buffer from memory")
+	}
+
+	return decodeFileInfos(buf)
+}
+
+// readDirPageFromMemory decodes a readdir page the plugin returned and
+// releases it back to the plugin
+func readDirPageFromMemory(module wazeroapi.Module, ptr uint32) ([]filesystem.FileInfo, string, error) {
+	defer freeMemory(module, ptr)
+
+	total, ok := module.Memory().ReadUint32Le(ptr)
+	if !ok {
+		return nil, "", fmt.Errorf("failed to read wire header from memory")
+	}
+	cursorLen, ok := module.Memory().ReadUint32Le(ptr + total)
+	if !ok {
+		return nil, "", fmt.Errorf("failed to read page cursor from memory")
+	}
+
+	buf, ok := module.Memory().Read(ptr, total+4+cursorLen)
+	if !ok {
+		return nil, "", fmt.Errorf("failed to read page from memory")
+	}
+
+	return decodeDirPage(buf)
+}
+
+// decodeDirPage decodes a readdir page produced by encodeDirPage or the C++ SDK
+func decodeDirPage(buf []byte) ([]filesystem.FileInfo, string, error) {
+	if len(buf) < wireHeaderSize {
+		return nil, "", fmt.Errorf("wire buffer too short")
+	}
+	total := uint64(binary.LittleEndian.Uint32(buf))
+	if total+4 > uint64(len(buf)) {
+		return nil, "", fmt.Errorf("truncated page cursor")
+	}
+	cursorLen := uint64(binary.LittleEndian.Uint32(buf[total:]))
+	if total+4+cursorLen > uint64(len(buf)) {
+		return nil, "", fmt.Errorf("truncated page cursor")
+	}
+
+	infos, err := decodeFileInfos(buf[:total])
+	if err != nil {
+		return nil, "", err
+	}
+	return infos, string(buf[total+4 : total+4+cursorLen]), nil
+}
+
+// wireBatchOp is one operation of a host_fs_batch request
+type wireBatchOp struct {
+	op     uint32
+	path   string
+	offset int64
+	size   int64
+}
+
+// wireBatchResult is one entry of a host_fs_batch response
+type wireBatchResult struct {
+	op      uint32
+	status  uint32
+	payload []byte
+}
+
+// decodeBatchRequest decodes a host_fs_batch request
+func decodeBatchRequest(buf []byte) ([]wireBatchOp, error) {
+	if len(buf) < wireHeaderSize {
+		return nil, fmt.Errorf("batch request too short")
+	}
+	total := binary.LittleEndian.Uint32(buf[0:])
+	version := binary.LittleEndian.Uint16(buf[4:])
+	count := binary.LittleEndian.Uint32(buf[8:])
+	if version != wireFormatVersion {
+		return nil, fmt.Errorf("unsupported wire format version %d", version)
+	}
+	if total < wireHeaderSize || int(total) > len(buf) {
+		return nil, fmt.Errorf("invalid batch request length %d", total)
+	}
+	buf = buf[wireHeaderSize:total]
+	if uint64(count)*wireBatchEntryHeaderSize > uint64(len(buf)) {
+		return nil, fmt.Errorf("invalid batch count %d", count)
+	}
+
+	ops := make([]wireBatchOp, 0, count)
+	for i := uint32(0); i < count; i++ {
+		if len(buf) < wireBatchEntryHeaderSize {
+			return nil, fmt.Errorf("truncated batch entry %d", i)
+		}
+		op := wireBatchOp{
+			op:     binary.LittleEndian.Uint32(buf[0:]),
+			offset: int64(binary.LittleEndian.Uint64(buf[8:])),
+			size:   int64(binary.LittleEndian.Uint64(buf[16:])),
+		}
+		pathLen := binary.LittleEndian.Uint32(buf[4:])
+		buf = buf[wireBatchEntryHeaderSize:]
+		if uint64(pathLen) > uint64(len(buf)) {
+			return nil, fmt.Errorf("truncated batch entry %d", i)
+		}
+		op.path = string(buf[:pathLen])
+		buf = buf[pathLen:]
+		ops = append(ops, op)
+	}
+
+	return ops, nil
+}
+
+// encodeBatchResponse encodes host_fs_batch results in request order
+func encodeBatchResponse(results []wireBatchResult) []byte {
+	total := wireHeaderSize
+	for _, r := range results {
+		total += wireBatchResultHeaderSize + len(r.payload)
+	}
+
+	buf := make([]byte, 0, total)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(total))
+	buf = binary.LittleEndian.AppendUint16(buf, wireFormatVersion)
+	buf = binary.LittleEndian.AppendUint16(buf, 0)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(len(results)))
+	for _, r := range results {
+		buf = binary.LittleEndian.AppendUint32(buf, r.op)
+		buf = binary.LittleEndian.AppendUint32(buf, r.status)
+		buf = appendWireString(buf, r.payload)
+	}
+	return buf
+}
@@ -0,0 +1,268 @@
+package api
+
+import (
+	"bytes"
+	"encoding/binary"
+	"reflect"
+	"testing"
+	"time"
+
+	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
+)
+
+var wireTestInfos = []struct {
+	name  string
+	infos []filesystem.FileInfo
+}{
+	{"empty", nil},
+	{"file", []filesystem.FileInfo{
+		{Name: "a.txt", Size: 42, Mode: 0644, ModTime: time.Unix(1700000000, 0)},
+	}},
+	{"dir without mod time", []filesystem.FileInfo{
+		{Name: "sub", Mode: 0755, IsDir: true},
+	}},
+	{"negative size", []filesystem.FileInfo{
+		{Name: "stream", Size: -1, Mode: 0444},
+	}},
+	{"meta", []filesystem.FileInfo{
+		{Name: "m", Size: 1, Meta: filesystem.MetaData{
+			Name:    "hellofs",
+			Type:    "file",
+			Content: map[string]string{"k": "v", "n": "2"},
+		}},
+	}},
+	{"meta without content", []filesystem.FileInfo{
+		{Name: "m", Meta: filesystem.MetaData{Name: "hellofs"}},
+	}},
+	{"several", []filesystem.FileInfo{
+		{Name: "", Size: 0},
+		{Name: "b", Size: 1 << 40, Mode: 0600, ModTime: time.Unix(1, 0)},
+		{Name: "c", IsDir: true, Meta: filesystem.MetaData{Type: "dir"}},
+	}},
+}
+
+func normalizeInfos(infos []filesystem.FileInfo) []filesystem.FileInfo {
+	if len(infos) == 0 {
+		return nil
+	}
+	return infos
+}
+
+func TestFileInfosRoundTrip(t *testing.T) {
+	for _, tt := range wireTestInfos {
+		t.Run(tt.name, func(t *testing.T) {
+			buf := encodeFileInfos(tt.infos)
+			if got := binary.LittleEndian.Uint32(buf); int(got) != len(buf) {
+				t.Fatalf("total_len = %d, buffer is %d bytes", got, len(buf))
+			}
+			got, err := decodeFileInfos(buf)
+			if err != nil {
+				t.Fatalf("decodeFileInfos: %v", err)
+			}
+			if !reflect.DeepEqual(normalizeInfos(got), normalizeInfos(tt.infos)) {
+				t.Errorf("got %+v, want %+v", got, tt.infos)
+			}
+		})
+	}
+}
+
+// Every proper prefix of a valid buffer must be rejected, whether the header,
+// a record or its meta is cut
+func TestFileInfosTruncated(t *testing.T) {
+	for _, tt := range wireTestInfos {
+		t.Run(tt.name, func(t *testing.T) {
+			buf := encodeFileInfos(tt.infos)
+			for n := 0; n < len(buf); n++ {
+				if _, err := decodeFileInfos(buf[:n]); err == nil {
+					t.Errorf("decoding %d of %d bytes succeeded", n, len(buf))
+				}
+			}
+		})
+	}
+}
+
+func TestFileInfosCorrupt(t *testing.T) {
+	valid := encodeFileInfos([]filesystem.FileInfo{{Name: "a", Meta: filesystem.MetaData{Name: "x"}}})
+	tests := []struct {
+		name   string
+		mutate func(buf []byte)
+	}{
+		{"version", func(buf []byte) { binary.LittleEndian.PutUint16(buf[4:], wireFormatVersion+1) }},
+		{"total below header", func(buf []byte) { binary.LittleEndian.PutUint32(buf, wireHeaderSize-1) }},
+		{"total past buffer", func(buf []byte) { binary.LittleEndian.PutUint32(buf, uint32(len(buf)+1)) }},
+		{"count", func(buf []byte) { binary.LittleEndian.PutUint32(buf[8:], 1<<30) }},
+		{"name length", func(buf []byte) { binary.LittleEndian.PutUint32(buf[wireHeaderSize+24:], 1<<20) }},
+		{"meta length", func(buf []byte) { binary.LittleEndian.PutUint32(buf[wireHeaderSize+28:], 1<<20) }},
+		{"meta field length", func(buf []byte) {
+			binary.LittleEndian.PutUint32(buf[wireHeaderSize+wireRecordHeaderSize+1:], 1<<20)
+		}},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			buf := bytes.Clone(valid)
+			tt.mutate(buf)
+			if _, err := decodeFileInfos(buf); err == nil {
+				t.Error("decodeFileInfos succeeded")
+			}
+		})
+	}
+}
+
+func TestDirPageRoundTrip(t *testing.T) {
+	for _, cursor := range []string{"", "next", "\x00binary\xff"} {
+		for _, tt := range wireTestInfos {
+			t.Run(tt.name+"/"+cursor, func(t *testing.T) {
+				buf := encodeDirPage(tt.infos, cursor)
+				infos, next, err := decodeDirPage(buf)
+				if err != nil {
+					t.Fatalf("decodeDirPage: %v", err)
+				}
+				if next != cursor {
+					t.Errorf("cursor = %q, want %q", next, cursor)
+				}
+				if !reflect.DeepEqual(normalizeInfos(infos), normalizeInfos(tt.infos)) {
+					t.Errorf("got %+v, want %+v", infos, tt.infos)
+				}
+				for n := 0; n < len(buf); n++ {
+					if _, _, err := decodeDirPage(buf[:n]); err == nil {
+						t.Errorf("decoding %d of %d bytes succeeded", n, len(buf))
+					}
+				}
+			})
+		}
+	}
+}
+
+func encodeTestBatchRequest(ops []wireBatchOp) []byte {
+	total := wireHeaderSize
+	for _, op := range ops {
+		total += wireBatchEntryHeaderSize + len(op.path)
+	}
+	buf := binary.LittleEndian.AppendUint32(nil, uint32(total))
+	buf = binary.LittleEndian.AppendUint16(buf, wireFormatVersion)
+	buf = binary.LittleEndian.AppendUint16(buf, 0)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(len(ops)))
+	for _, op := range ops {
+		buf = binary.LittleEndian.AppendUint32(buf, op.op)
+		buf = binary.LittleEndian.AppendUint32(buf, uint32(len(op.path)))
+		buf = binary.LittleEndian.AppendUint64(buf, uint64(op.offset))
+		buf = binary.LittleEndian.AppendUint64(buf, uint64(op.size))
+		buf = append(buf, op.path...)
+	}
+	return buf
+}
+
+var wireTestBatches = []struct {
+	name string
+	ops  []wireBatchOp
+}{
+	{"empty", nil},
+	{"stat", []wireBatchOp{{op: wireBatchStat, path: "/a"}}},
+	{"mixed", []wireBatchOp{
+		{op: wireBatchRead, path: "/data/big", offset: 1 << 33, size: -1},
+		{op: wireBatchStat, path: ""},
+		{op: wireBatchRead, path: "/b", offset: 0, size: 4096},
+	}},
+}
+
+func TestBatchRequestDecode(t *testing.T) {
+	for _, tt := range wireTestBatches {
+		t.Run(tt.name, func(t *testing.T) {
+			buf := encodeTestBatchRequest(tt.ops)
+			got, err := decodeBatchRequest(buf)
+			if err != nil {
+				t.Fatalf("decodeBatchRequest: %v", err)
+			}
+			if len(got) != len(tt.ops) || (len(got) > 0 && !reflect.DeepEqual(got, tt.ops)) {
+				t.Errorf("got %+v, want %+v", got, tt.ops)
+			}
+			for n := 0; n < len(buf); n++ {
+				if _, err := decodeBatchRequest(buf[:n]); err == nil {
+					t.Errorf("decoding %d of %d bytes succeeded", n, len(buf))
+				}
+			}
+		})
+	}
+}
+
+func TestBatchRequestCorrupt(t *testing.T) {
+	valid := encodeTestBatchRequest([]wireBatchOp{{op: wireBatchStat, path: "/a"}})
+	tests := []struct {
+		name   string
+		mutate func(buf []byte)
+	}{
+		{"version", func(buf []byte) { binary.LittleEndian.PutUint16(buf[4:], wireFormatVersion+1) }},
+		{"total below header", func(buf []byte) { binary.LittleEndian.PutUint32(buf, wireHeaderSize-1) }},
+		{"count", func(buf []byte) { binary.LittleEndian.PutUint32(buf[8:], 1<<30) }},
+		{"path length", func(buf []byte) { binary.LittleEndian.PutUint32(buf[wireHeaderSize+4:], 1<<20) }},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			buf := bytes.Clone(valid)
+			tt.mutate(buf)
+			if _, err := decodeBatchRequest(buf); err == nil {
+				t.Error("decodeBatchRequest succeeded")
+			}
+		})
+	}
+}
+
+// decodeTestBatchResponse parses a response the way agfs_hostfs.h does
+func decodeTestBatchResponse(t *testing.T, buf []byte) []wireBatchResult {
+	t.Helper()
+	if len(buf) < wireHeaderSize || int(binary.LittleEndian.Uint32(buf)) != len(buf) {
+		t.Fatalf("bad response header")
+	}
+	count := binary.LittleEndian.Uint32(buf[8:])
+	buf = buf[wireHeaderSize:]
+	var results []wireBatchResult
+	for i := uint32(0); i < count; i++ {
+		if len(buf) < wireBatchResultHeaderSize {
+			t.Fatalf("truncated result %d", i)
+		}
+		r := wireBatchResult{
+			op:     binary.LittleEndian.Uint32(buf[0:]),
+			status: binary.LittleEndian.Uint32(buf[4:]),
+		}
+		n := binary.LittleEndian.Uint32(buf[8:])
+		buf = buf[wireBatchResultHeaderSize:]
+		if uint64(n) > uint64(len(buf)) {
+			t.Fatalf("truncated result %d", i)
+		}
+		r.payload = buf[:n]
+		buf = buf[n:]
+		results = append(results, r)
+	}
+	if len(buf) != 0 {
+		t.Fatalf("%d trailing bytes", len(buf))
+	}
+	return results
+}
+
+func TestBatchResponseEncode(t *testing.T) {
+	tests := []struct {
+		name    string
+		results []wireBatchResult
+	}{
+		{"empty", nil},
+		{"ok and error", []wireBatchResult{
+			{op: wireBatchStat, status: wireBatchOK, payload: encodeFileInfos([]filesystem.FileInfo{{Name: "a"}})},
+			{op: wireBatchRead, status: WASMErrorNotFound, payload: []byte("not found")},
+			{op: wireBatchRead, status: wireBatchOK, payload: []byte{}},
+		}},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			got := decodeTestBatchResponse(t, encodeBatchResponse(tt.results))
+			if len(got) != len(tt.results) {
+				t.Fatalf("got %d results, want %d", len(got), len(tt.results))
+			}
+			for i := range got {
+				want := tt.results[i]
+				if got[i].op != want.op || got[i].status != want.status || !bytes.Equal(got[i].payload, want.payload) {
+					t.Errorf("result %d = %+v, want %+v", i, got[i], want)
+				}
+			}
+		})
+	}
+}
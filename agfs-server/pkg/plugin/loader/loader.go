@@ -129,6 +129,12 @@ func detectPluginTypeByExtension(libraryPath string) PluginType {
 	}
 }
 
+// SetWASMCacheDir persists compiled WASM modules and plugin startup
+// snapshots under dir; see WASMPluginLoader.SetCacheDir
+func (pl *PluginLoader) SetWASMCacheDir(dir string) error {
+	return pl.wasmLoader.SetCacheDir(dir)
+}
+
 // LoadPluginWithType loads a plugin with an explicitly specified type
 // For WASM plugins, optional hostFS can be provided to allow access to host filesystem
 func (pl *PluginLoader) LoadPluginWithType(libraryPath string, pluginType PluginType, hostFS ...interface{}) (plugin.ServicePlugin, error) {
@@ -2,9 +2,12 @@ package loader
 
 import (
 	"context"
+	"crypto/sha256"
+	"encoding/hex"
 	"fmt"
 	"os"
 	"path/filepath"
+	"runtime"
 	"sync"
 
 	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
@@ -13,32 +16,82 @@ import (
 	log "github.com/sirupsen/logrus"
 	"github.com/tetratelabs/wazero"
 	wazeroapi "github.com/tetratelabs/wazero/api"
+	"github.com/tetratelabs/wazero/experimental"
 	"github.com/tetratelabs/wazero/imports/wasi_snapshot_preview1"
 )
 
 // LoadedWASMPlugin tracks a loaded WASM plugin
 type LoadedWASMPlugin struct {
-	Path     string
-	Plugin   plugin.ServicePlugin
-	Runtime  wazero.Runtime
-	Module   wazeroapi.Module
-	RefCount int
-	mu       sync.Mutex
+	Path      string
+	Plugin    plugin.ServicePlugin
+	Runtime   wazero.Runtime
+	Module    wazeroapi.Module
+	Modules   []wazeroapi.Module // Every pooled instance, Module first
+	HostFiles *api.HostFileTable
+	HostDirs  *api.HostDirTable
+	HostAsync *api.HostAsyncTable
+	RefCount  int
+	mu        sync.Mutex
 }
 
+// maxWASMPoolSize caps the default number of instances per pooled plugin
+const maxWASMPoolSize = 8
+
 // WASMPluginLoader manages loading and unloading of WASM plugins
 type WASMPluginLoader struct {
 	loadedPlugins map[string]*LoadedWASMPlugin
+	poolSize      int
 	mu            sync.RWMutex
+
+	// Compiled modules shared by every plugin runtime; kept in memory, or
+	// under cacheDir once SetCacheDir is called
+	compilationCache wazero.CompilationCache
+	cacheDir         string
 }
 
 // NewWASMPluginLoader creates a new WASM plugin loader
 func NewWASMPluginLoader() *WASMPluginLoader {
+	poolSize := runtime.GOMAXPROCS(0)
+	if poolSize > maxWASMPoolSize {
+		poolSize = maxWASMPoolSize
+	}
 	return &WASMPluginLoader{
-		loadedPlugins: make(map[string]*LoadedWASMPlugin),
+		loadedPlugins:    make(map[string]*LoadedWASMPlugin),
+		poolSize:         poolSize,
+		compilationCache: wazero.NewCompilationCache(),
 	}
 }
 
+// SetCacheDir persists compiled modules, and the startup snapshots of
+// plugins that support them, under dir so a restart skips compiling and
+// initializing unchanged plugins. wazero keys compiled code by a hash of the
+// wasm binary, its own version and the host architecture, so stale entries
+// are never reused. Plugins loaded afterwards use the new directory.
+func (wl *WASMPluginLoader) SetCacheDir(dir string) error {
+	cache, err := wazero.NewCompilationCacheWithDir(filepath.Join(dir, "compiled"))
+	if err != nil {
+		return fmt.Errorf("failed to open WASM compilation cache in %s: %w", dir, err)
+	}
+
+	wl.mu.Lock()
+	defer wl.mu.Unlock()
+	// Runtimes of loaded plugins keep using the old cache until they close
+	wl.compilationCache = cache
+	wl.cacheDir = dir
+	return nil
+}
+
+// SetPoolSize sets how many module instances serve each plugin that declares
+// itself pool-safe; plugins loaded afterwards use the new size
+func (wl *WASMPluginLoader) SetPoolSize(n int) {
+	wl.mu.Lock()
+	defer wl.mu.Unlock()
+	if n < 1 {
+		n = 1
+	}
+	wl.poolSize = n
+}
+
 // LoadWASMPlugin loads a plugin from a WASM file
 // If hostFS is provided, it will be exposed to the WASM plugin as host functions
 func (wl *WASMPluginLoader) LoadWASMPlugin(wasmPath string, hostFS ...interface{}) (plugin.ServicePlugin, error) {
@@ -77,8 +130,12 @@ func (wl *WASMPluginLoader) LoadWASMPlugin(wasmPath string, hostFS ...interface{
 	}
 
 	// Create a new WASM runtime
+	// Threads (atomics, shared memory) are enabled so plugins built with
+	// `make build-wasi-threads` compile; see instantiateThreadSpawn
 	ctx := context.Background()
-	r := wazero.NewRuntime(ctx)
+	r := wazero.NewRuntimeWithConfig(ctx, wazero.NewRuntimeConfig().
+		WithCoreFeatures(wazeroapi.CoreFeaturesV2|experimental.CoreFeaturesThreads).
+		WithCompilationCache(wl.compilationCache))
 
 	// Instantiate WASI
 	if _, err := wasi_snapshot_preview1.Instantiate(ctx, r); err != nil {
@@ -103,57 +160,121 @@ func (wl *WASMPluginLoader) LoadWASMPlugin(wasmPath string, hostFS ...interface{
 		fs = nil // Will be handled by api functions
 	}
 
+	// Host files the plugin opens for streaming; closed when the plugin unloads
+	hostFiles := api.NewHostFileTable()
+	// Host directory listings the plugin is paging through
+	hostDirs := api.NewHostDirTable()
+	// Host operations the plugin submitted and has not taken yet
+	hostAsync := api.NewHostAsyncTable()
+	// ABI version seen by the host functions; set once the plugin has negotiated
+	hostABI := &api.HostABI{}
+
 	_, err = r.NewHostModuleBuilder("env").
 			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr uint32, offset, size int64) uint64 {
-				return api.HostFSRead(ctx, mod, []uint64{uint64(pathPtr), uint64(offset), uint64(size)}, fs)[0]
+				return api.HostFSRead(ctx, mod, []uint64{uint64(pathPtr), uint64(offset), uint64(size)}, fs, hostABI)[0]
 			}).
 			Export("host_fs_read").
 			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr uint32, offset int64, bufPtr, bufCap uint32) int64 {
+				return int64(api.HostFSReadInto(ctx, mod, []uint64{uint64(pathPtr), uint64(offset), uint64(bufPtr), uint64(bufCap)}, fs, hostABI)[0])
+			}).
+			Export("host_fs_read_into").
+			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr, flags uint32) int64 {
+				return int64(api.HostFSOpen(ctx, mod, []uint64{uint64(pathPtr), uint64(flags)}, fs, hostFiles, hostABI)[0])
+			}).
+			Export("host_fs_open").
+			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, handle int64, bufPtr, bufCap uint32) int64 {
+				return int64(api.HostFSReadChunk(ctx, mod, []uint64{uint64(handle), uint64(bufPtr), uint64(bufCap)}, hostFiles, hostABI)[0])
+			}).
+			Export("host_fs_read_chunk").
+			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, handle int64, dataPtr, dataLen uint32) int64 {
+				return int64(api.HostFSWriteChunk(ctx, mod, []uint64{uint64(handle), uint64(dataPtr), uint64(dataLen)}, hostFiles, hostABI)[0])
+			}).
+			Export("host_fs_write_chunk").
+			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, handle int64) uint32 {
+				return uint32(api.HostFSClose(ctx, mod, []uint64{uint64(handle)}, hostFiles, hostABI)[0])
+			}).
+			Export("host_fs_close").
+			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr, dataPtr, dataLen uint32) uint64 {
-				return api.HostFSWrite(ctx, mod, []uint64{uint64(pathPtr), uint64(dataPtr), uint64(dataLen)}, fs)[0]
+				return api.HostFSWrite(ctx, mod, []uint64{uint64(pathPtr), uint64(dataPtr), uint64(dataLen)}, fs, hostABI)[0]
 			}).
 			Export("host_fs_write").
 			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr uint32) uint64 {
-				return api.HostFSStat(ctx, mod, []uint64{uint64(pathPtr)}, fs)[0]
+				return api.HostFSStat(ctx, mod, []uint64{uint64(pathPtr)}, fs, hostABI)[0]
 			}).
 			Export("host_fs_stat").
 			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr uint32) uint64 {
-				return api.HostFSReadDir(ctx, mod, []uint64{uint64(pathPtr)}, fs)[0]
+				return api.HostFSReadDir(ctx, mod, []uint64{uint64(pathPtr)}, fs, hostABI)[0]
 			}).
 			Export("host_fs_readdir").
 			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr, cursorPtr, maxEntries uint32) uint64 {
+				return api.HostFSReadDirPage(ctx, mod, []uint64{uint64(pathPtr), uint64(cursorPtr), uint64(maxEntries)}, fs, hostDirs, hostABI)[0]
+			}).
+			Export("host_fs_readdir_page").
+			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, reqPtr, reqLen uint32) uint64 {
+				return api.HostFSBatch(ctx, mod, []uint64{uint64(reqPtr), uint64(reqLen)}, fs, hostABI)[0]
+			}).
+			Export("host_fs_batch").
+			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, reqPtr, reqLen uint32) int64 {
+				return int64(api.HostFSSubmit(ctx, mod, []uint64{uint64(reqPtr), uint64(reqLen)}, fs, hostAsync, hostABI)[0])
+			}).
+			Export("host_fs_submit").
+			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, ticketsPtr, count uint32, timeoutMs int64) int64 {
+				return int64(api.HostFSWaitAny(ctx, mod, []uint64{uint64(ticketsPtr), uint64(count), uint64(timeoutMs)}, hostAsync, hostABI)[0])
+			}).
+			Export("host_fs_wait_any").
+			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, ticket int64) uint32 {
+				return uint32(api.HostFSTake(ctx, mod, []uint64{uint64(ticket)}, hostAsync, hostABI)[0])
+			}).
+			Export("host_fs_take").
+			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr uint32) uint32 {
-				return uint32(api.HostFSCreate(ctx, mod, []uint64{uint64(pathPtr)}, fs)[0])
+				return uint32(api.HostFSCreate(ctx, mod, []uint64{uint64(pathPtr)}, fs, hostABI)[0])
 			}).
 			Export("host_fs_create").
 			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr, perm uint32) uint32 {
-				return uint32(api.HostFSMkdir(ctx, mod, []uint64{uint64(pathPtr), uint64(perm)}, fs)[0])
+				return uint32(api.HostFSMkdir(ctx, mod, []uint64{uint64(pathPtr), uint64(perm)}, fs, hostABI)[0])
 			}).
 			Export("host_fs_mkdir").
 			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr uint32) uint32 {
-				return uint32(api.HostFSRemove(ctx, mod, []uint64{uint64(pathPtr)}, fs)[0])
+				return uint32(api.HostFSRemove(ctx, mod, []uint64{uint64(pathPtr)}, fs, hostABI)[0])
 			}).
 			Export("host_fs_remove").
 			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr uint32) uint32 {
-				return uint32(api.HostFSRemoveAll(ctx, mod, []uint64{uint64(pathPtr)}, fs)[0])
+				return uint32(api.HostFSRemoveAll(ctx, mod, []uint64{uint64(pathPtr)}, fs, hostABI)[0])
 			}).
 			Export("host_fs_remove_all").
 			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, oldPathPtr, newPathPtr uint32) uint32 {
-				return uint32(api.HostFSRename(ctx, mod, []uint64{uint64(oldPathPtr), uint64(newPathPtr)}, fs)[0])
+				return uint32(api.HostFSRename(ctx, mod, []uint64{uint64(oldPathPtr), uint64(newPathPtr)}, fs, hostABI)[0])
 			}).
 			Export("host_fs_rename").
 			NewFunctionBuilder().
 			WithFunc(func(ctx context.Context, mod wazeroapi.Module, pathPtr, mode uint32) uint32 {
-				return uint32(api.HostFSChmod(ctx, mod, []uint64{uint64(pathPtr), uint64(mode)}, fs)[0])
+				return uint32(api.HostFSChmod(ctx, mod, []uint64{uint64(pathPtr), uint64(mode)}, fs, hostABI)[0])
 			}).
 			Export("host_fs_chmod").
+			NewFunctionBuilder().
+			WithFunc(func(ctx context.Context, mod wazeroapi.Module, srcPtr, dstPtr uint32, offset, size int64) int64 {
+				return int64(api.HostFSCopy(ctx, mod, []uint64{uint64(srcPtr), uint64(dstPtr), uint64(offset), uint64(size)}, fs, hostABI)[0])
+			}).
+			Export("host_fs_copy").
 			Instantiate(ctx)
 	if err != nil {
 		r.Close(ctx)
@@ -167,6 +288,11 @@ func (wl *WASMPluginLoader) LoadWASMPlugin(wasmPath string, hostFS ...interface{
 		return nil, fmt.Errorf("failed to compile WASM module: %w", err)
 	}
 
+	if err := instantiateThreadSpawn(ctx, r, compiledModule); err != nil {
+		r.Close(ctx)
+		return nil, fmt.Errorf("failed to instantiate wasi-threads module: %w", err)
+	}
+
 	// Instantiate the module without filesystem access
 	// WASM plugins are not allowed to access the local filesystem
 	config := wazero.NewModuleConfig().
@@ -189,21 +315,80 @@ func (wl *WASMPluginLoader) LoadWASMPlugin(wasmPath string, hostFS ...interface{
 		r.Close(ctx)
 		return nil, fmt.Errorf("failed to create WASM plugin wrapper: %w", err)
 	}
+	hostABI.Set(wasmPlugin.ABIVersion())
+	if wl.cacheDir != "" {
+		moduleHash := sha256.Sum256(wasmBytes)
+		wasmPlugin.SetSnapshotDir(filepath.Join(wl.cacheDir, "snapshots"), hex.EncodeToString(moduleHash[:]))
+	}
+	log.Debugf("WASM plugin %s negotiated ABI version %d", absPath, wasmPlugin.ABIVersion())
+
+	// Pool-safe plugins get more instances of the same compiled module so
+	// concurrent requests can run in parallel
+	modules := []wazeroapi.Module{module}
+	if wasmPlugin.Poolable() {
+		for i := 1; i < wl.poolSize; i++ {
+			extra, err := r.InstantiateModule(ctx, compiledModule, config.WithName(fmt.Sprintf("plugin-%d", i)))
+			if err != nil {
+				log.Warnf("Failed to instantiate pooled WASM module %d for %s: %v", i, absPath, err)
+				break
+			}
+			if err := wasmPlugin.AddInstance(extra); err != nil {
+				log.Warnf("Failed to add pooled WASM instance %d for %s: %v", i, absPath, err)
+				extra.Close(ctx)
+				break
+			}
+			modules = append(modules, extra)
+		}
+		log.Infof("WASM plugin %s serves requests from %d instances", absPath, len(modules))
+	}
 
 	// Track loaded plugin
 	loaded := &LoadedWASMPlugin{
-		Path:     absPath,
-		Plugin:   wasmPlugin,
-		Runtime:  r,
-		Module:   module,
-		RefCount: 1,
+		Path:      absPath,
+		Plugin:    wasmPlugin,
+		Runtime:   r,
+		Module:    module,
+		Modules:   modules,
+		HostFiles: hostFiles,
+		HostDirs:  hostDirs,
+		HostAsync: hostAsync,
+		RefCount:  1,
 	}
 	wl.loadedPlugins[absPath] = loaded
+	api.TrackWASMPlugin(absPath, wasmPlugin)
 
 	log.Infof("Successfully loaded WASM plugin: %s (name: %s)", absPath, wasmPlugin.Name())
 	return wasmPlugin, nil
 }
 
+// instantiateThreadSpawn provides wasi-threads' thread-spawn to modules that
+// import it. wazero cannot start threads inside a module, so spawning always
+// fails: pthread_create returns an error and agfs::ThreadPool runs its tasks
+// on the calling thread. Such plugins still scale across requests through
+// instance pooling.
+func instantiateThreadSpawn(ctx context.Context, r wazero.Runtime, compiled wazero.CompiledModule) error {
+	needed := false
+	for _, fn := range compiled.ImportedFunctions() {
+		if moduleName, name, ok := fn.Import(); ok && moduleName == "wasi" && name == "thread-spawn" {
+			needed = true
+			break
+		}
+	}
+	if !needed {
+		return nil
+	}
+
+	log.Infof("WASM module imports wasi thread-spawn; threads will run inline")
+	_, err := r.NewHostModuleBuilder("wasi").
+		NewFunctionBuilder().
+		WithFunc(func(ctx context.Context, startArg uint32) int32 {
+			return -1 // wasi-threads: negative means the thread was not started
+		}).
+		Export("thread-spawn").
+		Instantiate(ctx)
+	return err
+}
+
 // UnloadWASMPlugin unloads a WASM plugin (decrements ref count, unloads when reaches 0)
 func (wl *WASMPluginLoader) UnloadWASMPlugin(wasmPath string) error {
 	wl.mu.Lock()
@@ -230,10 +415,17 @@ func (wl *WASMPluginLoader) UnloadWASMPlugin(wasmPath string) error {
 			log.Warnf("Error shutting down WASM plugin %s: %v", absPath, err)
 		}
 
+		// Release host files and listings the plugin never finished
+		loaded.HostFiles.CloseAll()
+		loaded.HostDirs.Clear()
+		loaded.HostAsync.Clear()
+
 		// Close module and runtime
 		ctx := context.Background()
-		if err := loaded.Module.Close(ctx); err != nil {
-			log.Warnf("Error closing WASM module %s: %v", absPath, err)
+		for _, module := range loaded.Modules {
+			if err := module.Close(ctx); err != nil {
+				log.Warnf("Error closing WASM module %s: %v", absPath, err)
+			}
 		}
 		if err := loaded.Runtime.Close(ctx); err != nil {
 			log.Warnf("Error closing WASM runtime %s: %v", absPath, err)
@@ -241,6 +433,7 @@ func (wl *WASMPluginLoader) UnloadWASMPlugin(wasmPath string) error {
 
 		// Remove from tracking
 		delete(wl.loadedPlugins, absPath)
+		api.UntrackWASMPlugin(absPath)
 		log.Infof("Unloaded WASM plugin: %s", absPath)
 	} else {
 		log.Infof("Decremented WASM plugin ref count: %s (refCount: %d)", absPath, refCount)
@@ -0,0 +1,170 @@
+package loader
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"testing"
+
+	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
+	"github.com/c4pt0r/agfs/agfs-server/pkg/plugins/memfs"
+)
+
+// Benchmarks of the WASM plugin call path. They load the BenchFS fixture
+// (examples/hellofs-wasm-cpp/bench) named by AGFS_BENCH_WASM; run them with
+// `make bench` in examples/hellofs-wasm-cpp. Besides ns/op and allocs/op each
+// reports wasm-B/op, the growth of the plugin's linear memory per call.
+
+// benchPlugin is a loaded BenchFS together with what it needs to report memory
+type benchPlugin struct {
+	fs     filesystem.FileSystem
+	loaded *LoadedWASMPlugin
+}
+
+func loadBenchPlugin(b *testing.B) *benchPlugin {
+	b.Helper()
+	wasmPath := os.Getenv("AGFS_BENCH_WASM")
+	if wasmPath == "" {
+		b.Skip("AGFS_BENCH_WASM not set; run `make bench` in examples/hellofs-wasm-cpp")
+	}
+
+	host := memfs.NewMemoryFS()
+	if err := host.Mkdir("/dir", 0755); err != nil {
+		b.Fatal(err)
+	}
+	for i := 0; i < 1000; i++ {
+		if _, err := host.Write(fmt.Sprintf("/dir/f%d", i), nil); err != nil {
+			b.Fatal(err)
+		}
+	}
+	if _, err := host.Write("/file", make([]byte, 64*1024)); err != nil {
+		b.Fatal(err)
+	}
+
+	wl := NewWASMPluginLoader()
+	wl.SetPoolSize(1)
+	p, err := wl.LoadWASMPlugin(wasmPath, host)
+	if err != nil {
+		b.Fatal(err)
+	}
+	absPath, _ := filepath.Abs(wasmPath)
+	b.Cleanup(func() { wl.UnloadWASMPlugin(absPath) })
+
+	if err := p.Initialize(map[string]interface{}{}); err != nil {
+		b.Fatal(err)
+	}
+	return &benchPlugin{fs: p.GetFileSystem(), loaded: wl.loadedPlugins[absPath]}
+}
+
+// memorySize sums the linear memory of every instance
+func (bp *benchPlugin) memorySize() uint64 {
+	var total uint64
+	for _, m := range bp.loaded.Modules {
+		if mem := m.Memory(); mem != nil {
+			total += uint64(mem.Size())
+		}
+	}
+	return total
+}
+
+// run times op b.N times after one warm-up call, reporting memory growth
+func (bp *benchPlugin) run(b *testing.B, op func() error) {
+	b.Helper()
+	if err := op(); err != nil {
+		b.Fatal(err)
+	}
+	before := bp.memorySize()
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if err := op(); err != nil {
+			b.Fatal(err)
+		}
+	}
+	b.StopTimer()
+	b.ReportMetric(float64(bp.memorySize()-before)/float64(b.N), "wasm-B/op")
+}
+
+func BenchmarkWASMPluginStat(b *testing.B) {
+	bp := loadBenchPlugin(b)
+	bp.run(b, func() error {
+		_, err := bp.fs.Stat("/file/1")
+		return err
+	})
+}
+
+func BenchmarkWASMPluginReadDir(b *testing.B) {
+	bp := loadBenchPlugin(b)
+	for _, n := range []int{10, 1000, 100000} {
+		path := fmt.Sprintf("/dir/%d", n)
+		b.Run(fmt.Sprint(n), func(b *testing.B) {
+			bp.run(b, func() error {
+				entries, err := bp.fs.ReadDir(path)
+				if err == nil && len(entries) != n {
+					err = fmt.Errorf("readdir %s: got %d entries", path, len(entries))
+				}
+				return err
+			})
+		})
+	}
+}
+
+func BenchmarkWASMPluginRead(b *testing.B) {
+	bp := loadBenchPlugin(b)
+	for _, size := range []int64{1, 64 * 1024, 16 * 1024 * 1024} {
+		path := fmt.Sprintf("/file/%d", size)
+		b.Run(fmt.Sprint(size), func(b *testing.B) {
+			b.SetBytes(size)
+			bp.run(b, func() error {
+				data, err := bp.fs.Read(path, 0, size)
+				if err == nil && int64(len(data)) != size {
+					err = fmt.Errorf("read %s: got %d bytes", path, len(data))
+				}
+				return err
+			})
+		})
+	}
+}
+
+func BenchmarkWASMPluginWrite(b *testing.B) {
+	bp := loadBenchPlugin(b)
+	data := make([]byte, 4096)
+	b.SetBytes(int64(len(data)))
+	bp.run(b, func() error {
+		_, err := bp.fs.Write("/sink", data)
+		return err
+	})
+}
+
+// BenchmarkWASMPluginHostFS measures calls the plugin forwards to the host
+// filesystem, crossing the boundary in both directions
+func BenchmarkWASMPluginHostFS(b *testing.B) {
+	bp := loadBenchPlugin(b)
+	b.Run("stat", func(b *testing.B) {
+		bp.run(b, func() error {
+			_, err := bp.fs.Stat("/host/file")
+			return err
+		})
+	})
+	b.Run("readdir-1000", func(b *testing.B) {
+		bp.run(b, func() error {
+			_, err := bp.fs.ReadDir("/host/dir")
+			return err
+		})
+	})
+	b.Run("read-65536", func(b *testing.B) {
+		b.SetBytes(64 * 1024)
+		bp.run(b, func() error {
+			_, err := bp.fs.Read("/host/file", 0, 64*1024)
+			return err
+		})
+	})
+	b.Run("write-4096", func(b *testing.B) {
+		data := make([]byte, 4096)
+		b.SetBytes(int64(len(data)))
+		bp.run(b, func() error {
+			_, err := bp.fs.Write("/host/out", data)
+			return err
+		})
+	})
+}
@@ -378,7 +378,7 @@ func (m *memoryReadCloser) Close() error {
 // Open opens a file for reading
 func (mfs *MemoryFS) Open(path string) (io.ReadCloser, error) {
 	data, err := mfs.Read(path, 0, -1)
-	if err != nil {
+	if err != nil && err != io.EOF {
 		return nil, err
 	}
 	return &memoryReadCloser{bytes.NewReader(data)}, nil
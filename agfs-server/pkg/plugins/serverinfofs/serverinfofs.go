@@ -6,10 +6,12 @@ import (
 	"fmt"
 	"io"
 	"runtime"
+	"sync/atomic"
 	"time"
 
 	"github.com/c4pt0r/agfs/agfs-server/pkg/filesystem"
 	"github.com/c4pt0r/agfs/agfs-server/pkg/plugin"
+	"github.com/c4pt0r/agfs/agfs-server/pkg/plugin/api"
 	"github.com/c4pt0r/agfs/agfs-server/pkg/plugin/config"
 )
 
@@ -17,6 +19,10 @@ import (
 type ServerInfoFSPlugin struct {
 	startTime time.Time
 	version   string
+
+	// Size of the last /wasm_metrics read. Sampling the plugins waits on every
+	// WASM instance, so Stat and ReadDir report this instead.
+	wasmMetricsSize atomic.Int64
 }
 
 // NewServerInfoFSPlugin creates a new ServerInfoFS plugin
@@ -73,10 +79,14 @@ USAGE:
   View server info:
     cat /info
 
+  View counters of WASM plugins built with AGFS_METRICS:
+    cat /wasm_metrics
+
 FILES:
   /version  - Server version information
   /uptime   - Server uptime since start
   /info     - Complete server information (JSON)
+  /wasm_metrics - Per-export calls, errors, bytes and latency of WASM plugins (JSON)
   /README   - This file
 
 EXAMPLES:
@@ -114,12 +124,13 @@ const (
 	fileUptime     = "/uptime"
 	fileVersion    = "/version"
 	fileStats      = "/stats"
+	fileWASMStats  = "/wasm_metrics"
 	fileReadme     = "/README"
 )
 
 func (fs *serverInfoFS) isValidPath(path string) bool {
 	switch path {
-	case "/", fileServerInfo, fileUptime, fileVersion, fileStats, fileReadme:
+	case "/", fileServerInfo, fileUptime, fileVersion, fileStats, fileWASMStats, fileReadme:
 		return true
 	default:
 		return false
@@ -191,6 +202,13 @@ func (fs *serverInfoFS) Read(path string, offset int64, size int64) ([]byte, err
 			return nil, err
 		}
 
+	case fileWASMStats:
+		data, err = json.MarshalIndent(api.CollectWASMMetrics(), "", "  ")
+		if err != nil {
+			return nil, err
+		}
+		fs.plugin.wasmMetricsSize.Store(int64(len(data)) + 1) // With the newline below
+
 	case fileReadme:
 		data = []byte(fs.plugin.GetReadme())
 
@@ -281,6 +299,14 @@ func (fs *serverInfoFS) ReadDir(path string) ([]filesystem.FileInfo, error) {
 			IsDir:   false,
 			Meta:    filesystem.MetaData{Name: "serverinfofs", Type: "info"},
 		},
+		{
+			Name:    "wasm_metrics",
+			Size:    fs.plugin.wasmMetricsSize.Load(),
+			Mode:    0444,
+			ModTime: now,
+			IsDir:   false,
+			Meta:    filesystem.MetaData{Name: "serverinfofs", Type: "info"},
+		},
 	}, nil
 }
 
@@ -302,10 +328,17 @@ func (fs *serverInfoFS) Stat(path string) (*filesystem.FileInfo, error) {
 		}, nil
 	}
 
-	// For files, read content to get size
-	data, err := fs.Read(path, 0, -1)
-	if err != nil && err != io.EOF {
-		return nil, err
+	// For files, read content to get size; /wasm_metrics reports the size
+	// of its last read instead of sampling every plugin
+	var size int64
+	if path == fileWASMStats {
+		size = fs.plugin.wasmMetricsSize.Load()
+	} else {
+		data, err := fs.Read(path, 0, -1)
+		if err != nil && err != io.EOF {
+			return nil, err
+		}
+		size = int64(len(data))
 	}
 
 	fileType := "info"
@@ -315,7 +348,7 @@ func (fs *serverInfoFS) Stat(path string) (*filesystem.FileInfo, error) {
 
 	return &filesystem.FileInfo{
 		Name:    path[1:], // Remove leading slash
-		Size:    int64(len(data)),
+		Size:    size,
 		Mode:    0444,
 		ModTime: now,
 		IsDir:   false,